@@ -103,6 +103,8 @@ class ChainyPoller {
 		} else if (msg.consumer_msgs) {
 			document.getElementById("infra").textContent = msg.is_active ? (msg.ip + ";" + msg.app + ";" + msg.component) : "not connected";
 			document.getElementById("consumer_msgs").textContent = msg.consumer_msgs;
+			document.getElementById("item_streams").textContent = msg.item_streams;
+			document.getElementById("item_streams_closed").textContent = msg.item_streams_closed;
 			this.pending_count--;
 		}
 		if (0 == this.pending_count)
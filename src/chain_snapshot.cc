@@ -0,0 +1,199 @@
+/* On-disk snapshot of resolved chains for serving immediately on restart.
+ */
+
+#include "chain_snapshot.hh"
+
+#include <cstring>
+
+#include "chromium/logging.hh"
+
+namespace {
+
+/* Format 1 follows the header with every chain as its name and group count,
+ * each group as a count of names, names as a 16-bit length and the bytes.
+ */
+static const chainy::file_prefix_t kPrefix = { { 'C', 'H', 'A', 'I', 'N', 'Y', 'S', 'S' }, 1 };
+
+/* Minimum encoded sizes: a name is a length and at least one byte, a chain a
+ * name and group count, a group its count.
+ */
+static const size_t kMinNameSize = sizeof (uint16_t) + 1;
+static const size_t kMinChainSize = kMinNameSize + sizeof (uint32_t);
+static const size_t kMinGroupSize = sizeof (uint32_t);
+
+static
+bool
+ReadName (
+	chainy::file_reader_t* reader,
+	chromium::StringPiece* name
+	)
+{
+	uint16_t length;
+	const uint8_t* bytes;
+	if (!reader->ReadValue (&length)
+		|| 0 == length
+		|| !reader->ReadBytes (length, &bytes))
+	{
+		return false;
+	}
+	name->set (reinterpret_cast<const char*> (bytes), length);
+	return true;
+}
+
+static
+bool
+AppendName (
+	const chromium::StringPiece& name,
+	std::string* out
+	)
+{
+	if (name.empty() || name.size() > UINT16_MAX)
+		return false;
+	const uint16_t length = static_cast<uint16_t> (name.size());
+	out->append (reinterpret_cast<const char*> (&length), sizeof (length));
+	out->append (name.data(), name.size());
+	return true;
+}
+
+static
+void
+AppendCount (
+	size_t count,
+	std::string* out
+	)
+{
+	const uint32_t value = static_cast<uint32_t> (count);
+	out->append (reinterpret_cast<const char*> (&value), sizeof (value));
+}
+
+}  // namespace anon
+
+chainy::chain_snapshot_t::chain_snapshot_t (
+	const std::string& path
+	)
+	: path_ (path)
+	, captured_count_ (0)
+{
+}
+
+/* Chains reference the mapping and are only published once the whole file has
+ * parsed, a snapshot of the other flattening is ignored rather than invalid.
+ */
+bool
+chainy::chain_snapshot_t::Open (
+	bool is_flattened
+	)
+{
+	header_t header;
+
+	Close();
+	if (!file_.Open (path_))
+		return false;
+	if (!file_.ReadHeader (kPrefix, &header, sizeof (header)))
+		goto invalid;
+	if ((0 != header.is_flattened) != is_flattened) {
+		LOG(WARNING) << "Ignoring chain snapshot \"" << path_ << "\" taken with " << (is_flattened ? "unflattened" : "flattened") << " chains.";
+		Close();
+		return false;
+	}
+	{
+		file_reader_t reader (file_.data() + sizeof (header), file_.size() - sizeof (header));
+/* bound every count by the remaining file before allocating */
+		if (header.chain_count > reader.remaining() / kMinChainSize)
+			goto invalid;
+		chains_.resize (header.chain_count);
+		for (auto& chain : chains_) {
+			uint32_t group_count;
+			if (!ReadName (&reader, &chain.item_name)
+				|| !reader.ReadValue (&group_count)
+				|| group_count > reader.remaining() / kMinGroupSize)
+			{
+				goto invalid;
+			}
+			chain.groups.resize (group_count);
+			for (auto& group : chain.groups) {
+				uint32_t count;
+				if (!reader.ReadValue (&count)
+					|| count > reader.remaining() / kMinNameSize)
+				{
+					goto invalid;
+				}
+				group.resize (count);
+				for (auto& constituent : group) {
+					if (!ReadName (&reader, &constituent))
+						goto invalid;
+				}
+			}
+		}
+		if (0 != reader.remaining())
+			goto invalid;
+	}
+	return true;
+invalid:
+	LOG(WARNING) << "Ignoring invalid chain snapshot \"" << path_ << "\".";
+	Close();
+	return false;
+}
+
+void
+chainy::chain_snapshot_t::Close()
+{
+	chains_.clear();
+	file_.Close();
+}
+
+void
+chainy::chain_snapshot_t::Clear()
+{
+	captured_.clear();
+	captured_count_ = 0;
+}
+
+bool
+chainy::chain_snapshot_t::Append (
+	const chromium::StringPiece& item_name,
+	const std::vector<std::vector<chromium::StringPiece>>& groups
+	)
+{
+	const size_t length = captured_.size();
+	if (!AppendName (item_name, &captured_))
+		return false;
+	AppendCount (groups.size(), &captured_);
+	for (const auto& group : groups) {
+		AppendCount (group.size(), &captured_);
+		for (const auto& constituent : group) {
+			if (!AppendName (constituent, &captured_)) {
+				captured_.resize (length);
+				return false;
+			}
+		}
+	}
+	++captured_count_;
+	return true;
+}
+
+bool
+chainy::chain_snapshot_t::Commit (
+	bool is_flattened
+	)
+{
+	header_t header;
+	std::vector<chromium::StringPiece> pieces;
+
+	memset (&header, 0, sizeof (header));
+	header.prefix = kPrefix;
+	header.is_flattened = is_flattened ? 1 : 0;
+	header.chain_count = captured_count_;
+	pieces.push_back (chromium::StringPiece (reinterpret_cast<const char*> (&header), sizeof (header)));
+	pieces.push_back (captured_);
+	const bool is_written = CommitFile (path_, pieces);
+	Clear();
+	if (!is_written) {
+		LOG(WARNING) << "Cannot write chain snapshot \"" << path_ << "\".";
+		return false;
+	}
+	LOG(INFO) << "Chain snapshot of " << header.chain_count << " chains written to \"" << path_ << "\".";
+	return true;
+}
+
+/* eof */
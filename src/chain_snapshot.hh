@@ -0,0 +1,79 @@
+/* On-disk snapshot of resolved chains for serving immediately on restart.
+ *
+ * A checkpoint records the constituents of every resolved chain as last
+ * published, grouped per link or as one group when flattening.  The file
+ * starts with a header of the chain count, each chain follows as its name and
+ * groups, every name prefixed by its length in host byte order.  The file is
+ * mapped on load and entries refer into the mapping until closed, a checkpoint
+ * is captured then renamed over the snapshot.
+ */
+
+#ifndef CHAIN_SNAPSHOT_HH_
+#define CHAIN_SNAPSHOT_HH_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+#include "chromium/strings/string_piece.hh"
+#include "mapped_file.hh"
+
+namespace chainy
+{
+
+	class chain_snapshot_t :
+		boost::noncopyable
+	{
+	public:
+		struct chain_t {
+			chromium::StringPiece item_name;
+			std::vector<std::vector<chromium::StringPiece>> groups;
+		};
+
+		explicit chain_snapshot_t (const std::string& path);
+
+/* Map and validate the snapshot file, returns false if absent, invalid, or
+ * checkpointed with a different flattening.
+ */
+		bool Open (bool is_flattened);
+		void Close();
+		bool is_open() const {
+			return file_.is_open();
+		}
+/* Chains of the open snapshot file. */
+		const std::vector<chain_t>& chains() const {
+			return chains_;
+		}
+
+/* Capture of a checkpoint in progress, returns false if a name is too long. */
+		void Clear();
+		bool Append (const chromium::StringPiece& item_name, const std::vector<std::vector<chromium::StringPiece>>& groups);
+		uint32_t captured_count() const {
+			return captured_count_;
+		}
+/* Replace the snapshot file with the captured chains, the capture is cleared. */
+		bool Commit (bool is_flattened);
+
+	private:
+		struct header_t {
+			file_prefix_t prefix;
+			uint32_t is_flattened;
+			uint32_t chain_count;
+		};
+
+		const std::string path_;
+		mapped_file_t file_;
+		std::vector<chain_t> chains_;
+/* Captured chains as encoded for the file. */
+		std::string captured_;
+		uint32_t captured_count_;
+	};
+
+} /* namespace chainy */
+
+#endif /* CHAIN_SNAPSHOT_HH_ */
+
+/* eof */
@@ -0,0 +1,77 @@
+/* Compact store of chain link constituents.
+ */
+
+#include "chain_store.hh"
+
+#include <cstring>
+
+#include "chromium/logging.hh"
+
+
+/* Two passes over the slots: size the arena, then copy each distinct name.
+ */
+chainy::link_image_t::link_image_t (
+	const std::vector<chromium::StringPiece>& slots
+	)
+	: arena_size_ (0)
+	, slices_ (slots.size())
+	, count_ (0)
+{
+	size_t size = 0;
+	for (const auto& slot : slots)
+		size += slot.size();
+	if (size > 0)
+		arena_.reset (new char[size]);
+	for (size_t i = 0; i < slots.size(); ++i) {
+		slice_t& slice = slices_[i];
+		slice.offset = slice.length = 0;
+		if (slots[i].empty())
+			continue;
+		++count_;
+		size_t j = 0;
+		while (j < i && slots[j] != slots[i])
+			++j;
+		if (j < i) {
+			slice = slices_[j];
+			continue;
+		}
+		slice.offset = arena_size_;
+		slice.length = static_cast<uint32_t> (slots[i].size());
+		memcpy (arena_.get() + arena_size_, slots[i].data(), slots[i].size());
+		arena_size_ += slice.length;
+	}
+	DCHECK_LE (arena_size_, size);
+}
+
+bool
+chainy::link_image_t::Equals (
+	const std::vector<chromium::StringPiece>& slots
+	) const
+{
+	if (slots.size() != slices_.size())
+		return false;
+	for (size_t i = 0; i < slots.size(); ++i) {
+		if (slots[i] != (*this)[i])
+			return false;
+	}
+	return true;
+}
+
+void
+chainy::link_image_t::AppendTo (
+	std::vector<chromium::StringPiece>* constituents
+	) const
+{
+	for (size_t i = 0; i < slices_.size(); ++i) {
+		if (0 != slices_[i].length)
+			constituents->push_back ((*this)[i]);
+	}
+}
+
+size_t
+chainy::link_image_t::footprint() const
+{
+	return sizeof (*this) + arena_size_ + slices_.size() * sizeof (slice_t);
+}
+
+/* eof */
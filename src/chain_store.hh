@@ -0,0 +1,63 @@
+/* Compact store of chain link constituents.
+ *
+ * Each link image holds its constituent names back to back in one arena with
+ * an offset and length per link field slot, a name repeated within the link
+ * shares one slice.  Images are immutable once built such that published chain
+ * versions reference them directly and the encoder reads slices in place.
+ */
+
+#ifndef CHAIN_STORE_HH_
+#define CHAIN_STORE_HH_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+#include "chromium/strings/string_piece.hh"
+
+namespace chainy
+{
+
+	class link_image_t :
+		boost::noncopyable
+	{
+	public:
+/* Constituents by link field slot, blank slots are empty. */
+		explicit link_image_t (const std::vector<chromium::StringPiece>& slots);
+
+		size_t slot_count() const {
+			return slices_.size();
+		}
+		chromium::StringPiece operator[] (size_t slot) const {
+			return chromium::StringPiece (arena_.get() + slices_[slot].offset, slices_[slot].length);
+		}
+/* Count of non-blank slots. */
+		size_t size() const {
+			return count_;
+		}
+		bool Equals (const std::vector<chromium::StringPiece>& slots) const;
+/* Non-blank constituents in slot order, valid for the lifetime of the image. */
+		void AppendTo (std::vector<chromium::StringPiece>* constituents) const;
+/* Approximate memory of the image. */
+		size_t footprint() const;
+
+	private:
+		struct slice_t {
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		std::unique_ptr<char[]> arena_;
+		uint32_t arena_size_;
+		std::vector<slice_t> slices_;
+		size_t count_;
+	};
+
+} /* namespace chainy */
+
+#endif /* CHAIN_STORE_HH_ */
+
+/* eof */
@@ -0,0 +1,207 @@
+/* Chain link record layouts resolved against the field dictionary.
+ */
+
+#include "chain_template.hh"
+
+#include <algorithm>
+#include <utility>
+
+#include "chromium/logging.hh"
+#include "chromium/strings/string_number_conversions.hh"
+#include "chromium/strings/string_split.hh"
+
+namespace {
+
+/* Fields are limited to one byte of slot index. */
+static const size_t kMaxSlots = 256;
+
+static
+chainy::chain_layout_t
+MakeLayout (
+	const char* name,
+	const char* constituent_prefix,
+	unsigned first_constituent,
+	unsigned constituent_count,
+	const char* next_link,
+	const char* prev_link,
+	const char* ref_count
+	)
+{
+	chainy::chain_layout_t layout;
+	layout.name = name;
+	for (unsigned i = 0; i < constituent_count; ++i) {
+		std::string acronym (constituent_prefix);
+		acronym.append (chromium::UintToString (first_constituent + i));
+		layout.constituents.push_back (acronym);
+	}
+	layout.next_link = next_link;
+	layout.prev_link = prev_link;
+	layout.ref_count = ref_count;
+	return layout;
+}
+
+static
+std::string
+ParseField (
+	const std::string& token
+	)
+{
+	return "-" == token ? std::string() : token;
+}
+
+}  // namespace anon
+
+const chainy::link_field_t chainy::chain_template_t::kNoField = { LINK_ROLE_NONE, 0 };
+
+chainy::chain_template_t::chain_template_t (
+	const chain_layout_t& layout
+	)
+	: layout_ (layout)
+{
+}
+
+bool
+chainy::chain_template_t::Compile (
+	const std::unordered_map<std::string, RsslFieldId>& fids
+	)
+{
+	std::vector<std::pair<RsslFieldId, link_field_t>> resolved;
+	auto resolve = [&](const std::string& acronym, uint8_t role, uint8_t slot) -> bool {
+		if (acronym.empty())
+			return false;
+		auto it = fids.find (acronym);
+		if (it == fids.end()) {
+			VLOG(1) << "Chain template \"" << layout_.name << "\" field \"" << acronym << "\" not in dictionary.";
+			return false;
+		}
+		const link_field_t field = { role, slot };
+		resolved.push_back (std::make_pair (it->second, field));
+		return true;
+	};
+
+	fields_.clear();
+	bool has_constituent = false;
+	for (size_t slot = 0; slot < layout_.constituents.size(); ++slot) {
+		if (resolve (layout_.constituents[slot], LINK_ROLE_CONSTITUENT, static_cast<uint8_t> (slot)))
+			has_constituent = true;
+	}
+	if (!has_constituent) {
+		LOG(WARNING) << "Chain template \"" << layout_.name << "\" has no constituent fields in dictionary, disabling.";
+		return false;
+	}
+	resolve (layout_.next_link, LINK_ROLE_NEXT_LINK, 0);
+	resolve (layout_.prev_link, LINK_ROLE_PREV_LINK, 0);
+	resolve (layout_.ref_count, LINK_ROLE_REF_COUNT, 0);
+
+	size_t size = 0;
+	for (const auto& field : resolved)
+		size = std::max (size, static_cast<size_t> (static_cast<uint16_t> (field.first)) + 1);
+	fields_.assign (size, kNoField);
+	for (const auto& field : resolved)
+		fields_[static_cast<uint16_t> (field.first)] = field.second;
+	VLOG(1) << "Chain template \"" << layout_.name << "\" compiled with " << resolved.size() << " fields.";
+	return true;
+}
+
+void
+chainy::chain_template_t::CollectFields (
+	field_bitmap_t* bitmap
+	) const
+{
+	for (size_t index = 0; index < fields_.size(); ++index) {
+		if (LINK_ROLE_NONE != fields_[index].role)
+			bitmap->set (static_cast<RsslFieldId> (index));
+	}
+}
+
+/* Built-in layouts, LINK_1 to LINK_14 is the most common and preferred on
+ * a tie.
+ */
+chainy::chain_templates_t::chain_templates_t()
+{
+	templates_.push_back (chain_template_t (MakeLayout ("LINK", "LINK_", 1, 14, "NEXT_LR", "PREV_LR", "REF_COUNT")));
+	templates_.push_back (chain_template_t (MakeLayout ("LONGLINK", "LONGLINK", 1, 14, "LONGNEXTLR", "LONGPREVLR", "REF_COUNT")));
+	templates_.push_back (chain_template_t (MakeLayout ("BR_LINK", "BR_LINK", 1, 15, "BR_NEXTLR", "BR_PREVLR", "")));
+}
+
+bool
+chainy::chain_templates_t::Parse (
+	const std::string& contents
+	)
+{
+	std::vector<std::string> lines;
+	chromium::SplitString (contents, '\n', &lines);
+	for (const auto& line : lines) {
+		if (line.empty() || '#' == line[0])
+			continue;
+		std::vector<std::string> tokens;
+		chromium::SplitStringAlongWhitespace (line, &tokens);
+		if (tokens.size() < 5 || tokens.size() - 4 > kMaxSlots) {
+			LOG(ERROR) << "Malformed chain template \"" << line << "\".";
+			return false;
+		}
+		chain_layout_t layout;
+		layout.name = tokens[0];
+		layout.next_link = ParseField (tokens[1]);
+		layout.prev_link = ParseField (tokens[2]);
+		layout.ref_count = ParseField (tokens[3]);
+		for (auto it = tokens.begin() + 4; it != tokens.end(); ++it)
+			layout.constituents.push_back (ParseField (*it));
+		templates_.push_back (chain_template_t (layout));
+	}
+	return true;
+}
+
+/* Returns count of templates usable with the dictionary. */
+unsigned
+chainy::chain_templates_t::Compile (
+	const RsslDataDictionary& dictionary
+	)
+{
+	std::unordered_map<std::string, RsslFieldId> fids;
+	for (int fid = dictionary.minFid; fid <= dictionary.maxFid; ++fid) {
+		const RsslDictionaryEntry* entry = getDictionaryEntry (&dictionary, fid);
+		if (nullptr == entry)
+			continue;
+		fids.insert (std::make_pair (std::string (entry->acronym.data, entry->acronym.length), entry->fid));
+	}
+	unsigned compiled = 0;
+	fields_.reset();
+	field_list_.clear();
+	for (auto& chain_template : templates_) {
+		if (!chain_template.Compile (fids))
+			continue;
+		chain_template.CollectFields (&fields_);
+		++compiled;
+	}
+	for (int fid = dictionary.minFid; fid <= dictionary.maxFid; ++fid) {
+		if (fields_.test (static_cast<RsslFieldId> (fid)))
+			field_list_.push_back (static_cast<RsslFieldId> (fid));
+	}
+	LOG(INFO) << compiled << " of " << templates_.size() << " chain templates compiled.";
+	return compiled;
+}
+
+int
+chainy::chain_templates_t::Detect (
+	const std::vector<RsslFieldId>& fids
+	) const
+{
+	int best = -1;
+	size_t best_count = 0;
+	for (size_t i = 0; i < templates_.size(); ++i) {
+		const chain_template_t& chain_template = templates_[i];
+		if (!chain_template.is_compiled())
+			continue;
+		const size_t count = std::count_if (fids.begin(), fids.end(), [&chain_template](RsslFieldId fid) {
+			return LINK_ROLE_NONE != chain_template.Lookup (fid).role;
+		});
+		if (count > best_count) {
+			best = static_cast<int> (i);
+			best_count = count;
+		}
+	}
+	return best;
+}
+
+/* eof */
@@ -0,0 +1,124 @@
+/* Chain link record layouts resolved against the field dictionary.
+ *
+ * A layout names the fields of a link record by acronym: constituent slots,
+ * the next and previous link pointers, and the reference count.  Compiling a
+ * layout against a dictionary resolves each acronym to a FID and fills a flat
+ * table indexed by FID, decoding a link record costs one lookup per field.
+ */
+
+#ifndef CHAIN_TEMPLATE_HH_
+#define CHAIN_TEMPLATE_HH_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* UPA 8.0 */
+#include <upa/upa.h>
+
+#include "field_scanner.hh"
+
+namespace chainy
+{
+/* Role of a field within a link record. */
+	enum {
+		LINK_ROLE_NONE,
+		LINK_ROLE_CONSTITUENT,
+		LINK_ROLE_NEXT_LINK,
+		LINK_ROLE_PREV_LINK,
+		LINK_ROLE_REF_COUNT
+	};
+
+	struct link_field_t
+	{
+		uint8_t role;
+/* Constituent slot within the link. */
+		uint8_t slot;
+	};
+
+/* Fields of a chain type by dictionary acronym, empty when not present. */
+	struct chain_layout_t
+	{
+		std::string name;
+		std::vector<std::string> constituents;
+		std::string next_link;
+		std::string prev_link;
+		std::string ref_count;
+	};
+
+	class chain_template_t
+	{
+	public:
+		explicit chain_template_t (const chain_layout_t& layout);
+
+/* Resolve acronyms to FIDs, returns false when no constituent field is
+ * defined by the dictionary.
+ */
+		bool Compile (const std::unordered_map<std::string, RsslFieldId>& fids);
+
+		const link_field_t& Lookup (RsslFieldId fid) const {
+/* negative FIDs index above positive */
+			const uint16_t index = static_cast<uint16_t> (fid);
+			return index < fields_.size() ? fields_[index] : kNoField;
+		}
+		const std::string& name() const {
+			return layout_.name;
+		}
+		unsigned slot_count() const {
+			return static_cast<unsigned> (layout_.constituents.size());
+		}
+		bool is_compiled() const {
+			return !fields_.empty();
+		}
+/* Add every resolved FID to the bitmap. */
+		void CollectFields (field_bitmap_t* bitmap) const;
+
+	private:
+		static const link_field_t kNoField;
+
+		chain_layout_t layout_;
+		std::vector<link_field_t> fields_;
+	};
+
+/* Set of templates, built-in layouts first followed by any configured. */
+	class chain_templates_t
+	{
+	public:
+		explicit chain_templates_t();
+
+/* One layout per line: name, next link, previous link, reference count, then
+ * each constituent field, "-" for an absent field and "#" to comment.
+ */
+		bool Parse (const std::string& contents);
+		unsigned Compile (const RsslDataDictionary& dictionary);
+
+/* Template with most fields present in a link record, -1 if none. */
+		int Detect (const std::vector<RsslFieldId>& fids) const;
+
+/* FIDs used by any compiled template, for scanning link records. */
+		const field_bitmap_t& fields() const {
+			return fields_;
+		}
+/* The same FIDs in ascending order, for upstream views. */
+		const std::vector<RsslFieldId>& field_list() const {
+			return field_list_;
+		}
+		size_t size() const {
+			return templates_.size();
+		}
+		const chain_template_t& operator[] (size_t index) const {
+			return templates_[index];
+		}
+
+	private:
+		std::vector<chain_template_t> templates_;
+		field_bitmap_t fields_;
+		std::vector<RsslFieldId> field_list_;
+	};
+
+} /* namespace chainy */
+
+#endif /* CHAIN_TEMPLATE_HH_ */
+
+/* eof */
@@ -4,19 +4,26 @@
 #include "chainy.hh"
 
 #define __STDC_FORMAT_MACROS
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <inttypes.h>
 
-#include <windows.h>
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#	include <signal.h>
+#endif
 
 /* UPA 8.0 */   
 #include <upa/upa.h>
-#include <rtr/rsslPayloadCache.h>
-#include <rtr/rsslPayloadEntry.h>
 
 #include "chromium/command_line.hh"
 #include "chromium/files/file_util.hh"
 #include "chromium/logging.hh"
+#include "chromium/strings/string_number_conversions.hh"
 #include "chromium/strings/string_split.hh"
 #include "upa.hh"
 #include "upaostream.hh"
@@ -25,31 +32,467 @@
 
 namespace switches {
 
+//   Upstream servers in order of preference, comma separated.
+const char kRsslServers[]		= "rssl-servers";
+
+//   Second upstream session holding every item open for failover.
+const char kWarmStandby[]		= "warm-standby";
+
+//   Upstream connections, chains are partitioned across each.
+const char kConsumerShards[]		= "consumer-shards";
+
+//   Items per upstream batch request.
+const char kRequestBatchSize[]		= "request-batch-size";
+
 //   Symbol map file.
 const char kSymbolPath[]		= "symbol-path";
 
+//   Count of chain links to request ahead of the chain walk.
+const char kLinkPrefetchDepth[]		= "link-prefetch-depth";
+
+//   Repack chain constituents into maximal refresh parts.
+const char kRepackRefresh[]		= "repack-refresh";
+
+//   Levels of chains within chains to expand into one symbol list.
+const char kFlattenDepth[]		= "flatten-depth";
+
+//   Approximate memory of chains opened on demand before eviction.
+const char kChainMemoryLimit[]		= "chain-memory-limit";
+
+//   Additional chain link layouts.
+const char kChainTemplatePath[]		= "chain-template-path";
+
+//   Field dictionary cache file.
+const char kDictionaryCachePath[]	= "dictionary-cache-path";
+
+//   Snapshot file of resolved chains.
+const char kSnapshotPath[]		= "snapshot-path";
+
+//   Seconds between chain snapshot checkpoints.
+const char kSnapshotInterval[]		= "snapshot-interval";
+
+//   Messages read per channel wakeup.
+const char kReadBudget[]		= "read-budget";
+
+//   Microseconds reading per channel wakeup.
+const char kReadBudgetTime[]		= "read-budget-time";
+
+//   Provider worker loops for client sessions.
+const char kProviderShards[]		= "provider-shards";
+
+//   Outbound queue high-water marks per client session.
+const char kClientQueueBytes[]		= "client-queue-bytes";
+const char kClientQueueMsgs[]		= "client-queue-msgs";
+
+//   Seconds above a high-water mark before a slow client is disconnected.
+const char kClientLagTimeout[]		= "client-lag-timeout";
+
 }  // namespace switches
 
 namespace {
 
 static const std::string kErrorMalformedRequest = "Malformed request.";
-static const std::string kErrorNotFound = "Not found in symbol set.";
+static const std::string kErrorNotFound = "Not found.";
 static const std::string kErrorPermData = "Unable to retrieve permission data for item.";
 static const std::string kErrorInternal = "Internal error.";
+static const std::string kErrorEvicted = "Chain evicted, please re-request.";
+
+/* Chain naming convention: the root 0#.SPX is followed by 1#.SPX, 2#.SPX, ...
+ */
+static
+bool
+IsPredictableChain (
+	const std::string& root
+	)
+{
+	return root.size() > 2 && 0 == root.compare (0, 2, "0#");
+}
+
+static
+std::string
+PredictLinkName (
+	const std::string& root,
+	unsigned index
+	)
+{
+	DCHECK (IsPredictableChain (root));
+	std::string link_name (chromium::UintToString (index));
+	link_name.append (root, 1, std::string::npos);
+	return link_name;
+}
+
+/* Encoded refresh varies by RWF version, service id, and the part size when
+ * repacking.
+ */
+static
+uint64_t
+RefreshCacheKey (
+	uint16_t rwf_version,
+	uint16_t service_id,
+	uint32_t max_part_size
+	)
+{
+	return (static_cast<uint64_t> (rwf_version) << 48) | (static_cast<uint64_t> (service_id) << 32) | max_part_size;
+}
+
+/* Replies are encoded straight into channel buffers so reservations are sized
+ * from the payload: message header, key and map header within kReplyOverhead,
+ * plus up to kMapEntryOverhead per symbol for action, flags and length.  An
+ * update falling short carries the remainder in a following update.
+ */
+static const size_t kReplyOverhead = 64;
+static const size_t kMapEntryOverhead = 8;
+
+static
+size_t
+UpdateSizeHint (
+	const std::string& item_name,
+	const chainy::symbol_delta_t& delta,
+	size_t offset
+	)
+{
+	size_t size = kReplyOverhead + item_name.size();
+	for (; offset < delta.size() && size < MAX_MSG_SIZE; ++offset)
+		size += kMapEntryOverhead + delta[offset].second.size();
+	return std::min (size, static_cast<size_t> (MAX_MSG_SIZE));
+}
+
+static
+size_t
+CloseSizeHint (
+	const std::string& item_name,
+	const std::string& status_text
+	)
+{
+	return kReplyOverhead + item_name.size() + status_text.size();
+}
+
+/* Mark an encoded refresh as the final part.
+ */
+static
+bool
+SetRefreshComplete (
+	uint16_t rwf_version,
+	void* data,
+	size_t length
+	)
+{
+#ifndef NDEBUG
+	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+#else
+	RsslEncodeIterator it;
+	rsslClearEncodeIterator (&it);
+#endif
+	RsslBuffer buf = { static_cast<uint32_t> (length), static_cast<char*> (data) };
+	RsslRet rc;
+
+	rc = rsslSetEncodeIteratorBuffer (&it, &buf);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslSetEncodeIteratorBuffer: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	rc = rsslSetEncodeIteratorRWFVersion (&it, chainy::provider_t::rwf_major_version (rwf_version), chainy::provider_t::rwf_minor_version (rwf_version));
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslSetEncodeIteratorRWFVersion: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	rc = rsslSetRefreshCompleteFlag (&it);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslSetRefreshCompleteFlag: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	return true;
+}
+
+/* Re-target a cached encoded refresh at a request token and stream state, an
+ * unsolicited refresh replaces the image of an open stream.
+ */
+static
+bool
+PatchRefresh (
+	uint16_t rwf_version,
+	int32_t token,
+	uint8_t stream_state,
+	bool is_solicited,
+	void* data,
+	size_t length
+	)
+{
+#ifndef NDEBUG
+	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+#else
+	RsslEncodeIterator it;
+	rsslClearEncodeIterator (&it);
+#endif
+	RsslBuffer buf = { static_cast<uint32_t> (length), static_cast<char*> (data) };
+	RsslRet rc;
+
+	rc = rsslSetEncodeIteratorBuffer (&it, &buf);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslSetEncodeIteratorBuffer: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	rc = rsslSetEncodeIteratorRWFVersion (&it, chainy::provider_t::rwf_major_version (rwf_version), chainy::provider_t::rwf_minor_version (rwf_version));
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslSetEncodeIteratorRWFVersion: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	rc = rsslReplaceStreamId (&it, token);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslReplaceStreamId: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"streamId\": " << token << ""
+			" }";
+		return false;
+	}
+	rc = rsslReplaceStreamState (&it, stream_state);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslReplaceStreamState: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"streamState\": " << static_cast<unsigned> (stream_state) << ""
+			" }";
+		return false;
+	}
+	if (!is_solicited) {
+		rc = rsslUnsetSolicitedFlag (&it);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << "rsslUnsetSolicitedFlag: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Reference count constituents of a chain, recording the net change in
+ * membership, a constituent moving between links results in no change.
+ */
+static
+void
+AcquireConstituents (
+	boost::unordered_map<std::string, unsigned>* constituents,
+	const chainy::link_image_t* image,
+	boost::unordered_map<std::string, int>* delta
+	)
+{
+	if (nullptr == image)
+		return;
+	for (size_t i = 0; i < image->slot_count(); ++i) {
+		if ((*image)[i].empty())
+			continue;
+		const std::string ric ((*image)[i].as_string());
+		if (1 == ++(*constituents)[ric])
+			(*delta)[ric]++;
+	}
+}
+
+static
+void
+ReleaseConstituents (
+	boost::unordered_map<std::string, unsigned>* constituents,
+	const chainy::link_image_t* image,
+	boost::unordered_map<std::string, int>* delta
+	)
+{
+	if (nullptr == image)
+		return;
+	for (size_t i = 0; i < image->slot_count(); ++i) {
+		if ((*image)[i].empty())
+			continue;
+		const std::string ric ((*image)[i].as_string());
+		auto it = constituents->find (ric);
+		DCHECK (it != constituents->end());
+		if (it == constituents->end())
+			continue;
+		if (0 == --it->second) {
+			constituents->erase (it);
+			(*delta)[ric]--;
+		}
+	}
+}
+
+/* Approximate memory of a chain as link state and constituent names.
+ */
+static
+size_t
+ChainFootprint (
+	const chainy::chain_version_t& version,
+	size_t link_count
+	)
+{
+	size_t footprint = link_count * sizeof (chainy::subscription_stream_t);
+	for (const auto& link : version.links)
+		footprint += link->footprint();
+	if ((bool)version.expanded) {
+		for (const auto& ric : *version.expanded)
+			footprint += sizeof (std::string) + ric.size();
+	}
+	return footprint;
+}
 
 }  // namespace anon
 
 static std::weak_ptr<chainy::chainy_t> g_application;
 
+chainy::provider_shard_t::provider_shard_t (
+	chainy::chainy_t* chainy,
+	unsigned index
+	)
+	: chainy (chainy)
+	, index (index)
+{
+	memset (cumulative_stats, 0, sizeof (cumulative_stats));
+}
+
+bool
+chainy::provider_shard_t::OnRequest (
+	uintptr_t handle,
+	uint16_t rwf_version,
+	int32_t token,
+	uint16_t service_id,
+	const std::string& item_name,
+	bool use_attribinfo_in_updates,
+	bool is_streaming
+	)
+{
+	return chainy->OnRequest (this, handle, rwf_version, token, service_id, item_name, use_attribinfo_in_updates, is_streaming);
+}
+
+bool
+chainy::provider_shard_t::OnCancel (
+	uintptr_t handle,
+	int32_t token
+	)
+{
+	return chainy->OnCancel (this, handle, token);
+}
+
+chainy::consumer_shard_t::consumer_shard_t (
+	chainy::chainy_t* chainy,
+	unsigned index,
+	const chainy::chain_templates_t& chain_templates
+	)
+	: chainy (chainy)
+	, index (index)
+	, is_synchronized (false)
+	, chain_memory (0)
+	, chain_templates (chain_templates)
+{
+	memset (cumulative_stats, 0, sizeof (cumulative_stats));
+}
+
+bool
+chainy::consumer_shard_t::OnSync()
+{
+	return chainy->OnSync (this);
+}
+
+bool
+chainy::consumer_shard_t::OnWrite (
+	std::shared_ptr<item_stream_t> item_stream,
+	const uint8_t rwf_major_version,
+	const uint8_t rwf_minor_version,
+	RsslMsg* msg
+	)
+{
+	return chainy->OnWrite (this, item_stream, rwf_major_version, rwf_minor_version, msg);
+}
+
+bool
+chainy::consumer_shard_t::OnDictionary (
+	const RsslDataDictionary& dictionary
+	)
+{
+	return chainy->OnDictionary (this, dictionary);
+}
+
+bool
+chainy::consumer_shard_t::OnClose (
+	std::shared_ptr<item_stream_t> item_stream
+	)
+{
+	return chainy->OnClose (this, item_stream);
+}
+
+/* Versions retired whilst read are otherwise only reclaimed by the next
+ * publish, which may never come for an idle chain.
+ */
+void
+chainy::consumer_shard_t::OnIdle()
+{
+	epoch.Reclaim();
+}
+
 chainy::chainy_t::chainy_t()
-	: consumer_shutdown_ (false)
-	, provider_shutdown_ (false)
+	: consumer_running_ (0)
+	, provider_running_ (0)
 	, shutting_down_ (false)
+	, synchronized_count_ (0)
+	, access_sequence_ (0)
+	, versions_reclaimed_ (0)
 {
+	memset (cumulative_stats_, 0, sizeof (cumulative_stats_));
 }
 
 chainy::chainy_t::~chainy_t()
 {
+/* Summary output */
+	VLOG(3) << "Chainy summary: {"
+		 " \"LinksPredicted\": " << cumulative_stats_[CHAINY_PC_LINK_PREDICTED] <<
+		", \"PredictionHits\": " << cumulative_stats_[CHAINY_PC_LINK_PREDICTION_HIT] <<
+		", \"PredictionsDiscarded\": " << cumulative_stats_[CHAINY_PC_LINK_PREDICTION_DISCARDED] <<
+		", \"LinksUnpredicted\": " << cumulative_stats_[CHAINY_PC_LINK_UNPREDICTED] <<
+		", \"LinkCycles\": " << cumulative_stats_[CHAINY_PC_LINK_CYCLE_DETECTED] <<
+		", \"LinksCreated\": " << cumulative_stats_[CHAINY_PC_LINK_CREATED] <<
+		", \"LinksReclaimed\": " << cumulative_stats_[CHAINY_PC_LINK_RECLAIMED] <<
+		", \"ConstituentsAdded\": " << cumulative_stats_[CHAINY_PC_CONSTITUENT_ADDED] <<
+		", \"ConstituentsDeleted\": " << cumulative_stats_[CHAINY_PC_CONSTITUENT_DELETED] <<
+		", \"UpdatesSent\": " << cumulative_stats_[CHAINY_PC_UPDATE_SENT] <<
+		", \"UpdateExceptions\": " << cumulative_stats_[CHAINY_PC_UPDATE_EXCEPTION] <<
+		", \"SubscribersDropped\": " << cumulative_stats_[CHAINY_PC_SUBSCRIBER_DROPPED] <<
+		", \"RefreshCacheHits\": " << cumulative_stats_[CHAINY_PC_REFRESH_CACHE_HIT] <<
+		", \"RefreshCacheMisses\": " << cumulative_stats_[CHAINY_PC_REFRESH_CACHE_MISS] <<
+		", \"VersionsPublished\": " << cumulative_stats_[CHAINY_PC_VERSION_PUBLISHED] <<
+		", \"VersionsReclaimed\": " << versions_reclaimed_ <<
+		", \"SubChainsCreated\": " << cumulative_stats_[CHAINY_PC_SUBCHAIN_CREATED] <<
+		", \"SubChainCycles\": " << cumulative_stats_[CHAINY_PC_SUBCHAIN_CYCLE_DETECTED] <<
+		", \"SubChainDepthExceeded\": " << cumulative_stats_[CHAINY_PC_SUBCHAIN_DEPTH_EXCEEDED] <<
+		", \"ChainsResolved\": " << cumulative_stats_[CHAINY_PC_CHAIN_RESOLVED] <<
+		", \"ChainsNotFound\": " << cumulative_stats_[CHAINY_PC_CHAIN_NOT_FOUND] <<
+		", \"ChainsEvicted\": " << cumulative_stats_[CHAINY_PC_CHAIN_EVICTED] <<
+		", \"RequestsParked\": " << cumulative_stats_[CHAINY_PC_REQUEST_PARKED] <<
+		", \"RequestsCoalesced\": " << cumulative_stats_[CHAINY_PC_REQUEST_COALESCED] <<
+		", \"SnapshotChainsLoaded\": " << cumulative_stats_[CHAINY_PC_SNAPSHOT_LOADED] <<
+		", \"SnapshotChainsReplaced\": " << cumulative_stats_[CHAINY_PC_SNAPSHOT_REPLACED] <<
+		", \"SnapshotsWritten\": " << cumulative_stats_[CHAINY_PC_SNAPSHOT_WRITTEN] <<
+		" }";
 	LOG(INFO) << "fin.";
 }
 
@@ -57,6 +500,22 @@ chainy::chainy_t::~chainy_t()
  * to catch the event by submitting a log event.
  */
 static
+void
+OnShutdownEvent (
+	const char* message
+	)
+{
+	if (!g_application.expired()) {
+		LOG(INFO) << message << "; closing app.";
+		auto sp = g_application.lock();
+		sp->Quit();
+	} else {
+		LOG(WARNING) << message << "; provider already expired.";
+	}
+}
+
+#if defined(_WIN32)
+static
 BOOL
 CtrlHandler (
 	DWORD	fdwCtrlType
@@ -81,38 +540,95 @@ CtrlHandler (
 		message = "Caught shutdown event";
 		break;
 	}
-	if (!g_application.expired()) {
-		LOG(INFO) << message << "; closing app.";
-		auto sp = g_application.lock();
-		sp->Quit();
-	} else {
-		LOG(WARNING) << message << "; provider already expired.";
-	}
+	OnShutdownEvent (message);
 	return TRUE;
 }
-
-int
-chainy::chainy_t::Run()
-{
+#else
+/* Signals are blocked in every thread and accepted synchronously here so the
+ * shutdown path may log and take locks as with the console handler.  SIGUSR1
+ * is raised by Run to retire the thread.
+ */
+static
+void
+SignalHandler (
+	sigset_t	signal_set
+	)
+{
+	for (;;) {
+		int signo;
+		if (0 != sigwait (&signal_set, &signo))
+			continue;
+		switch (signo) {
+		case SIGINT:
+			OnShutdownEvent ("Caught SIGINT");
+			break;
+		case SIGTERM:
+			OnShutdownEvent ("Caught SIGTERM");
+			break;
+		case SIGHUP:
+			OnShutdownEvent ("Caught SIGHUP");
+			break;
+		case SIGUSR1:
+		default:
+			return;
+		}
+	}
+}
+#endif
+
+int
+chainy::chainy_t::Run()
+{
 	int rc = EXIT_SUCCESS;
 	VLOG(1) << "Run as application starting.";
 /* Add shutdown handler. */
 	g_application = shared_from_this();
+#if defined(_WIN32)
 	::SetConsoleCtrlHandler ((PHANDLER_ROUTINE)::CtrlHandler, TRUE);
+#else
+/* Mask before Start so provider and consumer threads inherit it. */
+	sigset_t signal_set, old_set;
+	sigemptyset (&signal_set);
+	sigaddset (&signal_set, SIGINT);
+	sigaddset (&signal_set, SIGTERM);
+	sigaddset (&signal_set, SIGHUP);
+	sigaddset (&signal_set, SIGUSR1);
+	pthread_sigmask (SIG_BLOCK, &signal_set, &old_set);
+	boost::thread signal_thread (::SignalHandler, signal_set);
+#endif
 	if (Start()) {
-/* Wait for mainloop to quit */
-		boost::unique_lock<boost::mutex> provider_lock (provider_lock_);
-		boost::unique_lock<boost::mutex> consumer_lock (consumer_lock_);
-		while (!provider_shutdown_)
-			provider_cond_.wait (provider_lock);
-		while (!consumer_shutdown_)
-			consumer_cond_.wait (consumer_lock);
+/* Wait for mainloop to quit, checkpointing resolved chains meanwhile. */
+		{
+			boost::unique_lock<boost::mutex> provider_lock (provider_lock_);
+			while (provider_running_ > 0) {
+				if (!(bool)snapshot_ || 0 == config_.snapshot_interval) {
+					provider_cond_.wait (provider_lock);
+				} else if (!provider_cond_.timed_wait (provider_lock, boost::posix_time::seconds (config_.snapshot_interval))) {
+					provider_lock.unlock();
+					WriteSnapshot();
+					provider_lock.lock();
+				}
+			}
+		}
+		{
+			boost::unique_lock<boost::mutex> consumer_lock (consumer_lock_);
+			while (consumer_running_ > 0)
+				consumer_cond_.wait (consumer_lock);
+		}
+		if ((bool)snapshot_)
+			WriteSnapshot();
 		Reset();
 	} else {
 		rc = EXIT_FAILURE;
 	}
 /* Remove shutdown handler. */
+#if defined(_WIN32)
 	::SetConsoleCtrlHandler ((PHANDLER_ROUTINE)::CtrlHandler, FALSE);
+#else
+	pthread_kill (signal_thread.native_handle(), SIGUSR1);
+	signal_thread.join();
+	pthread_sigmask (SIG_SETMASK, &old_set, nullptr);
+#endif
 	VLOG(1) << "Run as application finished.";
 	return rc;
 }
@@ -121,13 +637,15 @@ void
 chainy::chainy_t::Quit()
 {
 	shutting_down_ = true;
-	if ((bool)consumer_) {
+	if (!consumer_shards_.empty()) {
 		LOG(INFO) << "Closing consumer.";
-		consumer_->Quit();
+		for (auto& shard : consumer_shards_)
+			shard->consumer->Quit();
 	}
-	if ((bool)provider_) {
+	if (!shards_.empty()) {
 		LOG(INFO) << "Closing provider.";
-		provider_->Quit();
+		for (auto& shard : shards_)
+			shard->provider->Quit();
 	}
 }
 
@@ -144,6 +662,36 @@ chainy::chainy_t::Initialize ()
 /* Configuration. */
 		CommandLine* command_line = CommandLine::ForCurrentProcess();
 
+/* Upstream */
+		if (command_line->HasSwitch (switches::kRsslServers)) {
+			std::vector<std::string> servers, rssl_servers;
+			chromium::SplitString (command_line->GetSwitchValueASCII (switches::kRsslServers), ',', &servers);
+			for (auto it = servers.begin(); it != servers.end(); ++it) {
+				if (!it->empty())
+					rssl_servers.push_back (*it);
+			}
+			if (!rssl_servers.empty())
+				config_.rssl_servers.swap (rssl_servers);
+			else
+				LOG(WARNING) << "Invalid server list, using default \"" << config_.rssl_servers.front() << "\".";
+		}
+		if (command_line->HasSwitch (switches::kWarmStandby))
+			config_.warm_standby = true;
+		if (command_line->HasSwitch (switches::kConsumerShards)) {
+			unsigned consumer_shards;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kConsumerShards), &consumer_shards) && consumer_shards > 0)
+				config_.consumer_shards = consumer_shards;
+			else
+				LOG(WARNING) << "Invalid consumer shard count, using default " << config_.consumer_shards << ".";
+		}
+		if (command_line->HasSwitch (switches::kRequestBatchSize)) {
+			unsigned request_batch_size;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kRequestBatchSize), &request_batch_size) && request_batch_size > 0)
+				config_.request_batch_size = request_batch_size;
+			else
+				LOG(WARNING) << "Invalid request batch size, using default " << config_.request_batch_size << ".";
+		}
+
 /* Symbol list */
 		if (command_line->HasSwitch (switches::kSymbolPath)) {
 			config_.symbol_path = command_line->GetSwitchValueASCII (switches::kSymbolPath);
@@ -157,39 +705,163 @@ chainy::chainy_t::Initialize ()
 			LOG(WARNING) << "No symbol file provided.";
 		}
 
+/* Chain walk */
+		if (command_line->HasSwitch (switches::kLinkPrefetchDepth)) {
+			unsigned link_prefetch_depth;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kLinkPrefetchDepth), &link_prefetch_depth))
+				config_.link_prefetch_depth = link_prefetch_depth;
+			else
+				LOG(WARNING) << "Invalid link prefetch depth, using default " << config_.link_prefetch_depth << ".";
+		}
+		if (command_line->HasSwitch (switches::kRepackRefresh))
+			config_.repack_refresh = true;
+		if (command_line->HasSwitch (switches::kFlattenDepth)) {
+			unsigned flatten_depth;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kFlattenDepth), &flatten_depth))
+				config_.flatten_depth = flatten_depth;
+			else
+				LOG(WARNING) << "Invalid flatten depth, using default " << config_.flatten_depth << ".";
+		}
+		if (command_line->HasSwitch (switches::kChainMemoryLimit)) {
+			size_t chain_memory_limit;
+			if (chromium::StringToSizeT (command_line->GetSwitchValueASCII (switches::kChainMemoryLimit), &chain_memory_limit))
+				config_.chain_memory_limit = chain_memory_limit;
+			else
+				LOG(WARNING) << "Invalid chain memory limit, using default " << config_.chain_memory_limit << ".";
+		}
+/* Sub-chains are shared by chains of any name and cannot follow one partition. */
+		if (config_.flatten_depth > 0 && config_.consumer_shards > 1) {
+			LOG(WARNING) << "Flattening requires a single consumer shard, ignoring consumer shard count " << config_.consumer_shards << ".";
+			config_.consumer_shards = 1;
+		}
+
+/* Read path */
+		if (command_line->HasSwitch (switches::kReadBudget)) {
+			unsigned read_budget;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kReadBudget), &read_budget) && read_budget > 0)
+				config_.read_budget = read_budget;
+			else
+				LOG(WARNING) << "Invalid read budget, using default " << config_.read_budget << ".";
+		}
+		if (command_line->HasSwitch (switches::kReadBudgetTime)) {
+			unsigned read_budget_time;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kReadBudgetTime), &read_budget_time))
+				config_.read_budget_time = read_budget_time;
+			else
+				LOG(WARNING) << "Invalid read budget time, using default " << config_.read_budget_time << ".";
+		}
+
+/* Client sessions */
+		if (command_line->HasSwitch (switches::kProviderShards)) {
+			unsigned provider_shards;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kProviderShards), &provider_shards) && provider_shards > 0)
+				config_.provider_shards = provider_shards;
+			else
+				LOG(WARNING) << "Invalid provider shard count, using default " << config_.provider_shards << ".";
+		}
+		if (command_line->HasSwitch (switches::kClientQueueBytes)) {
+			unsigned client_queue_bytes;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kClientQueueBytes), &client_queue_bytes))
+				config_.client_queue_bytes = client_queue_bytes;
+			else
+				LOG(WARNING) << "Invalid client queue bytes, using default " << config_.client_queue_bytes << ".";
+		}
+		if (command_line->HasSwitch (switches::kClientQueueMsgs)) {
+			unsigned client_queue_msgs;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kClientQueueMsgs), &client_queue_msgs))
+				config_.client_queue_msgs = client_queue_msgs;
+			else
+				LOG(WARNING) << "Invalid client queue messages, using default " << config_.client_queue_msgs << ".";
+		}
+		if (command_line->HasSwitch (switches::kClientLagTimeout)) {
+			unsigned client_lag_timeout;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kClientLagTimeout), &client_lag_timeout))
+				config_.client_lag_timeout = client_lag_timeout;
+			else
+				LOG(WARNING) << "Invalid client lag timeout, using default " << config_.client_lag_timeout << ".";
+		}
+
+/* Chain templates */
+		if (command_line->HasSwitch (switches::kChainTemplatePath)) {
+			config_.chain_template_path = command_line->GetSwitchValueASCII (switches::kChainTemplatePath);
+			std::string contents;
+			if (!file_util::ReadFileToString (config_.chain_template_path, &contents)
+				|| !chain_templates_.Parse (contents))
+			{
+				LOG(ERROR) << "Cannot load chain templates from \"" << config_.chain_template_path << "\".";
+				goto cleanup;
+			}
+			LOG(INFO) << "Chain template set contains " << chain_templates_.size() << " entries.";
+		}
+/* Field dictionary cache */
+		if (command_line->HasSwitch (switches::kDictionaryCachePath))
+			config_.dictionary_cache_path = command_line->GetSwitchValueASCII (switches::kDictionaryCachePath);
+/* Chain snapshot */
+		if (command_line->HasSwitch (switches::kSnapshotPath))
+			config_.snapshot_path = command_line->GetSwitchValueASCII (switches::kSnapshotPath);
+		if (command_line->HasSwitch (switches::kSnapshotInterval)) {
+			unsigned snapshot_interval;
+			if (chromium::StringToUint (command_line->GetSwitchValueASCII (switches::kSnapshotInterval), &snapshot_interval))
+				config_.snapshot_interval = snapshot_interval;
+			else
+				LOG(WARNING) << "Invalid snapshot interval, using default " << config_.snapshot_interval << ".";
+		}
+
 /* UPA context. */
 		upa_.reset (new upa_t (config_));
 		if (!(bool)upa_ || !upa_->Initialize())
 			goto cleanup;
 
-/* UPA provider. */
-		provider_.reset (new provider_t (config_, upa_, static_cast<client_t::Delegate*> (this)));
-		if (!(bool)provider_)
-			goto cleanup;
-
-/* UPA consumer. */
-		consumer_.reset (new consumer_t (config_, upa_, static_cast<consumer_t::Delegate*> (this)));
-		if (!(bool)consumer_ || !consumer_->Initialize())
-			goto cleanup;
+/* UPA provider worker loops. */
+		std::vector<provider_t*> providers;
+		for (unsigned i = 0; i < config_.provider_shards; ++i) {
+			std::unique_ptr<provider_shard_t> shard (new provider_shard_t (this, i));
+			shard->provider.reset (new provider_t (config_, upa_, static_cast<client_t::Delegate*> (shard.get()), i));
+			if (!(bool)shard->provider)
+				goto cleanup;
+			providers.push_back (shard->provider.get());
+			shards_.push_back (std::move (shard));
+		}
+		shards_.front()->provider->SetShards (providers);
+
+/* UPA consumer connections, each with its own login, directory, and dictionary. */
+		for (unsigned i = 0; i < config_.consumer_shards; ++i) {
+			std::unique_ptr<consumer_shard_t> shard (new consumer_shard_t (this, i, chain_templates_));
+			shard->consumer.reset (new consumer_t (config_, upa_, static_cast<consumer_t::Delegate*> (shard.get())));
+			if (!(bool)shard->consumer)
+				goto cleanup;
+			consumer_t* consumer = shard->consumer.get();
+			consumer_shards_.push_back (std::move (shard));
+			if (!consumer->Initialize())
+				goto cleanup;
+		}
 
-		if (!provider_->Initialize (consumer_.get(), consumer_.get()))
-			goto cleanup;
+/* Status pages report the connection of consumer shard zero. */
+		for (auto& shard : shards_) {
+			consumer_t* consumer = consumer_shards_.front()->consumer.get();
+			if (!shard->provider->Initialize (consumer, consumer))
+				goto cleanup;
+		}
 
 /* Create state for subscribed RIC. */
 		for (const auto& instrument : instruments) {
-			if (instrument.empty())
+			if (instrument.empty() || streams_.count (instrument) > 0)
 				continue;
-			auto stream = std::make_shared<subscription_stream_t> ();
-			if (!(bool)stream)
-				return false;
-			stream->links.push_back (stream);
-			if (consumer_->CreateItemStream (instrument.c_str(), stream))
-				streams_.insert (std::make_pair (instrument, stream));
-			else
-				LOG(WARNING) << "Cannot create stream for \"" << instrument << "\".";
+			CreateChain (GetConsumerShard (instrument), instrument);
 			VLOG(1) << instrument;
 		}
 
+/* Serve the last checkpoint whilst chains are walked afresh. */
+		if (!config_.snapshot_path.empty()) {
+			snapshot_.reset (new chain_snapshot_t (config_.snapshot_path));
+			const unsigned loaded = LoadSnapshot();
+			if (loaded > 0) {
+				LOG(INFO) << "Serving " << loaded << " chains from snapshot \"" << config_.snapshot_path << "\" until walked afresh.";
+				for (auto& provider_shard : shards_)
+					provider_shard->provider->SetAcceptingRequests (true);
+			}
+		}
+
 	} catch (const std::exception& e) {
 		LOG(ERROR) << "Upa::Initialisation exception: { "
 			"\"What\": \"" << e.what() << "\" }";
@@ -204,440 +876,1323 @@ cleanup:
 }
 
 bool
-chainy::chainy_t::OnSync()
+chainy::chainy_t::OnSync (
+	consumer_shard_t* shard
+	)
 {
 	DVLOG(3) << "Sync";
 
-	for (auto it : streams_)
 	{
-		auto stream = it.second.get();
-		if (nullptr == stream->payload_entry_handle) {
-			LOG(WARNING) << "Payload entry handle for \"" << it.first << "\" is null.";
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		for (auto it : streams_)
+		{
+			auto stream = it.second.get();
+			if (shard != stream->shard)
+				continue;
+			if (!(bool)stream->image) {
+				LOG(WARNING) << "No link image for \"" << it.first << "\".";
+				continue;
+			}
+			DVLOG(3) << "Sync for \"" << it.first << "\"";
+		}
+	}
+
+/* enable provider only once every consumer shard is synchronised. */
+	if (!shard->is_synchronized) {
+		shard->is_synchronized = true;
+		const unsigned synchronized_count = synchronized_count_.fetch_add (1) + 1;
+		if (synchronized_count < consumer_shards_.size()) {
+			LOG(INFO) << "Consumer shard " << shard->index << " synchronized, " << (consumer_shards_.size() - synchronized_count) << " remaining.";
+		} else {
+			for (auto& provider_shard : shards_)
+				provider_shard->provider->SetAcceptingRequests (true);
+		}
+	}
+	DVLOG(3) << "/Sync";
+	return true;
+}
+
+/* Choose the chain template with most fields present in a link record.
+ *
+ * Returns -1 if no template matches.
+ */
+int
+chainy::chainy_t::DetectTemplate (
+	consumer_shard_t* shard,
+	const std::vector<scanned_field_t>& fields
+	)
+{
+	std::vector<RsslFieldId> fids;
+	fids.reserve (fields.size());
+	for (const auto& field : fields)
+		fids.push_back (field.fid);
+	return shard->chain_templates.Detect (fids);
+}
+
+/* Field dictionary received, resolve chain templates before any link record
+ * is decoded.  Templates keep their position in the set such that chains
+ * retain their detected layout across a dictionary reload.
+ */
+bool
+chainy::chainy_t::OnDictionary (
+	consumer_shard_t* shard,
+	const RsslDataDictionary& dictionary
+	)
+{
+	if (0 == shard->chain_templates.Compile (dictionary)) {
+		LOG(ERROR) << "No chain template is usable with the field dictionary.";
+		return false;
+	}
+/* Links are requested with only the fields of the templates. */
+	shard->consumer->SetView (shard->chain_templates.field_list());
+	return true;
+}
+
+/* A link has refreshed or updated, update symbol-list image for publishing.
+ *
+ * Returns false to abort update processing.
+ */
+
+bool
+chainy::chainy_t::OnWrite (
+	consumer_shard_t* shard,
+	std::shared_ptr<item_stream_t> item_stream,
+	const uint8_t rwf_major_version,
+	const uint8_t rwf_minor_version,
+	RsslMsg* msg
+	)
+{
+	DVLOG(3) << "OnWrite";
+	auto stream = std::static_pointer_cast<subscription_stream_t> (item_stream);
+	const bool is_refresh = RSSL_MC_REFRESH == msg->msgBase.msgClass;
+	boost::unordered_map<std::string, int> delta;
+	bool is_reconciled = false;
+	std::string next_link;
+	bool has_next_link = false;
+	RsslRet rc;
+
+	std::shared_ptr<subscription_stream_t> parent = stream->parent.lock();
+/* in flight on a link of a removed chain */
+	if (!(bool)parent)
+		return true;
+
+/* One pass over the raw field list collects the fields of every compiled
+ * template, all other fields are skipped by length.
+ */
+	shard->link_fields.clear();
+	if (RSSL_DT_FIELD_LIST != msg->msgBase.containerType) {
+		LOG(WARNING) << "Unexpected container type " << static_cast<unsigned> (msg->msgBase.containerType) << " for \"" << stream->item_name << "\", ignoring record.";
+		return true;
+	}
+	rc = ScanFieldList (msg->msgBase.encDataBody, shard->chain_templates.fields(), &shard->link_fields);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "ScanFieldList: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"itemName\": \"" << stream->item_name << "\""
+			" }";
+		return false;
+	}
+
+/* Link layout is detected from the first record seen of the chain. */
+	if (-1 == parent->template_index) {
+		parent->template_index = DetectTemplate (shard, shard->link_fields);
+		if (-1 == parent->template_index) {
+			LOG(WARNING) << "No chain template matches \"" << stream->item_name << "\", ignoring record.";
+			return true;
+		}
+		VLOG(1) << "Chain \"" << parent->item_name << "\" uses template \"" << shard->chain_templates[parent->template_index].name() << "\".";
+	}
+	const chain_template_t& chain_template = shard->chain_templates[parent->template_index];
+
+/* An image replaces all link fields, an update only those present.  Slots
+ * refer to the current image or to the message until a new image is built.
+ */
+	std::vector<chromium::StringPiece> slots (chain_template.slot_count());
+	if (!is_refresh && (bool)stream->image) {
+		for (size_t i = 0; i < slots.size() && i < stream->image->slot_count(); ++i)
+			slots[i] = (*stream->image)[i];
+	}
+
+	for (const auto& entry : shard->link_fields) {
+		const link_field_t& field = chain_template.Lookup (entry.fid);
+		const RsslBuffer& data = entry.data;
+		switch (field.role) {
+		case LINK_ROLE_CONSTITUENT:
+			if (0 == data.length) {
+				VLOG(1) << entry.fid << " = <blank>";
+				slots[field.slot].clear();
+				continue;
+			}
+			VLOG(1) << entry.fid << " = \"" << std::string (data.data, data.length) << "\"";
+			slots[field.slot].set (data.data, data.length);
+			break;
+
+/* next link pointers, a blank pointer marks the final link */
+		case LINK_ROLE_NEXT_LINK:
+			has_next_link = true;
+			if (0 == data.length) {
+				VLOG(1) << "<next link> = <blank>";
+				continue;
+			}
+			VLOG(1) << "<next link> = \"" << std::string (data.data, data.length) << "\"";
+			next_link.assign (data.data, data.length);
+			break;
+
+/* previous link pointer and reference count are not required to walk, other
+ * templates' fields are ignored.
+ */
+		default:
+			break;
+		}
+	}
+
+/* Diff constituents of this link against the previous image. */
+	const bool is_image_changed = !(bool)stream->image || !stream->image->Equals (slots);
+	if (is_image_changed) {
+		std::shared_ptr<const link_image_t> image = std::make_shared<link_image_t> (slots);
+		if (stream->is_published) {
+			ReleaseConstituents (&parent->constituents, stream->image.get(), &delta);
+			AcquireConstituents (&parent->constituents, image.get(), &delta);
+		}
+		stream->image = image;
+	}
+
+/* Follow the chain on a new image or a moved next link pointer. */
+	if (is_refresh
+		|| (has_next_link && next_link != stream->next_link))
+	{
+		const std::vector<std::shared_ptr<subscription_stream_t>> links (parent->links);
+		stream->next_link.swap (next_link);
+		ReconcileLinks (parent);
+		PublishLinks (parent, links, &delta);
+		is_reconciled = true;
+	}
+
+/* Publish the chain image before any membership update such that a request
+ * served in between cannot miss a change.
+ */
+	if (is_image_changed || is_reconciled)
+		PublishVersion (parent);
+
+/* Answer requests parked on the chain once the walk is complete. */
+	if (parent->is_complete && shard->resolving.erase (parent->item_name) > 0)
+		PostChainResolved (parent->item_name);
+
+/* Flattened membership is diffed per version instead. */
+	if (0 == config_.flatten_depth)
+		PostUpdates (parent, delta);
+	return true;
+}
+
+/* Fan out membership changes to streaming requests on every provider thread.
+ *
+ * Returns true if membership changed.
+ */
+bool
+chainy::chainy_t::PostUpdates (
+	std::shared_ptr<subscription_stream_t> parent,
+	const boost::unordered_map<std::string, int>& delta
+	)
+{
+	symbol_delta_t symbol_delta;
+	for (auto it = delta.begin(); it != delta.end(); ++it) {
+		if (it->second > 0) {
+			parent->shard->cumulative_stats[CHAINY_PC_CONSTITUENT_ADDED]++;
+			symbol_delta.push_back (std::make_pair (static_cast<uint8_t> (RSSL_MPEA_ADD_ENTRY), it->first));
+		} else if (it->second < 0) {
+			parent->shard->cumulative_stats[CHAINY_PC_CONSTITUENT_DELETED]++;
+			symbol_delta.push_back (std::make_pair (static_cast<uint8_t> (RSSL_MPEA_DELETE_ENTRY), it->first));
+		}
+	}
+	if (symbol_delta.empty())
+		return false;
+	PostToShards ([this, parent, symbol_delta](provider_shard_t* shard) {
+		SendUpdates (shard, parent, symbol_delta);
+	});
+	return true;
+}
+
+/* Each shard holds its own share of requests on a chain. */
+void
+chainy::chainy_t::PostToShards (
+	const std::function<void (provider_shard_t*)>& task
+	)
+{
+	for (auto& shard : shards_) {
+		provider_shard_t* target = shard.get();
+		target->provider->PostTask ([task, target]() {
+			task (target);
+		});
+	}
+}
+
+/* Swap in an immutable image of the links confirmed by the chain walk,
+ * retiring the previous version until provider readers have moved on.
+ *
+ * When flattening, a change to the expanded constituents is published as an
+ * update and republishes every chain referring to this one, each chain at most
+ * once per change.
+ *
+ * A chain loaded from the snapshot file keeps the snapshot until the walk is
+ * complete, streaming requests then receive the walked image in full.
+ */
+void
+chainy::chainy_t::PublishVersion (
+	std::shared_ptr<subscription_stream_t> parent
+	)
+{
+	std::deque<std::shared_ptr<subscription_stream_t>> pending (1, parent);
+	boost::unordered_set<std::string> visited;
+	while (!pending.empty()) {
+		auto chain = pending.front();
+		pending.pop_front();
+		if (!visited.insert (chain->item_name).second)
+			continue;
+		const chain_version_t* current = chain->version.load();
+		if (nullptr != current && current->is_suspect && !chain->is_complete)
+			continue;
+		auto version = new chain_version_t();
+		version->is_complete = chain->is_complete;
+		for (const auto& link : chain->links) {
+			if (link->is_speculative)
+				break;
+			if ((bool)link->image)
+				version->links.push_back (link->image);
+			else
+				version->links.push_back (std::make_shared<link_image_t> (std::vector<chromium::StringPiece>()));
+		}
+		if (config_.flatten_depth > 0) {
+			auto expanded = std::make_shared<std::vector<std::string>> ();
+			boost::unordered_set<std::string> path, seen;
+			path.insert (chain->item_name);
+			ExpandChain (chain, 0, &path, &seen, expanded.get());
+			version->expanded = expanded;
+		}
+		const size_t footprint = ChainFootprint (*version, chain->links.size());
+		chain->shard->chain_memory -= chain->footprint;
+		chain->shard->chain_memory += footprint;
+		chain->footprint = footprint;
+		chain->shard->cumulative_stats[CHAINY_PC_VERSION_PUBLISHED]++;
+		chain_version_t* previous = chain->version.exchange (version);
+		const bool is_snapshot_replaced = nullptr != previous && previous->is_suspect;
+		bool is_changed = false;
+		if (config_.flatten_depth > 0) {
+			boost::unordered_map<std::string, int> delta;
+			if (nullptr != previous && (bool)previous->expanded) {
+				is_changed = *previous->expanded != *version->expanded;
+				for (const auto& ric : *previous->expanded)
+					delta[ric]--;
+			}
+			for (const auto& ric : *version->expanded)
+				delta[ric]++;
+			if (!is_snapshot_replaced)
+				PostUpdates (chain, delta);
+		}
+		if (is_snapshot_replaced) {
+			chain->shard->cumulative_stats[CHAINY_PC_SNAPSHOT_REPLACED]++;
+			PostToShards ([this, chain](provider_shard_t* shard) {
+				RefreshSubscribers (shard, chain);
+			});
+		}
+		if (nullptr != previous)
+			chain->shard->epoch.Retire ([previous]() { delete previous; });
+		if (!is_changed)
 			continue;
+/* stale references cost only an unchanged republish */
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		for (const auto& referrer : chain->referrers) {
+			auto search = streams_.find (referrer);
+			if (search != streams_.end())
+				pending.push_back (search->second);
 		}
-		DVLOG(3) << "Sync for \"" << it.first << "\"";
 	}
-
-/* enable provider only with synchronised consumer. */
-	provider_->SetAcceptingRequests (true);
-	DVLOG(3) << "/Sync";
-	return true;
+}
+
+/* Chains are partitioned across consumer shards by root name such that every
+ * link of a chain is walked on one connection.
+ */
+chainy::consumer_shard_t*
+chainy::chainy_t::GetConsumerShard (
+	const std::string& item_name
+	)
+{
+	const size_t hash = boost::hash<std::string>() (item_name);
+	return consumer_shards_[hash % consumer_shards_.size()].get();
+}
+
+/* Subscribe to the root of a chain, predicted links are requested in parallel
+ * with the root.  The chain is visible to requests once it has a version.
+ */
+std::shared_ptr<chainy::subscription_stream_t>
+chainy::chainy_t::CreateChain (
+	consumer_shard_t* shard,
+	const std::string& item_name
+	)
+{
+	auto stream = std::make_shared<subscription_stream_t> ();
+	if (!(bool)stream)
+		return stream;
+	stream->shard = shard;
+	stream->parent = stream;
+	stream->links.push_back (stream);
+	stream->subscribers.resize (shards_.size());
+	stream->is_predictable = (config_.link_prefetch_depth > 0) && IsPredictableChain (item_name);
+	if (!shard->consumer->CreateItemStream (item_name.c_str(), stream)) {
+		LOG(WARNING) << "Cannot create stream for \"" << item_name << "\".";
+		stream.reset();
+		return stream;
+	}
+	ReconcileLinks (stream);
+	PublishVersion (stream);
+	boost::lock_guard<boost::shared_mutex> lock (streams_lock_);
+	streams_.insert (std::make_pair (item_name, stream));
+	return stream;
+}
+
+/* Append the constituents of a chain to a flattened symbol list, constituents
+ * following the 0# naming convention are replaced by their own constituents.
+ * A sub-chain is subscribed once and shared by every chain expanding it, the
+ * expanding chain is recorded such that a change to the sub-chain republishes
+ * it.  Chains beyond the depth limit remain as plain constituents, a chain
+ * already being expanded contributes nothing.
+ */
+void
+chainy::chainy_t::ExpandChain (
+	std::shared_ptr<subscription_stream_t> chain,
+	unsigned depth,
+	boost::unordered_set<std::string>* path,
+	boost::unordered_set<std::string>* seen,
+	std::vector<std::string>* expanded
+	)
+{
+	for (const auto& link : chain->links) {
+		if (link->is_speculative)
+			break;
+		if (!(bool)link->image)
+			continue;
+		for (size_t i = 0; i < link->image->slot_count(); ++i) {
+			if ((*link->image)[i].empty())
+				continue;
+			const std::string ric ((*link->image)[i].as_string());
+			if (IsPredictableChain (ric)) {
+				if (depth >= config_.flatten_depth) {
+					chain->shard->cumulative_stats[CHAINY_PC_SUBCHAIN_DEPTH_EXCEEDED]++;
+				} else if (path->count (ric) > 0) {
+					chain->shard->cumulative_stats[CHAINY_PC_SUBCHAIN_CYCLE_DETECTED]++;
+					LOG(WARNING) << "Constituent \"" << ric << "\" of \"" << chain->item_name << "\" forms a cycle of chains.";
+					continue;
+				} else {
+					std::shared_ptr<subscription_stream_t> sub_chain;
+					{
+						boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+						auto search = streams_.find (ric);
+						if (search != streams_.end())
+							sub_chain = search->second;
+					}
+					if (!(bool)sub_chain) {
+						VLOG(2) << "Expanding sub-chain \"" << ric << "\" of \"" << chain->item_name << "\".";
+						sub_chain = CreateChain (chain->shard, ric);
+						if ((bool)sub_chain) {
+							chain->shard->cumulative_stats[CHAINY_PC_SUBCHAIN_CREATED]++;
+							sub_chain->is_on_demand = true;
+						}
+					}
+					if ((bool)sub_chain) {
+						sub_chain->referrers.insert (chain->item_name);
+						path->insert (ric);
+						ExpandChain (sub_chain, depth + 1, path, seen, expanded);
+						path->erase (ric);
+						continue;
+					}
+				}
+			}
+			if (seen->insert (ric).second)
+				expanded->push_back (ric);
+		}
+	}
+}
+
+/* Subscribe to a link of a chain, speculative links are requested ahead of
+ * confirmation from the preceding link.
+ */
+std::shared_ptr<chainy::subscription_stream_t>
+chainy::chainy_t::CreateLink (
+	std::shared_ptr<subscription_stream_t> parent,
+	const std::string& link_name,
+	bool is_speculative
+	)
+{
+	auto link = std::make_shared<subscription_stream_t> ();
+	if (!(bool)link)
+		return link;
+	link->shard = parent->shard;
+	link->parent = parent;
+	link->is_speculative = is_speculative;
+	if (!link->shard->consumer->CreateItemStream (link_name.c_str(), link)) {
+		LOG(WARNING) << "Cannot create stream for \"" << link_name << "\".";
+		link.reset();
+		return link;
+	}
+	link->shard->cumulative_stats[CHAINY_PC_LINK_CREATED]++;
+	return link;
+}
+
+void
+chainy::chainy_t::CloseLink (
+	std::shared_ptr<subscription_stream_t> link
+	)
+{
+	VLOG(2) << "Closing " << (link->is_speculative ? "predicted " : "") << "link \"" << link->item_name << "\".";
+	if (link->is_speculative)
+		link->shard->cumulative_stats[CHAINY_PC_LINK_PREDICTION_DISCARDED]++;
+	link->shard->cumulative_stats[CHAINY_PC_LINK_RECLAIMED]++;
+/* upstream close, token, and last value cache, memory follows the last reference */
+	link->shard->consumer->CloseItemStream (link);
+}
+
+/* Walk the chain from the root following each next link pointer.  Predicted
+ * links are adopted when named by a pointer irrespective of the position they
+ * were requested for, links not yet requested are requested, and further
+ * predictions are requested ahead of the last confirmed link.  Links outside
+ * the walk are closed once the final link has been seen, until then they are
+ * retained as outstanding predictions.
+ */
+void
+chainy::chainy_t::ReconcileLinks (
+	std::shared_ptr<subscription_stream_t> parent
+	)
+{
+	std::vector<std::shared_ptr<subscription_stream_t>> links;
+	boost::unordered_map<std::string, std::shared_ptr<subscription_stream_t>> pool;
+	boost::unordered_set<std::string> names;
+	bool is_complete = false;
+
+	for (auto it = std::next (parent->links.begin()); it != parent->links.end(); ++it)
+		pool.emplace ((*it)->item_name, *it);
+
+	links.push_back (parent);
+	names.insert (parent->item_name);
+	for (auto link = parent;;) {
+/* next link pointer unknown until a refresh is received, a link closed
+ * upstream beforehand ends the walk early.
+ */
+		if (0 == link->refresh_received) {
+			is_complete = link->is_closed;
+			break;
+		}
+		if (link->next_link.empty()) {
+			is_complete = true;
+			break;
+		}
+		const std::string& link_name = link->next_link;
+		if (!names.insert (link_name).second) {
+			parent->shard->cumulative_stats[CHAINY_PC_LINK_CYCLE_DETECTED]++;
+			LOG(WARNING) << "Next link \"" << link_name << "\" of \"" << link->item_name << "\" forms a cycle in chain \"" << parent->item_name << "\".";
+			is_complete = true;
+			break;
+		}
+		std::shared_ptr<subscription_stream_t> next_link;
+		auto search = pool.find (link_name);
+		if (search != pool.end()) {
+			next_link = search->second;
+			pool.erase (search);
+			if (next_link->is_speculative) {
+				parent->shard->cumulative_stats[CHAINY_PC_LINK_PREDICTION_HIT]++;
+				next_link->is_speculative = false;
+			}
+		} else {
+			if (parent->is_predictable) {
+				parent->shard->cumulative_stats[CHAINY_PC_LINK_UNPREDICTED]++;
+				LOG(INFO) << "Chain \"" << parent->item_name << "\" does not follow naming convention at \"" << link_name << "\", disabling link prediction.";
+				parent->is_predictable = false;
+			}
+			next_link = CreateLink (parent, link_name, false);
+			if (!(bool)next_link)
+				break;
+		}
+		next_link->index = static_cast<unsigned> (links.size());
+		links.push_back (next_link);
+		link = next_link;
+	}
+
+	if (is_complete) {
+/* drop links beyond the final link */
+		for (auto it = pool.begin(); it != pool.end(); ++it)
+			CloseLink (it->second);
+	} else {
+/* retain outstanding links in original order */
+		for (auto it = std::next (parent->links.begin()); it != parent->links.end(); ++it) {
+			if (0 == pool.count ((*it)->item_name))
+				continue;
+			(*it)->is_speculative = true;
+			(*it)->index = static_cast<unsigned> (links.size());
+			links.push_back (*it);
+			names.insert ((*it)->item_name);
+		}
+/* request ahead of the walk */
+		if (parent->is_predictable) {
+			const unsigned confirmed = static_cast<unsigned> (links.size() - pool.size());
+			for (unsigned index = confirmed; index < confirmed + config_.link_prefetch_depth; ++index) {
+				const std::string link_name (PredictLinkName (parent->item_name, index));
+				if (!names.insert (link_name).second)
+					continue;
+				auto link = CreateLink (parent, link_name, true);
+				if (!(bool)link)
+					break;
+				parent->shard->cumulative_stats[CHAINY_PC_LINK_PREDICTED]++;
+				link->index = static_cast<unsigned> (links.size());
+				links.push_back (link);
+			}
+		}
+	}
+
+	parent->links.swap (links);
+	parent->is_complete = is_complete;
+}
+
+/* Count constituents of links confirmed by the chain walk, links demoted to
+ * speculative or closed no longer contribute.  Links new to the chain have no
+ * constituents until their first image.
+ */
+void
+chainy::chainy_t::PublishLinks (
+	std::shared_ptr<subscription_stream_t> parent,
+	const std::vector<std::shared_ptr<subscription_stream_t>>& links,
+	boost::unordered_map<std::string, int>* delta
+	)
+{
+	for (const auto& link : links) {
+		const bool is_published = !link->is_speculative && -1 != link->token;
+		if (is_published == link->is_published)
+			continue;
+		link->is_published = is_published;
+		if (is_published)
+			AcquireConstituents (&parent->constituents, link->image.get(), delta);
+		else
+			ReleaseConstituents (&parent->constituents, link->image.get(), delta);
+	}
+}
+
+/* Provider thread: publish membership changes to every streaming request of
+ * the shard on the chain.  A request issued after the change was cached may
+ * receive an ADD for a constituent already in its image, which is permitted.
+ */
+void
+chainy::chainy_t::SendUpdates (
+	provider_shard_t* shard,
+	std::shared_ptr<subscription_stream_t> parent,
+	const symbol_delta_t& delta
+	)
+{
+	auto& subscribers = parent->subscribers[shard->index];
+	const size_t subscriber_count = subscribers.size();
+	auto it = subscribers.begin();
+	while (it != subscribers.end()) {
+		const subscriber_t& subscriber = it->second;
+		auto client = shard->provider->GetClient (reinterpret_cast<RsslChannel*> (subscriber.handle));
+		bool is_open = (bool)client;
+		for (size_t offset = 0; is_open && offset < delta.size();) {
+			RsslBuffer* buf = client->GetReplyBuffer (UpdateSizeHint (parent->item_name, delta, offset));
+			if (nullptr == buf) {
+				is_open = false;
+				break;
+			}
+			size_t length = buf->length;
+			if (!WriteRawUpdate (subscriber.rwf_version,
+					subscriber.token,
+					subscriber.service_id,
+					parent->item_name,
+					subscriber.use_attribinfo_in_updates,
+					delta, &offset,
+					buf->data,
+					&length))
+			{
+				client->ReleaseReplyBuffer (buf);
+				shard->cumulative_stats[CHAINY_PC_UPDATE_EXCEPTION]++;
+				SendClose (shard, parent->item_name, subscriber, RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_ERROR, kErrorInternal);
+				is_open = false;
+				break;
+			}
+			buf->length = static_cast<uint32_t> (length);
+			if (!client->SubmitReply (subscriber.token, buf)) {
+				is_open = false;
+				break;
+			}
+			shard->cumulative_stats[CHAINY_PC_UPDATE_SENT]++;
+		}
+		if (is_open) {
+			++it;
+			continue;
+		}
+/* client session lost or stream closed in error */
+		shard->cumulative_stats[CHAINY_PC_SUBSCRIBER_DROPPED]++;
+		LOG(INFO) << "Dropping streaming request " << subscriber.token << " on \"" << parent->item_name << "\".";
+		shard->subscriptions.erase (it->first);
+		it = subscribers.erase (it);
+	}
+	parent->subscriber_count.fetch_sub (subscriber_count - subscribers.size());
+}
+
+/* Provider thread: replace the image of every streaming request of the shard
+ * on the chain with an unsolicited refresh of the current version.
+ */
+void
+chainy::chainy_t::RefreshSubscribers (
+	provider_shard_t* shard,
+	std::shared_ptr<subscription_stream_t> chain
+	)
+{
+	auto& subscribers = chain->subscribers[shard->index];
+	const size_t subscriber_count = subscribers.size();
+	auto it = subscribers.begin();
+	while (it != subscribers.end()) {
+/* re-registers the existing entry in place */
+		if (SendRefresh (shard, chain, it->second, true /* streaming */, false /* unsolicited */)) {
+			++it;
+			continue;
+		}
+		shard->cumulative_stats[CHAINY_PC_SUBSCRIBER_DROPPED]++;
+		LOG(INFO) << "Dropping streaming request " << it->second.token << " on \"" << chain->item_name << "\".";
+		shard->subscriptions.erase (it->first);
+		it = subscribers.erase (it);
+	}
+	chain->subscriber_count.fetch_sub (subscriber_count - subscribers.size());
+}
+
+/* Consumer thread: open a chain requested by name.  Parked requests are
+ * answered once the chain walk is complete or the root is closed upstream.
+ */
+void
+chainy::chainy_t::ResolveChain (
+	consumer_shard_t* shard,
+	const std::string& item_name
+	)
+{
+	std::shared_ptr<subscription_stream_t> stream;
+	{
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		auto search = streams_.find (item_name);
+		if (search != streams_.end())
+			stream = search->second;
+	}
+	if ((bool)stream) {
+/* opened meanwhile, e.g. as a sub-chain */
+		if (stream->is_complete) {
+			PostChainResolved (item_name);
+		} else {
+			shard->resolving.insert (item_name);
+		}
+		return;
+	}
+	auto chain = CreateChain (shard, item_name);
+	if (!(bool)chain) {
+		PostChainResolved (item_name);
+		return;
+	}
+	VLOG(1) << "Resolving chain \"" << item_name << "\" on demand.";
+	shard->cumulative_stats[CHAINY_PC_CHAIN_RESOLVED]++;
+	chain->is_on_demand = true;
+	chain->last_access.store (access_sequence_.fetch_add (1));
+	shard->resolving.insert (item_name);
+	EvictChains (shard);
+}
+
+/* Provider thread: open a chain on its consumer shard once however many
+ * provider shards park requests on it.
+ */
+void
+chainy::chainy_t::PostResolveChain (
+	const std::string& item_name
+	)
+{
+	{
+		boost::lock_guard<boost::mutex> lock (requested_lock_);
+		if (!requested_.insert (item_name).second)
+			return;
+	}
+	consumer_shard_t* target = GetConsumerShard (item_name);
+	target->consumer->PostTask ([this, target, item_name]() {
+		ResolveChain (target, item_name);
+	});
+}
+
+/* Requests on a chain may be parked by any shard.  A request parked after the
+ * name is withdrawn posts a fresh resolution which answers at once.
+ */
+void
+chainy::chainy_t::PostChainResolved (
+	const std::string& item_name
+	)
+{
+	{
+		boost::lock_guard<boost::mutex> lock (requested_lock_);
+		requested_.erase (item_name);
+	}
+	PostToShards ([this, item_name](provider_shard_t* shard) {
+		OnChainResolved (shard, item_name);
+	});
+}
+
+/* Provider thread: answer every request of the shard parked on a chain, a
+ * chain no longer present was not found upstream.
+ */
+void
+chainy::chainy_t::OnChainResolved (
+	provider_shard_t* shard,
+	const std::string& item_name
+	)
+{
+	auto parked = shard->parked.find (item_name);
+	if (parked == shard->parked.end())
+		return;
+	std::vector<request_t> requests;
+	requests.swap (parked->second);
+	shard->parked.erase (parked);
+	std::shared_ptr<subscription_stream_t> stream;
+	{
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		auto search = streams_.find (item_name);
+		if (search != streams_.end())
+			stream = search->second;
+	}
+	if (!(bool)stream) {
+		shard->cumulative_stats[CHAINY_PC_CHAIN_NOT_FOUND]++;
+		LOG(INFO) << "Closing resource not found for \"" << item_name << "\"";
+	}
+	for (const auto& request : requests) {
+		if ((bool)stream)
+			SendRefresh (shard, stream, request.subscriber, request.is_streaming, true /* solicited */);
+		else
+			SendClose (shard, item_name, request.subscriber, RSSL_STREAM_CLOSED, RSSL_SC_NOT_FOUND, kErrorNotFound);
+	}
+}
+
+/* A chain being resolved is withdrawn when its root is closed upstream, a
+ * closed link ends the walk early and the chain is published as it stands.
+ */
+bool
+chainy::chainy_t::OnClose (
+	consumer_shard_t* shard,
+	std::shared_ptr<item_stream_t> item_stream
+	)
+{
+	auto stream = std::static_pointer_cast<subscription_stream_t> (item_stream);
+	LOG(INFO) << "Stream closed upstream for \"" << stream->item_name << "\".";
+	std::shared_ptr<subscription_stream_t> parent = stream->parent.lock();
+	if (!(bool)parent)
+		return true;
+	if (stream == parent && shard->resolving.erase (parent->item_name) > 0) {
+		const std::string item_name (parent->item_name);
+		RemoveChain (parent);
+		PostChainResolved (item_name);
+		return true;
+	}
+	boost::unordered_map<std::string, int> delta;
+	const std::vector<std::shared_ptr<subscription_stream_t>> links (parent->links);
+	ReconcileLinks (parent);
+	PublishLinks (parent, links, &delta);
+	PublishVersion (parent);
+	if (parent->is_complete && shard->resolving.erase (parent->item_name) > 0)
+		PostChainResolved (parent->item_name);
+	if (0 == config_.flatten_depth)
+		PostUpdates (parent, delta);
+	return true;
+}
+
+/* Close every stream of a chain upstream and withdraw it from new requests. */
+void
+chainy::chainy_t::RemoveChain (
+	std::shared_ptr<subscription_stream_t> chain
+	)
+{
+	{
+		boost::lock_guard<boost::shared_mutex> lock (streams_lock_);
+		streams_.erase (chain->item_name);
+	}
+	for (auto it = std::next (chain->links.begin()); it != chain->links.end(); ++it)
+		CloseLink (*it);
+	chain->shard->consumer->CloseItemStream (chain);
+	chain->shard->chain_memory -= chain->footprint;
+	chain->footprint = 0;
+/* release the self reference of the root */
+	chain->links.clear();
+}
+
+/* Evict the least recently requested idle chains opened on demand until
+ * the approximate memory falls below a low water mark.  Chains with streaming
+ * requests, expanded by another chain, or still resolving are retained.  Each
+ * consumer shard is held to an equal share of the limit.
+ */
+void
+chainy::chainy_t::EvictChains (
+	consumer_shard_t* shard
+	)
+{
+	if (0 == config_.chain_memory_limit)
+		return;
+	const size_t chain_memory_limit = std::max<size_t> (1, config_.chain_memory_limit / consumer_shards_.size());
+	if (shard->chain_memory <= chain_memory_limit)
+		return;
+	const size_t low_water_mark = chain_memory_limit - chain_memory_limit / 8;
+/* snapshot access order, the provider thread continues to update it */
+	std::vector<std::pair<uint64_t, std::shared_ptr<subscription_stream_t>>> candidates;
+	{
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+			const auto& chain = it->second;
+			if (shard != chain->shard
+				|| !chain->is_on_demand
+				|| !chain->referrers.empty()
+				|| 0 != chain->subscriber_count.load()
+				|| 0 != shard->resolving.count (it->first))
+			{
+				continue;
+			}
+			candidates.push_back (std::make_pair (chain->last_access.load(), chain));
+		}
+	}
+	std::sort (candidates.begin(), candidates.end(),
+		[](const std::pair<uint64_t, std::shared_ptr<subscription_stream_t>>& lhs,
+		   const std::pair<uint64_t, std::shared_ptr<subscription_stream_t>>& rhs)
+		{
+			return lhs.first < rhs.first;
+		});
+	boost::unordered_set<std::string> evicted;
+	for (const auto& candidate : candidates) {
+		if (shard->chain_memory <= low_water_mark)
+			break;
+		auto chain = candidate.second;
+		VLOG(1) << "Evicting idle chain \"" << chain->item_name << "\".";
+		shard->cumulative_stats[CHAINY_PC_CHAIN_EVICTED]++;
+		evicted.insert (chain->item_name);
+		RemoveChain (chain);
+/* a request may have subscribed since the snapshot */
+		PostToShards ([this, chain](provider_shard_t* shard) {
+			DropChain (shard, chain);
+		});
+	}
+	if (evicted.empty())
+		return;
+/* sub-chains no longer expanded become candidates themselves */
+	boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+	for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+		if (shard != it->second->shard)
+			continue;
+		for (const auto& item_name : evicted)
+			it->second->referrers.erase (item_name);
+	}
+}
+
+/* Provider thread: close streaming requests of the shard on an evicted chain,
+ * clients may re-request and resolve the chain afresh.
+ */
+void
+chainy::chainy_t::DropChain (
+	provider_shard_t* shard,
+	std::shared_ptr<subscription_stream_t> chain
+	)
+{
+	auto& subscribers = chain->subscribers[shard->index];
+	for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+		shard->cumulative_stats[CHAINY_PC_SUBSCRIBER_DROPPED]++;
+		SendClose (shard, chain->item_name, it->second, RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_NONE, kErrorEvicted);
+		shard->subscriptions.erase (it->first);
+	}
+	chain->subscriber_count.fetch_sub (subscribers.size());
+	subscribers.clear();
+}
+
+bool
+chainy::chainy_t::OnRequest (
+	provider_shard_t* shard,
+	uintptr_t handle,
+	uint16_t rwf_version, 
+	int32_t token,
+	uint16_t service_id,
+	const std::string& item_name,
+	bool use_attribinfo_in_updates,
+	bool is_streaming
+	)
+{
+	DVLOG(3) << "Request: { "
+		  "\"handle\": " << handle << ""
+		", \"rwf_version\": " << rwf_version << ""
+		", \"token\": " << token << ""
+		", \"service_id\": " << service_id << ""
+		", \"item_name\": \"" << item_name << "\""
+		", \"use_attribinfo_in_updates\": " << (use_attribinfo_in_updates ? "true" : "false") << ""
+		", \"is_streaming\": " << (is_streaming ? "true" : "false") << ""
+		" }";
+	const subscriber_t subscriber = { handle, rwf_version, token, service_id, use_attribinfo_in_updates };
+	const request_t request = { subscriber, is_streaming };
+/* Coalesce with an in-flight resolution of the same chain. */
+	auto parked = shard->parked.find (item_name);
+	if (parked != shard->parked.end()) {
+		shard->cumulative_stats[CHAINY_PC_REQUEST_COALESCED]++;
+		parked->second.push_back (request);
+		return true;
+	}
+/* Validate symbol */
+	std::shared_ptr<subscription_stream_t> stream;
+	{
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		auto search = streams_.find (item_name);
+		if (search != streams_.end())
+			stream = search->second;
+	}
+/* A chain still being walked, e.g. opened by another shard or as a sub-chain,
+ * is answered once complete unless served from the snapshot.
+ */
+	bool is_ready = false;
+	if ((bool)stream) {
+		epoch_t::guard_t guard (stream->shard->epoch);
+		const chain_version_t* version = stream->version.load();
+		is_ready = version->is_complete || version->is_suspect;
+	}
+	if (!is_ready) {
+/* Open upstream on the consumer shard of the chain, answered once the chain is walked. */
+		shard->cumulative_stats[CHAINY_PC_REQUEST_PARKED]++;
+		shard->parked[item_name].push_back (request);
+		PostResolveChain (item_name);
+		return true;
+	}
+	return SendRefresh (shard, stream, subscriber, is_streaming, true /* solicited */);
 }
 
 bool
-chainy::chainy_t::OnTrigger()
+chainy::chainy_t::SendRefresh (
+	provider_shard_t* shard,
+	std::shared_ptr<subscription_stream_t> stream,
+	const subscriber_t& subscriber,
+	bool is_streaming,
+	bool is_solicited
+	)
 {
-	LOG(INFO) << "Trigger";
+	const std::string& item_name = stream->item_name;
+	const uint16_t rwf_version = subscriber.rwf_version;
+	const int32_t token = subscriber.token;
+	const uint16_t service_id = subscriber.service_id;
 
-	for (auto it : streams_)
-	{
-		auto stream = it.second.get();
-		if (nullptr == stream->payload_entry_handle) {
-			LOG(WARNING) << "Payload entry handle for \"" << it.first << "\" is null.";
-			continue;
-		}
-		if (0 != stream->snapshot_handle.load()) {
-			LOG(INFO) << "Snapshot handle for \"" << it.first << "\" is non-null.";
-			continue;
-		}
-		LOG(INFO) << "Trigger for \"" << it.first << "\"";
-/* copy-on-write snapshot */
-		stream->snapshot_handle.store ((uintptr_t)(void*)stream->payload_entry_handle);
-	}
+	stream->last_access.store (access_sequence_.fetch_add (1));
 
-	LOG(INFO) << "/Trigger";
-	return true;
-}
+/* client may have disconnected before reply is available. */
+	auto client = shard->provider->GetClient (reinterpret_cast<RsslChannel*> (subscriber.handle));
+	if (!(bool)client)
+		return false;
 
-/* Check snapshot trigger:
- * Elektron stream is ordered per item stream not cross item stream.  Thus it is possible
- * to receive MSFT@11:01 before AAPL@11:00.  One can perform a snapshot if an update is
- * received post the target timestamp, but one has to wait for a delay time x after the
- * target timestamp to capture low-liquidity instruments.
- *
- * Return true to perform snapshot before applying update, return false to only apply the update.
+/* Repacked parts fill the negotiated fragment size of the client channel. */
+	uint32_t max_part_size = 0;
+	if (config_.repack_refresh) {
+		max_part_size = client->max_fragment_size();
+		if (0 == max_part_size)
+			max_part_size = MAX_MSG_SIZE;
+	}
+
+/* Read the published chain version within an epoch critical section, the
+ * encoded refresh is attached to the version once per RWF version, service,
+ * and part size.
  */
+	epoch_t::guard_t guard (stream->shard->epoch);
+	chain_version_t* version = stream->version.load();
+	DCHECK (nullptr != version);
+	const uint64_t key = RefreshCacheKey (rwf_version, service_id, max_part_size);
+	encoded_refresh_t* encoded = version->encoded.load();
+	while (nullptr != encoded && key != encoded->key)
+		encoded = encoded->next;
+	if (nullptr == encoded) {
+		shard->cumulative_stats[CHAINY_PC_REFRESH_CACHE_MISS]++;
+		std::unique_ptr<encoded_refresh_t> fresh (new encoded_refresh_t);
+		fresh->key = key;
+		if (!EncodeRefresh (*version, item_name, rwf_version, service_id, max_part_size, fresh.get())) {
+/* Extremely unlikely situation that writing the response fails but writing a close will not */
+			return SendClose (shard, item_name, subscriber, RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_ERROR, kErrorInternal);
+		}
+/* readers racing on the same key insert duplicates, the first found is used */
+		fresh->next = version->encoded.load();
+		while (!version->encoded.compare_exchange_weak (fresh->next, fresh.get()))
+			;
+		encoded = fresh.release();
+	} else {
+		shard->cumulative_stats[CHAINY_PC_REFRESH_CACHE_HIT]++;
+	}
 
-bool
-chainy::chainy_t::CheckTrigger (
-	const uint8_t rwf_major_version,
-	const uint8_t rwf_minor_version, 
-	RsslMsg* msg
-	)
-{
-	RsslDecodeIterator it = RSSL_INIT_DECODE_ITERATOR;
-	RsslFieldList field_list = RSSL_INIT_FIELD_LIST;
-	RsslFieldEntry field_entry = RSSL_INIT_FIELD_ENTRY;
-	RsslBuffer rssl_buffer;
-	RsslRet rc;
+	const uint8_t stream_state = is_streaming ? RSSL_STREAM_OPEN : RSSL_STREAM_NON_STREAMING;
+	bool is_sent = true;
+	auto it = encoded->parts.begin();
+	for (; it != encoded->parts.end(); ++it)
+	{
+		const bool is_complete = it == std::prev (encoded->parts.end());
 
-	rc = rsslSetDecodeIteratorRWFVersion (&it, rwf_major_version, rwf_minor_version);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorRWFVersion: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-                        ", \"majorVersion\": " << static_cast<unsigned> (rwf_major_version) << ""
-                        ", \"minorVersion\": " << static_cast<unsigned> (rwf_minor_version) << ""
-                        " }";
-                return false;
-        }
-	rc = rsslSetDecodeIteratorBuffer (&it, &msg->msgBase.encDataBody);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorBuffer: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-                        " }";
-                return false;
-        }
-	rc = rsslDecodeFieldList (&it, &field_list, nullptr);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslDecodeFieldList: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
-		return false;
-	}
-static const unsigned target_hour = 11 + 5 - 1;
-	while (RSSL_RET_SUCCESS == (rc = rsslDecodeFieldEntry (&it, &field_entry))) {
-		switch (field_entry.fieldId) {
-/* Unusual decode errors include:
- *
- * rsslDecodeTime: { "returnCode": -26, "enumeration": "RSSL_RET_INCOMPLETE_DATA",
- *                   "text": "Failure: Not enough data was provided." }
- * rsslDecodeTime: { "returnCode": 15, "enumeration": "RSSL_RET_BLANK_DATA",
- *                   "text": "Success: Decoded data is a Blank." }
- *
- * Blank timestamp should appear pre-market open on exchange reset.
+/* Copy into the channel buffer and patch there, the encoded part is shared
+ * between readers.
  */
-		case 238:
-		case 815:
-			rc = rsslDecodeBuffer (&it, &rssl_buffer);
-			if (RSSL_RET_BLANK_DATA == rc) {
-				LOG(INFO) << field_entry.fieldId << " = <blank>";
-				return false;
-			}
-			if (RSSL_RET_SUCCESS != rc) {
-				LOG(ERROR) << "rsslDecodeBuffer: { "
-		                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-		                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-		                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-					" }";
-				return false;
-			}
-			LOG(INFO) << field_entry.fieldId << " = \"" << std::string (rssl_buffer.data, rssl_buffer.length) << "\"";
-			return true;
-		default:
+		RsslBuffer* buf = client->GetReplyBuffer (it->size());
+		if (nullptr == buf) {
+			is_sent = false;
+			break;
+		}
+		memcpy (buf->data, it->data(), it->size());
+		buf->length = static_cast<uint32_t> (it->size());
+		if (!PatchRefresh (rwf_version, token, stream_state, is_solicited, buf->data, buf->length)) {
+			client->ReleaseReplyBuffer (buf);
+			is_sent = false;
+			break;
+		}
+		if (!client->SubmitReply (token, buf, is_complete && !is_streaming)) {
+			is_sent = false;
 			break;
 		}
 	}
-	return false;
-}
-
-/* The payload cache has updated, update symbol-list image for publishing.
- *
- * Returns false to abort update processing.
+	if (!is_sent) {
+/* A partial refresh never completes, close the request such that the client
+ * may recover it.  Nothing is owed when no part was sent.
  */
+		if (it != encoded->parts.begin())
+			SendClose (shard, item_name, subscriber, RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_ERROR, kErrorInternal);
+		return false;
+	}
+/* Register for membership updates. */
+	if (is_streaming) {
+		const auto key = std::make_pair (subscriber.handle, token);
+		auto result = stream->subscribers[shard->index].insert (std::make_pair (key, subscriber));
+		if (result.second)
+			stream->subscriber_count.fetch_add (1);
+		else
+			result.first->second = subscriber;
+		shard->subscriptions[key] = stream;
+	}
+	return true;
+}
 
 bool
-chainy::chainy_t::OnWrite (
-	std::shared_ptr<item_stream_t> item_stream,
-	const uint8_t rwf_major_version,
-	const uint8_t rwf_minor_version,
-	RsslMsg* msg
+chainy::chainy_t::SendClose (
+	provider_shard_t* shard,
+	const std::string& item_name,
+	const subscriber_t& subscriber,
+	uint8_t stream_state,
+	uint8_t status_code,
+	const std::string& status_text
 	)
 {
-	DVLOG(3) << "OnWrite";
-	auto stream = std::static_pointer_cast<subscription_stream_t> (item_stream);
-	std::vector<std::string> v;
-	bool is_complete = false;
-	RsslDecodeIterator it;
-	RsslFieldList field_list;
-	RsslFieldEntry field_entry;
-	RsslBuffer rssl_buffer;
-	RsslCacheError rssl_cache_err;
-	RsslRet rc;
-
-	std::shared_ptr<subscription_stream_t> parent = stream->links.front();
-
-	rsslClearDecodeIterator (&it);
-	rsslCacheErrorClear (&rssl_cache_err);
-
-	rc = rsslSetDecodeIteratorRWFVersion (&it, rwf_major_version, rwf_minor_version);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorRWFVersion: { "
-			  "\"returnCode\": " << static_cast<signed> (rc) << ""
-			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			", \"majorVersion\": " << static_cast<unsigned> (rwf_major_version) << ""
-			", \"minorVersion\": " << static_cast<unsigned> (rwf_minor_version) << ""
-			" }";
+	auto client = shard->provider->GetClient (reinterpret_cast<RsslChannel*> (subscriber.handle));
+	if (!(bool)client)
 		return false;
-	}
-	rc = rsslSetDecodeIteratorBuffer (&it, &msg->msgBase.encDataBody);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorBuffer: { "
-			  "\"returnCode\": " << static_cast<signed> (rc) << ""
-			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
+	RsslBuffer* buf = client->GetReplyBuffer (CloseSizeHint (item_name, status_text));
+	if (nullptr == buf)
 		return false;
-	}
-	rc = rsslDecodeFieldList (&it, &field_list, nullptr);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslDecodeFieldList: { "
-			  "\"returnCode\": " << static_cast<signed> (rc) << ""
-			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
+	size_t length = buf->length;
+	if (!provider_t::WriteRawClose (
+			subscriber.rwf_version,
+			subscriber.token,
+			subscriber.service_id,
+			RSSL_DMT_SYMBOL_LIST,
+			item_name,
+			subscriber.use_attribinfo_in_updates,
+			stream_state, status_code, status_text,
+			buf->data,
+			&length
+			))
+	{
+		client->ReleaseReplyBuffer (buf);
 		return false;
 	}
-	while (RSSL_RET_SUCCESS == (rc = rsslDecodeFieldEntry (&it, &field_entry))) {
-		switch (field_entry.fieldId) {
-		case 240:
-		case 241:
-		case 242:
-		case 243:
-		case 244:
-		case 245:
-		case 246:
-		case 247:
-		case 248:
-		case 249:
-		case 250:
-		case 251:
-		case 252:
-		case 253:
-/* long versions */
-		case 800:
-		case 801:
-		case 802:
-		case 803:
-		case 804:
-		case 805:
-		case 806:
-		case 807:
-		case 808:
-		case 809:
-		case 810:
-		case 811:
-		case 812:
-		case 813:
-			rc = rsslDecodeBuffer (&it, &rssl_buffer);
-			if (RSSL_RET_BLANK_DATA == rc || 0 == rssl_buffer.length) {
-				VLOG(1) << field_entry.fieldId << " = <blank>";
-				continue;
-			}
-			if (RSSL_RET_SUCCESS != rc) {
-				LOG(ERROR) << "rsslDecodeBuffer: { "
-					  "\"returnCode\": " << static_cast<signed> (rc) << ""
-					", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-					", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-					" }";
-				return false;
-			}
-			VLOG(1) << field_entry.fieldId << " = \"" << std::string (rssl_buffer.data, rssl_buffer.length) << "\"";
-			v.emplace_back (rssl_buffer.data, rssl_buffer.length);
-			break;
+	buf->length = static_cast<uint32_t> (length);
+	return client->SubmitReplyAndClose (subscriber.token, buf);
+}
 
-/* next link pointers */
-		case 238:
-		case 815:
-			rc = rsslDecodeBuffer (&it, &rssl_buffer);
-			if (RSSL_RET_BLANK_DATA == rc || 0 == rssl_buffer.length) {
-				VLOG(1) << "<next link> = <blank>";
+
+/* Open chains of the snapshot file with the checkpointed constituents as a
+ * suspect version, chains not in the symbol list are opened as if requested
+ * on demand.  Each chain is walked afresh as usual.
+ *
+ * Returns the count of chains loaded.
+ */
+unsigned
+chainy::chainy_t::LoadSnapshot()
+{
+	unsigned loaded = 0;
+	if (!snapshot_->Open (config_.flatten_depth > 0))
+		return loaded;
+	for (const auto& entry : snapshot_->chains()) {
+		const std::string item_name (entry.item_name.as_string());
+		std::shared_ptr<subscription_stream_t> chain;
+		auto search = streams_.find (item_name);
+		if (search != streams_.end()) {
+			chain = search->second;
+		} else {
+			chain = CreateChain (GetConsumerShard (item_name), item_name);
+			if (!(bool)chain)
 				continue;
+			chain->is_on_demand = true;
+			chain->last_access.store (access_sequence_.fetch_add (1));
+		}
+		auto version = new chain_version_t();
+		version->is_complete = true;
+		version->is_suspect = true;
+		if (config_.flatten_depth > 0) {
+			auto expanded = std::make_shared<std::vector<std::string>> ();
+			for (const auto& group : entry.groups) {
+				for (const auto& ric : group)
+					expanded->push_back (ric.as_string());
 			}
-			if (RSSL_RET_SUCCESS != rc) {
-				LOG(ERROR) << "rsslDecodeBuffer: { "
-					  "\"returnCode\": " << static_cast<signed> (rc) << ""
-					", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-					", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-					" }";
-				return false;
-			}
-			VLOG(1) << "<next link> = \"" << std::string (rssl_buffer.data, rssl_buffer.length) << "\"";
-			if (0 == rssl_buffer.length) {
-				is_complete = true;
-/* destroy all following links */
-				parent->links.resize (1 + stream->index);
-			} else {
-				std::string link_name (rssl_buffer.data, rssl_buffer.length);
-				auto link_stream = std::make_shared<subscription_stream_t> ();
-				if (!(bool)link_stream)
-					return false;
-				link_stream->links.push_back (parent);
-				link_stream->index = 1 + stream->index;
-				if (consumer_->CreateItemStream (link_name.c_str(), link_stream)) {
-					if (link_stream->index == parent->links.size())
-						parent->links.resize (1 + link_stream->index);
-					parent->links[link_stream->index] = link_stream;
-				} else {
-					LOG(WARNING) << "Cannot create stream for \"" << link_name << "\".";
-				}
-			}
-
-		default:
-			break;
+			version->expanded = expanded;
+		} else {
+			for (const auto& group : entry.groups)
+				version->links.push_back (std::make_shared<link_image_t> (group));
 		}
+		const size_t footprint = ChainFootprint (*version, chain->links.size());
+		chain->shard->chain_memory -= chain->footprint;
+		chain->shard->chain_memory += footprint;
+		chain->footprint = footprint;
+		chain->shard->cumulative_stats[CHAINY_PC_SNAPSHOT_LOADED]++;
+		chain_version_t* previous = chain->version.exchange (version);
+		if (nullptr != previous)
+			chain->shard->epoch.Retire ([previous]() { delete previous; });
+		++loaded;
 	}
+/* link images hold their own copy of each name */
+	snapshot_->Close();
+	return loaded;
+}
 
-	consumer_rssl_length_ = sizeof (consumer_rssl_buf_);
-	if (!WriteRaw ((rwf_major_version * 256) + rwf_minor_version,
-			parent->token,
-			consumer_->service_id(),
-			parent->item_name,
-			nullptr,
-			stream->index, is_complete,
-			v,
-			consumer_rssl_buf_,
-			&consumer_rssl_length_))
+/* Checkpoint every resolved chain as last published, including chains still
+ * served from the previous snapshot.  Versions are read within an epoch
+ * critical section of each consumer shard whilst the shards continue.  The
+ * previous snapshot is kept if nothing is resolved.
+ */
+void
+chainy::chainy_t::WriteSnapshot()
+{
+	std::vector<std::shared_ptr<subscription_stream_t>> chains;
 	{
-		LOG(ERROR) << "WriteRaw failed";
-		return false;
+		boost::shared_lock<boost::shared_mutex> lock (streams_lock_);
+		chains.reserve (streams_.size());
+		for (auto it = streams_.begin(); it != streams_.end(); ++it)
+			chains.push_back (it->second);
 	}
-
-	if (nullptr == stream->cow_handle) {
-		stream->cow_handle = rsslPayloadEntryCreate (consumer_->cache_handle(), &rssl_cache_err);
-		if (nullptr == stream->cow_handle) {
-			LOG(ERROR) << "rsslPayloadCacheCreate: { "
-				  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
-				", \"text\": \"" << rssl_cache_err.text << "\""
-				" }";
-			return false;
+	std::vector<std::vector<chromium::StringPiece>> groups;
+	snapshot_->Clear();
+	for (const auto& chain : chains) {
+		epoch_t::guard_t guard (chain->shard->epoch);
+		const chain_version_t* version = chain->version.load();
+		if (nullptr == version || !version->is_complete)
+			continue;
+		groups.clear();
+		if ((bool)version->expanded) {
+			groups.resize (1);
+			groups.back().assign (version->expanded->begin(), version->expanded->end());
+		} else {
+			groups.resize (version->links.size());
+			for (size_t i = 0; i < version->links.size(); ++i)
+				version->links[i]->AppendTo (&groups[i]);
 		}
+		if (!snapshot_->Append (chain->item_name, groups))
+			LOG(WARNING) << "Cannot checkpoint chain \"" << chain->item_name << "\".";
 	}
-
-	RsslMsg cache_msg = RSSL_INIT_MSG;
-	RsslBuffer data_buffer = { static_cast<uint32_t> (consumer_rssl_length_), consumer_rssl_buf_ };
-
-	rc = rsslSetDecodeIteratorBuffer (&it, &data_buffer);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorBuffer: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
-		return false;
+	if (0 == snapshot_->captured_count()) {
+		snapshot_->Clear();
+		return;
 	}
-	rc = rsslSetDecodeIteratorRWFVersion (&it, rwf_major_version, rwf_minor_version);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslSetDecodeIteratorRWFVersion: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
-		return false;
+	if (snapshot_->Commit (config_.flatten_depth > 0))
+		cumulative_stats_[CHAINY_PC_SNAPSHOT_WRITTEN]++;
+}
+
+/* Encode each refresh part of a chain version.  With a non-zero part size the
+ * constituents of all links are repacked into as few parts as fit, otherwise
+ * each link forms one part.
+ */
+bool
+chainy::chainy_t::EncodeRefresh (
+	const chain_version_t& version,
+	const chromium::StringPiece& item_name,
+	uint16_t rwf_version,
+	uint16_t service_id,
+	uint32_t max_part_size,
+	encoded_refresh_t* encoded
+	)
+{
+/* Constituents are read in place from the version, which outlives the encode. */
+	std::vector<std::vector<chromium::StringPiece>> groups;
+	if ((bool)version.expanded) {
+/* a flattened chain has no link structure to preserve */
+		if (0 == max_part_size)
+			max_part_size = MAX_MSG_SIZE;
+		groups.resize (1);
+		groups.back().assign (version.expanded->begin(), version.expanded->end());
+	} else if (max_part_size > 0) {
+		groups.resize (1);
+		for (const auto& link : version.links)
+			link->AppendTo (&groups.back());
+	} else {
+		max_part_size = MAX_MSG_SIZE;
+		groups.resize (version.links.size());
+		for (size_t i = 0; i < version.links.size(); ++i)
+			version.links[i]->AppendTo (&groups[i]);
 	}
-	rc = rsslDecodeMsg (&it, &cache_msg);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslDecodeMsg: { "
-                          "\"returnCode\": " << static_cast<signed> (rc) << ""
-                        ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-                        ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
-		return false;
+	encoded->parts.clear();
+	unsigned part_number = 0;
+	for (const auto& group : groups) {
+		size_t offset = 0;
+		do {
+			std::vector<char> part (max_part_size);
+			size_t length = part.size();
+			if (!WriteRaw (rwf_version,
+					0 /* patched per request */,
+					service_id,
+					item_name,
+					nullptr,
+					part_number++,
+					false /* set on final part */,
+					false,
+					version.is_suspect ? RSSL_DATA_SUSPECT : RSSL_DATA_OK,
+					group, &offset,
+					part.data(),
+					&length))
+			{
+				encoded->parts.clear();
+				return false;
+			}
+			part.resize (length);
+			encoded->parts.push_back (std::move (part));
+		} while (offset < group.size());
 	}
-	rc = rsslPayloadEntryApply (stream->cow_handle, &it, &cache_msg, &rssl_cache_err);
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << "rsslPayloadEntryApply: { "
-			  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
-			", \"text\": \"" << rssl_cache_err.text << "\""
-			" }";
+	if (encoded->parts.empty()
+		|| !SetRefreshComplete (rwf_version, encoded->parts.back().data(), encoded->parts.back().size()))
+	{
+		encoded->parts.clear();
 		return false;
 	}
-	stream->snapshot_handle.store ((uintptr_t)(void*)stream->cow_handle);
 	return true;
 }
 
 bool
-chainy::chainy_t::OnRequest (
+chainy::chainy_t::OnCancel (
+	provider_shard_t* shard,
 	uintptr_t handle,
-	uint16_t rwf_version, 
-	int32_t token,
-	uint16_t service_id,
-	const std::string& item_name,
-	bool use_attribinfo_in_updates
+	int32_t token
 	)
 {
-	DVLOG(3) << "Request: { "
+	DVLOG(3) << "Cancel: { "
 		  "\"handle\": " << handle << ""
-		", \"rwf_version\": " << rwf_version << ""
 		", \"token\": " << token << ""
-		", \"service_id\": " << service_id << ""
-		", \"item_name\": \"" << item_name << "\""
-		", \"use_attribinfo_in_updates\": " << (use_attribinfo_in_updates ? "true" : "false") << ""
 		" }";
-/* Reset message buffer */
-	provider_rssl_length_ = sizeof (provider_rssl_buf_);
-/* Validate symbol */
-	auto search = streams_.find (item_name);
-	if (search == streams_.end()) {
-		LOG(INFO) << "Closing resource not found for \"" << item_name << "\"";
-		if (!provider_t::WriteRawClose (
-				rwf_version,
-				token,
-				service_id,
-				RSSL_DMT_MARKET_PRICE,
-				item_name,
-				use_attribinfo_in_updates,
-				RSSL_STREAM_CLOSED, RSSL_SC_NOT_FOUND, kErrorNotFound,
-				provider_rssl_buf_,
-				&provider_rssl_length_
-				))
-		{
-			return false;
-		}
-		if (!provider_->SendReplyAndClose (reinterpret_cast<RsslChannel*> (handle), token, provider_rssl_buf_, provider_rssl_length_))
-		{
-			return false;
-		}
-	}
-
-	unsigned part_number = 0;
-	for (auto it = search->second->links.begin();
-		it != search->second->links.end();
-		++it)
-	{
-		auto stream = *it;
-		bool is_complete = it == std::prev (search->second->links.end());
-
-/* Reset message buffer */
-		provider_rssl_length_ = sizeof (provider_rssl_buf_);
-		if (!WriteRaw (rwf_version,
-				token,
-				service_id,
-				item_name,
-				nullptr,
-				part_number++,
-				is_complete,
-				(RsslPayloadEntryHandle)(void*)stream->snapshot_handle.load(),
-				provider_rssl_buf_,
-				&provider_rssl_length_))
-		{
-/* Extremely unlikely situation that writing the response fails but writing a close will not */
-			if (!provider_t::WriteRawClose (
-					rwf_version,
-					token,
-					service_id,
-					RSSL_DMT_MARKET_PRICE,
-					item_name,
-					use_attribinfo_in_updates,
-					RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_ERROR, kErrorInternal,
-					provider_rssl_buf_,
-					&provider_rssl_length_
-					))
-			{
-				return false;
-			}
-		}
-		if (!provider_->SendReply (reinterpret_cast<RsslChannel*> (handle), token, provider_rssl_buf_, provider_rssl_length_, is_complete))
-		{
-			return false;
+/* Ignore snapshot requests, withdraw requests parked on resolution. */
+	auto search = shard->subscriptions.find (std::make_pair (handle, token));
+	if (search == shard->subscriptions.end()) {
+		for (auto it = shard->parked.begin(); it != shard->parked.end(); ++it) {
+			auto& requests = it->second;
+			requests.erase (std::remove_if (requests.begin(), requests.end(), [handle, token](const request_t& request) {
+				return handle == request.subscriber.handle && token == request.subscriber.token;
+			}), requests.end());
 		}
+		return true;
 	}
+	auto stream = search->second;
+	if (stream->subscribers[shard->index].erase (search->first) > 0)
+		stream->subscriber_count.fetch_sub (1);
+	shard->subscriptions.erase (search);
 	return true;
 }
 
@@ -650,7 +2205,10 @@ chainy::chainy_t::WriteRaw (
 	const chromium::StringPiece& dacs_lock,		/* ignore DACS lock */
 	unsigned part_number,				/* 0 indicates initial part */
 	bool is_complete,				/* mark refresh-complete */
-	const std::vector<std::string>& symbol_list,
+	bool is_streaming,				/* streaming request */
+	uint8_t data_state,				/* suspect when served from a snapshot */
+	const std::vector<chromium::StringPiece>& symbol_list,
+	size_t* offset,					/* advanced past entries that fit */
 	void* data,
 	size_t* length
 	)
@@ -695,9 +2253,9 @@ chainy::chainy_t::WriteRaw (
 
 /** Optional: but require to replace stale values in cache when stale values are supported. **/
 /* Item interaction state: Open, Closed, ClosedRecover, Redirected, NonStreaming, or Unspecified. */
-	response.state.streamState = RSSL_STREAM_NON_STREAMING;
+	response.state.streamState = is_streaming ? RSSL_STREAM_OPEN : RSSL_STREAM_NON_STREAMING;
 /* Data quality state: Ok, Suspect, or Unspecified. */
-	response.state.dataState = RSSL_DATA_OK;
+	response.state.dataState = data_state;
 /* Error code, e.g. NotFound, InvalidArgument, ... */
 	response.state.code = RSSL_SC_NONE;
 
@@ -743,11 +2301,16 @@ chainy::chainy_t::WriteRaw (
 			" }";
 		return false;
 	}
-	for (const std::string& s : symbol_list) {
+	const size_t first = *offset;
+	for (; *offset < symbol_list.size(); ++*offset) {
+		const chromium::StringPiece& s = symbol_list[*offset];
 		RsslMapEntry map_entry = RSSL_INIT_MAP_ENTRY;
 		const RsslBuffer key_data = { static_cast<uint32_t> (s.size()), const_cast<char *> (s.data()) };
 		map_entry.action = RSSL_MPEA_ADD_ENTRY;
 		rc = rsslEncodeMapEntry (&it, &map_entry, &key_data);
+/* entry rolled back, remainder follows in the next part */
+		if (RSSL_RET_BUFFER_TOO_SMALL == rc && *offset > first)
+			break;
 		if (RSSL_RET_SUCCESS != rc) {
 			LOG(ERROR) << "rsslEncodeMapEntry: { "
 				  "\"returnCode\": " << static_cast<signed> (rc) << ""
@@ -792,22 +2355,24 @@ chainy::chainy_t::WriteRaw (
 	return true;
 }
 
+/* Encode map entries from delta starting at offset, offset is advanced past
+ * the entries that fit within the message buffer.
+ */
 bool
-chainy::chainy_t::WriteRaw (
+chainy::chainy_t::WriteRawUpdate (
 	uint16_t rwf_version,
 	int32_t token,
 	uint16_t service_id,
 	const chromium::StringPiece& item_name,
-	const chromium::StringPiece& dacs_lock,		/* ignore DACS lock */
-	unsigned part_number,				/* 0 indicates initial part */
-	bool is_complete,				/* mark refresh-complete */
-	const RsslPayloadEntryHandle payload_entry_handle,
+	bool use_attribinfo_in_updates,
+	const symbol_delta_t& delta,
+	size_t* offset,
 	void* data,
 	size_t* length
 	)
 {
 /* 7.4.8.1 Create a response message (4.2.2) */
-	RsslRefreshMsg response = RSSL_INIT_REFRESH_MSG;
+	RsslUpdateMsg response = RSSL_INIT_UPDATE_MSG;
 #ifndef NDEBUG
 	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
 #else
@@ -818,40 +2383,29 @@ chainy::chainy_t::WriteRaw (
 	RsslRet rc;
 
 	DCHECK(!item_name.empty());
+	DCHECK(*offset < delta.size());
 
 /* 7.4.8.3 Set the message model type of the response. */
 	response.msgBase.domainType = RSSL_DMT_SYMBOL_LIST;
 /* 7.4.8.4 Set response type, response type number, and indication mask. */
-	response.msgBase.msgClass = RSSL_MC_REFRESH;
-/* for snapshot images do not cache */
-	response.flags = RSSL_RFMF_SOLICITED | RSSL_RFMF_HAS_PART_NUM;
-	if (0 == part_number)   
-		response.flags |= RSSL_RFMF_CLEAR_CACHE;
-	if (is_complete)        
-		response.flags |= RSSL_RFMF_REFRESH_COMPLETE;
-	response.partNum = part_number;
+	response.msgBase.msgClass = RSSL_MC_UPDATE;
+	response.updateType = RDM_UPD_EVENT_TYPE_UNSPECIFIED;
 
 /* RDM map for a symbol list. */
 	response.msgBase.containerType = RSSL_DT_MAP;
 
 /* 7.4.8.2 Create or re-use a request attribute object (4.2.4) */
-	response.msgBase.msgKey.serviceId   = service_id;
-	response.msgBase.msgKey.nameType    = RDM_INSTRUMENT_NAME_TYPE_RIC;
-	response.msgBase.msgKey.name.data   = const_cast<char*> (item_name.data());
-	response.msgBase.msgKey.name.length = static_cast<uint32_t> (item_name.size());
-	response.msgBase.msgKey.flags = RSSL_MKF_HAS_SERVICE_ID | RSSL_MKF_HAS_NAME_TYPE | RSSL_MKF_HAS_NAME;
-	response.flags |= RSSL_RFMF_HAS_MSG_KEY;
+	if (use_attribinfo_in_updates) {
+		response.msgBase.msgKey.serviceId   = service_id;
+		response.msgBase.msgKey.nameType    = RDM_INSTRUMENT_NAME_TYPE_RIC;
+		response.msgBase.msgKey.name.data   = const_cast<char*> (item_name.data());
+		response.msgBase.msgKey.name.length = static_cast<uint32_t> (item_name.size());
+		response.msgBase.msgKey.flags = RSSL_MKF_HAS_SERVICE_ID | RSSL_MKF_HAS_NAME_TYPE | RSSL_MKF_HAS_NAME;
+		response.flags |= RSSL_UPMF_HAS_MSG_KEY;
+	}
 /* Set the request token. */
 	response.msgBase.streamId = token;
 
-/** Optional: but require to replace stale values in cache when stale values are supported. **/
-/* Item interaction state: Open, Closed, ClosedRecover, Redirected, NonStreaming, or Unspecified. */
-	response.state.streamState = RSSL_STREAM_NON_STREAMING;
-/* Data quality state: Ok, Suspect, or Unspecified. */
-	response.state.dataState = RSSL_DATA_OK;
-/* Error code, e.g. NotFound, InvalidArgument, ... */
-	response.state.code = RSSL_SC_NONE;
-
 	rc = rsslSetEncodeIteratorBuffer (&it, &buf);
 	if (RSSL_RET_SUCCESS != rc) {
 		LOG(ERROR) << "rsslSetEncodeIteratorBuffer: { "
@@ -861,7 +2415,7 @@ chainy::chainy_t::WriteRaw (
 			" }";
 		return false;
 	}
-	rc = rsslSetEncodeIteratorRWFVersion (&it, provider_t::rwf_major_version (rwf_version), provider_t::rwf_major_version (rwf_version));
+	rc = rsslSetEncodeIteratorRWFVersion (&it, provider_t::rwf_major_version (rwf_version), provider_t::rwf_minor_version (rwf_version));
 	if (RSSL_RET_SUCCESS != rc) {
 		LOG(ERROR) << "rsslSetEncodeIteratorRWFVersion: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
@@ -881,21 +2435,46 @@ chainy::chainy_t::WriteRaw (
 			" }";
 		return false;
 	}
-/* Providing a null payload handle sometimes results in the following:
- *
- * rsslPayloadEntryRetrieve: { "rsslErrorId": -1, "text": "rsslPayloadEntryRetrieve: invalid inputs" }
- */
-	if (0 != payload_entry_handle) {
-		RsslCacheError rssl_cache_err;
-		rsslCacheErrorClear (&rssl_cache_err);
-                rc = rsslPayloadEntryRetrieve (payload_entry_handle, &it, nullptr, &rssl_cache_err);
-                if (RSSL_RET_SUCCESS != rc) {
-                        LOG(ERROR) << "rsslPayloadEntryRetrieve: { "
-                                  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
-                                ", \"text\": \"" << rssl_cache_err.text << "\""
-                                " }";
-                        return false;
-                }
+/* RSSL map { RsslBuffer -> NULL } */
+	RsslMap rssl_map = RSSL_INIT_MAP;
+	rssl_map.containerType = RSSL_DT_NO_DATA;
+	rssl_map.keyPrimitiveType = RSSL_DT_BUFFER;
+	rc = rsslEncodeMapInit (&it, &rssl_map, 0 /* summary size */, 0 /* max size */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslEncodeMapInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	const size_t first = *offset;
+	for (; *offset < delta.size(); ++*offset) {
+		const std::string& s = delta[*offset].second;
+		RsslMapEntry map_entry = RSSL_INIT_MAP_ENTRY;
+		const RsslBuffer key_data = { static_cast<uint32_t> (s.size()), const_cast<char *> (s.data()) };
+		map_entry.action = delta[*offset].first;
+		rc = rsslEncodeMapEntry (&it, &map_entry, &key_data);
+/* entry rolled back, remainder follows in a subsequent update */
+		if (RSSL_RET_BUFFER_TOO_SMALL == rc && *offset > first)
+			break;
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << "rsslEncodeMapEntry: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			return false;
+		}
+	}
+	rc = rsslEncodeMapComplete (&it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << "rsslEncodeMapComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
 	}
 /* finalize multi-step encoder */
 	rc = rsslEncodeMsgComplete (&it, RSSL_TRUE /* commit */);
@@ -930,19 +2509,27 @@ chainy::chainy_t::Start()
 		" }";
 	if (!shutting_down_ && Initialize()) {
 /* Spawn new thread for message pump. */
-		consumer_thread_.reset (new boost::thread ([this]() {
-			ConsumerLoop();
+		consumer_running_ = static_cast<unsigned> (consumer_shards_.size());
+		for (auto& shard : consumer_shards_) {
+			consumer_shard_t* target = shard.get();
+			target->thread.reset (new boost::thread ([this, target]() {
+				ConsumerLoop (target);
 /* Raise condition loop is complete. */
-			boost::lock_guard<boost::mutex> lock (consumer_lock_);
-			consumer_shutdown_ = true;
-			consumer_cond_.notify_one();
-		}));
-		provider_thread_.reset (new boost::thread ([this]() {
-			ProviderLoop();
-			boost::lock_guard<boost::mutex> lock (provider_lock_);
-			provider_shutdown_ = true;
-			provider_cond_.notify_one();
-		}));
+				boost::lock_guard<boost::mutex> lock (consumer_lock_);
+				consumer_running_--;
+				consumer_cond_.notify_one();
+			}));
+		}
+		provider_running_ = static_cast<unsigned> (shards_.size());
+		for (auto& shard : shards_) {
+			provider_shard_t* target = shard.get();
+			target->thread.reset (new boost::thread ([this, target]() {
+				ProviderLoop (target);
+				boost::lock_guard<boost::mutex> lock (provider_lock_);
+				provider_running_--;
+				provider_cond_.notify_one();
+			}));
+		}
 	}
 	return true;
 }
@@ -953,35 +2540,72 @@ chainy::chainy_t::Stop()
 	LOG(INFO) << "Shutting down instance: { "
 		" }";
 	shutting_down_ = true;
-	if ((bool)provider_) {
-		provider_->Quit();
-/* Wait for mainloop to quit */
+	if (!shards_.empty()) {
+		for (auto& shard : shards_)
+			shard->provider->Quit();
+/* Wait for mainloops to quit */
 		boost::unique_lock<boost::mutex> lock (provider_lock_);
-		while (!provider_shutdown_)
+		while (provider_running_ > 0)
 			provider_cond_.wait (lock);
 	}
-	if ((bool)consumer_) {
-		consumer_->Quit();
-/* Wait for mainloop to quit */
+	if (!consumer_shards_.empty()) {
+		for (auto& shard : consumer_shards_)
+			shard->consumer->Quit();
+/* Wait for mainloops to quit */
 		boost::unique_lock<boost::mutex> lock (consumer_lock_);
-		while (!consumer_shutdown_)
+		while (consumer_running_ > 0)
 			consumer_cond_.wait (lock);
 	}
+	if ((bool)snapshot_)
+		WriteSnapshot();
 	Reset();
 }
 
 void
 chainy::chainy_t::Reset()
 {
+/* Threads may still be unwinding after their loops return, e.g. releasing
+ * epoch readers registered with consumer shards.
+ */
+	for (auto& shard : shards_) {
+		if ((bool)shard->thread && shard->thread->joinable())
+			shard->thread->join();
+	}
+	for (auto& shard : consumer_shards_) {
+		if ((bool)shard->thread && shard->thread->joinable())
+			shard->thread->join();
+	}
 /* Release everything with an UPA dependency. */
-	if ((bool)consumer_)
-		consumer_->Close();
-	CHECK_LE (consumer_.use_count(), 1);
-	if ((bool)provider_)
-		provider_->Close();
-	CHECK_LE (provider_.use_count(), 1);
-	consumer_.reset();
-	provider_.reset();
+	for (auto& shard : consumer_shards_) {
+		if ((bool)shard->consumer)
+			shard->consumer->Close();
+		CHECK_LE (shard->consumer.use_count(), 1);
+	}
+/* Worker shards before the acceptor which may still hand over channels. */
+	for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+		auto& shard = *it;
+		if ((bool)shard->provider)
+			shard->provider->Close();
+		CHECK_LE (shard->provider.use_count(), 1);
+	}
+	for (auto& shard : consumer_shards_)
+		shard->consumer.reset();
+/* Fold in counters of the consumer and provider threads. */
+	for (auto& shard : consumer_shards_) {
+		for (int i = 0; i < CHAINY_PC_MAX; ++i)
+			cumulative_stats_[i] += shard->cumulative_stats[i];
+		versions_reclaimed_ += shard->epoch.reclaimed();
+	}
+	for (auto& shard : shards_) {
+		for (int i = 0; i < CHAINY_PC_MAX; ++i)
+			cumulative_stats_[i] += shard->cumulative_stats[i];
+	}
+/* Release chains, the root is the first link of its own chain. */
+	shards_.clear();
+	for (auto it = streams_.begin(); it != streams_.end(); ++it)
+		it->second->links.clear();
+	streams_.clear();
+	consumer_shards_.clear();
 /* Final tests before releasing UPA context */
 	chromium::debug::LeakTracker<client_t>::CheckForLeaks();
 	chromium::debug::LeakTracker<provider_t>::CheckForLeaks();
@@ -992,10 +2616,12 @@ chainy::chainy_t::Reset()
 }
 
 void
-chainy::chainy_t::ConsumerLoop()
+chainy::chainy_t::ConsumerLoop (
+	consumer_shard_t* shard
+	)
 {
 	try {
-		consumer_->Run(); 
+		shard->consumer->Run(); 
 	} catch (const std::exception& e) {
 		LOG(ERROR) << "Runtime exception: { "
 			"\"What\": \"" << e.what() << "\" }";
@@ -1003,10 +2629,12 @@ chainy::chainy_t::ConsumerLoop()
 }
 
 void
-chainy::chainy_t::ProviderLoop()
+chainy::chainy_t::ProviderLoop (
+	provider_shard_t* shard
+	)
 {
 	try {
-		provider_->Run(); 
+		shard->provider->Run(); 
 	} catch (const std::exception& e) {
 		LOG(ERROR) << "Runtime exception: { "
 			"\"What\": \"" << e.what() << "\" }";
@@ -15,56 +15,272 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 
 #include "chromium/strings/string_piece.hh"
+#include "chain_snapshot.hh"
+#include "chain_store.hh"
+#include "chain_template.hh"
 #include "client.hh"
 #include "consumer.hh"
 #include "provider.hh"
 #include "config.hh"
+#include "epoch.hh"
+#include "field_scanner.hh"
 
 /* Maximum encoded size of an RSSL provider to client message. */
 #define MAX_MSG_SIZE 4096
 
 namespace chainy
 {
+/* Performance Counters */
+	enum {
+		CHAINY_PC_LINK_PREDICTED,
+		CHAINY_PC_LINK_PREDICTION_HIT,
+		CHAINY_PC_LINK_PREDICTION_DISCARDED,
+		CHAINY_PC_LINK_UNPREDICTED,
+		CHAINY_PC_LINK_CYCLE_DETECTED,
+		CHAINY_PC_LINK_CREATED,
+		CHAINY_PC_LINK_RECLAIMED,
+		CHAINY_PC_CONSTITUENT_ADDED,
+		CHAINY_PC_CONSTITUENT_DELETED,
+		CHAINY_PC_UPDATE_SENT,
+		CHAINY_PC_UPDATE_EXCEPTION,
+		CHAINY_PC_SUBSCRIBER_DROPPED,
+		CHAINY_PC_REFRESH_CACHE_HIT,
+		CHAINY_PC_REFRESH_CACHE_MISS,
+		CHAINY_PC_VERSION_PUBLISHED,
+		CHAINY_PC_SUBCHAIN_CREATED,
+		CHAINY_PC_SUBCHAIN_CYCLE_DETECTED,
+		CHAINY_PC_SUBCHAIN_DEPTH_EXCEEDED,
+		CHAINY_PC_CHAIN_RESOLVED,
+		CHAINY_PC_CHAIN_NOT_FOUND,
+		CHAINY_PC_CHAIN_EVICTED,
+		CHAINY_PC_REQUEST_PARKED,
+		CHAINY_PC_REQUEST_COALESCED,
+		CHAINY_PC_SNAPSHOT_LOADED,
+		CHAINY_PC_SNAPSHOT_REPLACED,
+		CHAINY_PC_SNAPSHOT_WRITTEN,
+/* marker */
+		CHAINY_PC_MAX
+	};
+
+	class chainy_t;
+	class consumer_shard_t;
 	class consumer_t;
 	class provider_t;
 	class upa_t;
 
+/* Constituent changes of a chain as RsslMapEntry actions. */
+	typedef std::vector<std::pair<uint8_t, std::string>> symbol_delta_t;
+
+/* Open streaming request on a chain. */
+	struct subscriber_t
+	{
+		uintptr_t handle;
+		uint16_t rwf_version;
+		int32_t token;
+		uint16_t service_id;
+		bool use_attribinfo_in_updates;
+	};
+
+/* Request waiting on resolution of a chain. */
+	struct request_t
+	{
+		subscriber_t subscriber;
+		bool is_streaming;
+	};
+
+/* Encoded refresh of a chain, one buffer per part. */
+	struct encoded_refresh_t
+	{
+/* RWF version, service id, and part size. */
+		uint64_t key;
+		std::vector<std::vector<char>> parts;
+		encoded_refresh_t* next;
+	};
+
+/* Immutable image of a chain published by the consumer thread, read by the
+ * provider thread under an epoch guard.
+ */
+	class chain_version_t
+	{
+	public:
+		explicit chain_version_t()
+			: is_complete (false),
+			  is_suspect (false),
+			  encoded (nullptr)
+		{
+		}
+		~chain_version_t() {
+			for (auto it = encoded.load(); nullptr != it;) {
+				auto next = it->next;
+				delete it;
+				it = next;
+			}
+		}
+
+/* Constituents of each link confirmed by the chain walk, in chain order. */
+		std::vector<std::shared_ptr<const link_image_t>> links;
+/* Flattening only: de-duplicated constituents with sub-chains expanded. */
+		std::shared_ptr<const std::vector<std::string>> expanded;
+/* The chain walk reached the final link. */
+		bool is_complete;
+/* Loaded from the snapshot file, served as suspect until walked afresh. */
+		bool is_suspect;
+/* Encoded refresh per cache key, prepended by readers without locking. */
+		std::atomic<encoded_refresh_t*> encoded;
+	};
+
 /* Basic example structure for application state of an item stream. */
         class subscription_stream_t : public item_stream_t
         {
         public:
                 explicit subscription_stream_t ()
-			: snapshot_handle (0),
-			  cow_handle (nullptr),
+			: version (nullptr),
+			  template_index (-1),
 			  index (0),
-			  request_received (0)
+			  is_speculative (false),
+			  is_predictable (false),
+			  is_published (false),
+			  is_complete (false),
+			  is_on_demand (false),
+			  footprint (0),
+			  last_access (0),
+			  subscriber_count (0),
+			  request_received (0),
+			  shard (nullptr)
                 {
                 }
+		~subscription_stream_t() {
+			delete version.load();
+		}
 
-/* Payload snapshot. */
-		std::atomic<std::uintptr_t> snapshot_handle;
-/* Cache entry for when source entry has updated. */
-		RsslPayloadEntryHandle cow_handle;
+/* Root only: current chain image, retired versions are reclaimed by epoch. */
+		std::atomic<chain_version_t*> version;
+/* Constituents of this link by link field slot as shared with published
+ * versions, replaced whole on change.
+ */
+		std::shared_ptr<const link_image_t> image;
 
+/* Root only: detected link layout in the chain template set, -1 until detected. */
+		int template_index;
+/* Root of the chain, the root refers to itself.  Links are owned by the
+ * root, a link of a removed chain finds its root expired.
+ */
+		std::weak_ptr<subscription_stream_t> parent;
 /* A runtime generated link rather than original subscription. */
 		unsigned index;
+/* Root only: the root followed by each link, released by RemoveChain. */
 		std::vector<std::shared_ptr<subscription_stream_t>> links;
-		std::vector<std::string> rics;
+/* Next link pointer as last published by this link, empty on the final link. */
+		std::string next_link;
+/* Link requested ahead of the chain walk, not yet confirmed by a next link pointer. */
+		bool is_speculative;
+/* Root link name follows the 0#X, 1#X, 2#X, ... convention. */
+		bool is_predictable;
+/* Constituents of this link are counted in the chain. */
+		bool is_published;
+/* Root only: chain walk has reached the final link. */
+		bool is_complete;
+/* Root only: opened by a request rather than the symbol set, may be evicted when idle. */
+		bool is_on_demand;
+/* Root only: approximate memory of the published chain. */
+		size_t footprint;
+/* Root only: request sequence of the last request, stored by the provider thread. */
+		std::atomic<uint64_t> last_access;
+/* Root only: total of subscribers across shards for the consumer thread. */
+		std::atomic<size_t> subscriber_count;
+/* Root only: reference count of each constituent across published links. */
+		boost::unordered_map<std::string, unsigned> constituents;
+/* Root only, provider threads: streaming requests by client handle and token,
+ * indexed by provider shard.
+ */
+		std::vector<boost::unordered_map<std::pair<uintptr_t, int32_t>, subscriber_t>> subscribers;
+/* Root only: chains expanding this chain as a constituent, republished on change. */
+		boost::unordered_set<std::string> referrers;
 
 /* Performance counters */
 		uint32_t request_received;
+
+/* Consumer shard of the chain, links are served by the shard of their root. */
+		consumer_shard_t* shard;
         };
 
+/* Provider worker loop over a shard of client sessions with the provider
+ * thread state of those sessions.
+ */
+	class provider_shard_t
+		: public client_t::Delegate	/* Rssl requests */
+	{
+	public:
+		explicit provider_shard_t (chainy_t* chainy, unsigned index);
+
+		virtual bool OnRequest (uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates, bool is_streaming) override;
+		virtual bool OnCancel (uintptr_t handle, int32_t token) override;
+
+		chainy_t*const chainy;
+/* Index into subscriber maps of each chain. */
+		const unsigned index;
+/* UPA provider */
+		std::shared_ptr<provider_t> provider;
+/* Mainloop procesing thread. */
+		std::unique_ptr<boost::thread> thread;
+/* Chain of each streaming request by client handle and token. */
+		boost::unordered_map<std::pair<uintptr_t, int32_t>, std::shared_ptr<subscription_stream_t>> subscriptions;
+/* Requests parked on an in-flight chain resolution by name. */
+		boost::unordered_map<std::string, std::vector<request_t>> parked;
+
+/** Performance Counters **/
+		uint32_t cumulative_stats[CHAINY_PC_MAX];
+	};
+
+/* Upstream connection over a partition of chains by root name with the
+ * consumer thread state of those chains.
+ */
+	class consumer_shard_t
+		: public consumer_t::Delegate	/* Service status */
+	{
+	public:
+		explicit consumer_shard_t (chainy_t* chainy, unsigned index, const chain_templates_t& chain_templates);
+
+		virtual bool OnSync() override;
+		virtual bool OnWrite (std::shared_ptr<item_stream_t> item_stream, const uint8_t rwf_major_version, const uint8_t rwf_minor_version, RsslMsg* msg) override;
+		virtual bool OnDictionary (const RsslDataDictionary& dictionary) override;
+		virtual bool OnClose (std::shared_ptr<item_stream_t> item_stream) override;
+		virtual void OnIdle() override;
+
+		chainy_t*const chainy;
+		const unsigned index;
+/* UPA consumer */
+		std::shared_ptr<consumer_t> consumer;
+/* Mainloop procesing thread. */
+		std::unique_ptr<boost::thread> thread;
+/* Service synchronised at least once. */
+		bool is_synchronized;
+/* Chains opened on demand awaiting the final link. */
+		boost::unordered_set<std::string> resolving;
+/* Approximate memory of the chains of the shard. */
+		size_t chain_memory;
+/* Link layouts compiled against the field dictionary of this connection. */
+		chain_templates_t chain_templates;
+/* Fields of the link record being applied, reused. */
+		std::vector<scanned_field_t> link_fields;
+/* Reclamation of chain versions published by this shard. */
+		epoch_t epoch;
+
+/** Performance Counters **/
+		uint32_t cumulative_stats[CHAINY_PC_MAX];
+	};
+
 	class chainy_t
 /* Permit global weak pointer to application instance for shutdown notification. */
 		: public std::enable_shared_from_this<chainy_t>
-		, public client_t::Delegate	/* Rssl requests */
-		, public consumer_t::Delegate	/* Service status */
 	{
 	public:
 		explicit chainy_t();
@@ -77,18 +293,20 @@ namespace chainy
 /* Quit an earlier call to Run(). */
 		void Quit();
 
-		virtual bool OnSync() override;
-		virtual bool OnTrigger() override;
-		virtual bool OnWrite (std::shared_ptr<item_stream_t> item_stream, const uint8_t rwf_major_version, const uint8_t rwf_minor_version, RsslMsg* msg) override;
-		virtual bool OnRequest (uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates) override;
+		bool OnSync (consumer_shard_t* shard);
+		bool OnWrite (consumer_shard_t* shard, std::shared_ptr<item_stream_t> item_stream, const uint8_t rwf_major_version, const uint8_t rwf_minor_version, RsslMsg* msg);
+		bool OnDictionary (consumer_shard_t* shard, const RsslDataDictionary& dictionary);
+		bool OnClose (consumer_shard_t* shard, std::shared_ptr<item_stream_t> item_stream);
+		bool OnRequest (provider_shard_t* shard, uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates, bool is_streaming);
+		bool OnCancel (provider_shard_t* shard, uintptr_t handle, int32_t token);
 
 		bool Initialize();
 		void Reset();
 
 	private:
 /* Run core event loop. */
-		void ConsumerLoop();
-		void ProviderLoop();
+		void ConsumerLoop (consumer_shard_t* shard);
+		void ProviderLoop (provider_shard_t* shard);
 
 /* Start the encapsulated provider instance until Stop is called.  Stop may be
  * called to pre-emptively prevent execution.
@@ -96,33 +314,69 @@ namespace chainy
 		bool Start();
 		void Stop();
 
-		bool CheckTrigger (const uint8_t rwf_major_version, const uint8_t rwf_minor_version, RsslMsg* msg);
-		bool WriteRaw (uint16_t rwf_version, int32_t token, uint16_t service_id, const chromium::StringPiece& item_name, const chromium::StringPiece& dacs_lock, unsigned part_number, bool is_complete, const std::vector<std::string>& symbol_list, void* data, size_t* length);
-		bool WriteRaw (uint16_t rwf_version, int32_t token, uint16_t service_id, const chromium::StringPiece& item_name, const chromium::StringPiece& dacs_lock, unsigned part_number, bool is_complete, RsslPayloadEntryHandle handle, void* data, size_t* length);
-
-/* Mainloop procesing threads. */
-		std::unique_ptr<boost::thread> consumer_thread_, provider_thread_;
+		int DetectTemplate (consumer_shard_t* shard, const std::vector<scanned_field_t>& fields);
+		consumer_shard_t* GetConsumerShard (const std::string& item_name);
+		std::shared_ptr<subscription_stream_t> CreateChain (consumer_shard_t* shard, const std::string& item_name);
+		void ExpandChain (std::shared_ptr<subscription_stream_t> chain, unsigned depth, boost::unordered_set<std::string>* path, boost::unordered_set<std::string>* seen, std::vector<std::string>* expanded);
+		void ResolveChain (consumer_shard_t* shard, const std::string& item_name);
+		void PostResolveChain (const std::string& item_name);
+		void PostChainResolved (const std::string& item_name);
+		void OnChainResolved (provider_shard_t* shard, const std::string& item_name);
+		void RemoveChain (std::shared_ptr<subscription_stream_t> chain);
+		void EvictChains (consumer_shard_t* shard);
+		void DropChain (provider_shard_t* shard, std::shared_ptr<subscription_stream_t> chain);
+		std::shared_ptr<subscription_stream_t> CreateLink (std::shared_ptr<subscription_stream_t> parent, const std::string& link_name, bool is_speculative);
+		void CloseLink (std::shared_ptr<subscription_stream_t> link);
+		void ReconcileLinks (std::shared_ptr<subscription_stream_t> parent);
+		void PublishLinks (std::shared_ptr<subscription_stream_t> parent, const std::vector<std::shared_ptr<subscription_stream_t>>& links, boost::unordered_map<std::string, int>* delta);
+		bool PostUpdates (std::shared_ptr<subscription_stream_t> parent, const boost::unordered_map<std::string, int>& delta);
+		void PostToShards (const std::function<void (provider_shard_t*)>& task);
+		void SendUpdates (provider_shard_t* shard, std::shared_ptr<subscription_stream_t> parent, const symbol_delta_t& delta);
+		void PublishVersion (std::shared_ptr<subscription_stream_t> parent);
+		void RefreshSubscribers (provider_shard_t* shard, std::shared_ptr<subscription_stream_t> chain);
+		bool SendRefresh (provider_shard_t* shard, std::shared_ptr<subscription_stream_t> stream, const subscriber_t& subscriber, bool is_streaming, bool is_solicited);
+		bool SendClose (provider_shard_t* shard, const std::string& item_name, const subscriber_t& subscriber, uint8_t stream_state, uint8_t status_code, const std::string& status_text);
+		unsigned LoadSnapshot();
+		void WriteSnapshot();
+		bool EncodeRefresh (const chain_version_t& version, const chromium::StringPiece& item_name, uint16_t rwf_version, uint16_t service_id, uint32_t max_part_size, encoded_refresh_t* encoded);
+		bool WriteRaw (uint16_t rwf_version, int32_t token, uint16_t service_id, const chromium::StringPiece& item_name, const chromium::StringPiece& dacs_lock, unsigned part_number, bool is_complete, bool is_streaming, uint8_t data_state, const std::vector<chromium::StringPiece>& symbol_list, size_t* offset, void* data, size_t* length);
+		bool WriteRawUpdate (uint16_t rwf_version, int32_t token, uint16_t service_id, const chromium::StringPiece& item_name, bool use_attribinfo_in_updates, const symbol_delta_t& delta, size_t* offset, void* data, size_t* length);
 
 /* Asynchronous shutdown notification mechanism. */
 		boost::condition_variable consumer_cond_, provider_cond_;
 		boost::mutex consumer_lock_, provider_lock_;
-		bool consumer_shutdown_, provider_shutdown_;
+/* Consumer and provider threads yet to return. */
+		unsigned consumer_running_;
+		unsigned provider_running_;
 /* Flag to indicate Stop has be called and thus prohibit start of new provider. */
 		boost::atomic_bool shutting_down_;
 /* Application configuration. */
 		config_t config_;
 /* UPA context. */
 		std::shared_ptr<upa_t> upa_;
-/* UPA provider */
-		std::shared_ptr<provider_t> provider_;	
-/* UPA consumer */
-		std::shared_ptr<consumer_t> consumer_;	
+/* UPA provider worker loops, shard zero accepts connections. */
+		std::vector<std::unique_ptr<provider_shard_t>> shards_;
+/* UPA consumer connections, chains are partitioned across each by root name. */
+		std::vector<std::unique_ptr<consumer_shard_t>> consumer_shards_;
+/* Consumer shards synchronised, requests are accepted once every shard is. */
+		std::atomic<unsigned> synchronized_count_;
 /* Item stream. */
                 boost::unordered_map<std::string, std::shared_ptr<subscription_stream_t>> streams_;
-/* As worker state: */
-/* Rssl message buffers */
-		char provider_rssl_buf_[MAX_MSG_SIZE], consumer_rssl_buf_[MAX_MSG_SIZE];
-		size_t provider_rssl_length_, consumer_rssl_length_;
+/* Chains are added by consumer threads whilst provider threads look up requests. */
+		boost::shared_mutex streams_lock_;
+/* Chains with a resolution posted on behalf of parked requests. */
+		boost::unordered_set<std::string> requested_;
+		boost::mutex requested_lock_;
+/* Orders requests for least recently used eviction. */
+		std::atomic<uint64_t> access_sequence_;
+/* Link layouts as configured, compiled by each consumer shard. */
+		chain_templates_t chain_templates_;
+/* Resolved chains retained between restarts. */
+		std::unique_ptr<chain_snapshot_t> snapshot_;
+
+/** Performance Counters **/
+		uint32_t cumulative_stats_[CHAINY_PC_MAX];
+		uint64_t versions_reclaimed_;
 	};
 
 } /* namespace chainy */
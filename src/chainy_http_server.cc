@@ -23,7 +23,12 @@ namespace {
 
 chainy::ConsumerInfo::ConsumerInfo()
 	: is_active (false)
-	, msgs_received (0) {
+	, msgs_received (0)
+	, item_streams (0)
+	, item_streams_closed (0)
+	, is_standby_active (false)
+	, standby_msgs_received (0)
+	, standby_promoted (0) {
 }
 
 chainy::ConsumerInfo::~ConsumerInfo() {
@@ -155,6 +160,12 @@ chainy::ChainyHttpServer::OnWebSocketMessage (
 			dict->SetString("app", info.app);
 			dict->SetBoolean("is_active", info.is_active);
 			dict->SetInteger("consumer_msgs", info.msgs_received);
+			dict->SetInteger("item_streams", info.item_streams);
+			dict->SetInteger("item_streams_closed", info.item_streams_closed);
+			dict->SetString("standby_ip", info.standby_ip);
+			dict->SetBoolean("is_standby_active", info.is_standby_active);
+			dict->SetInteger("standby_msgs", info.standby_msgs_received);
+			dict->SetInteger("standby_promoted", info.standby_promoted);
 			chromium::JSONWriter::Write(dict.get(), &message);
 			message_loop_for_io_->PostTask ([this, connection_id, message]() {
 				server_->SendOverWebSocket(connection_id, message);
@@ -235,6 +246,12 @@ chainy::ChainyHttpServer::OnJsonRequestUI (
 			dict.SetString("app", info.app);
 			dict.SetBoolean("is_active", info.is_active);
 			dict.SetInteger("consumer_msgs", info.msgs_received);
+			dict.SetInteger("item_streams", info.item_streams);
+			dict.SetInteger("item_streams_closed", info.item_streams_closed);
+			dict.SetString("standby_ip", info.standby_ip);
+			dict.SetBoolean("is_standby_active", info.is_standby_active);
+			dict.SetInteger("standby_msgs", info.standby_msgs_received);
+			dict.SetInteger("standby_promoted", info.standby_promoted);
 			chromium::JSONWriter::Write(&dict, &json);
 			message_loop_for_io_->PostTask ([this, connection_id, json]() {
 				std::unique_ptr<chromium::DictionaryValue> dict (static_cast<chromium::DictionaryValue*>(chromium::JSONReader::Read (json, false)));
@@ -245,6 +262,17 @@ chainy::ChainyHttpServer::OnJsonRequestUI (
 				dict->SetInteger("pid", info.pid);
 				dict->SetInteger("clients", info.client_count);
 				dict->SetInteger("provider_msgs", info.msgs_received);
+				chromium::ListValue* sessions = new chromium::ListValue;
+				for (const auto& session : info.sessions) {
+					chromium::DictionaryValue* value = new chromium::DictionaryValue;
+					value->SetString("address", session.address);
+					value->SetInteger("shard", session.shard);
+					value->SetInteger("queued_msgs", session.queued_msgs);
+					value->SetInteger("queued_bytes", session.queued_bytes);
+					value->SetInteger("lag", session.lag);
+					sessions->Append (value);
+				}
+				dict->Set("sessions", sessions);
 				SendJson(connection_id, net::HTTP_OK, dict.get(), std::string());
 			});
 		});
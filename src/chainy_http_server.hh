@@ -6,6 +6,8 @@
 
 #ifdef _WIN32
 #	include <winsock2.h>
+#else
+#	include <netinet/in.h>
 #endif
 
 #include <string>
@@ -34,6 +36,20 @@ namespace chainy
 		std::string app;	/* e.g. ADS */
 		bool is_active;
 		unsigned msgs_received;
+		unsigned item_streams;		/* open upstream streams, roots and links */
+		unsigned item_streams_closed;	/* streams closed and released */
+		std::string standby_ip;		/* empty without a warm standby */
+		bool is_standby_active;
+		unsigned standby_msgs_received;
+		unsigned standby_promoted;	/* failovers to the standby */
+	};
+
+	struct SessionInfo {
+		std::string address;
+		unsigned shard;
+		unsigned queued_msgs;		/* messages awaiting flush */
+		unsigned queued_bytes;		/* bytes in the RSSL output queue */
+		unsigned lag;			/* seconds above a queue high-water mark */
 	};
 
 	struct ProviderInfo {
@@ -45,6 +61,7 @@ namespace chainy
 		int pid;
 		unsigned client_count;	/* all RSSL port connections, active or not */
 		unsigned msgs_received; /* all message types including metadata */
+		std::vector<SessionInfo> sessions;
 	};
 
 	class ChainyHttpServer
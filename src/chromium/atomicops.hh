@@ -117,7 +117,13 @@ Atomic64 Release_Load(volatile const Atomic64* ptr);
 }  // namespace chromium
 
 // Include our platform specific implementation.
+#if defined(_MSC_VER)
 #include "chromium/atomicops_internals_x86_msvc.hh"
+#elif defined(__GNUC__)
+#include "chromium/atomicops_internals_gcc.hh"
+#else
+#error "Atomic operations are not supported on your platform"
+#endif
 
 #endif  // CHROMIUM_ATOMICOPS_HH__
 
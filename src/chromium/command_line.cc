@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <ostream>
 
+#include "chromium/basictypes.hh"
 #include "chromium/logging.hh"
 #include "chromium/strings/string_split.hh"
 #include "chromium/strings/string_util.hh"
@@ -21,7 +22,7 @@ const CommandLine::CharType kSwitchValueSeparator[] = "=";
 const CommandLine::CharType* const kSwitchPrefixes[] = {"--", "-"};
 
 size_t GetSwitchPrefixLength(const CommandLine::StringType& string) {
-  for (size_t i = 0; i < _countof(kSwitchPrefixes); ++i) {
+  for (size_t i = 0; i < arraysize(kSwitchPrefixes); ++i) {
     CommandLine::StringType prefix(kSwitchPrefixes[i]);
     if (string.compare(0, prefix.length(), prefix) == 0)
       return prefix.length();
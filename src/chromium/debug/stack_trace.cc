@@ -9,12 +9,14 @@
 #include <algorithm>
 #include <sstream>
 
+#include "chromium/basictypes.hh"
+
 namespace chromium {
 namespace debug {
 
 StackTrace::StackTrace(const void* const* trace, size_t count)
 {
-  count = std::min(count, _countof (trace_));
+  count = std::min(count, arraysize(trace_));
   if (count)
     memcpy(trace_, trace, count * sizeof(trace_[0]));
   count_ = static_cast<int>(count);
@@ -9,7 +9,9 @@
 #include <iosfwd>
 #include <string>
 
+#if defined(_WIN32)
 struct _EXCEPTION_POINTERS;
+#endif
 
 namespace chromium {
 namespace debug {
@@ -27,10 +29,12 @@ class StackTrace {
   // trimmed to |kMaxTraces|.
   StackTrace(const void* const* trace, size_t count);
 
+#if defined(_WIN32)
   // Creates a stacktrace for an exception.
   // Note: this function will throw an import not found (StackWalk64) exception
   // on system without dbghelp 5.1.
   StackTrace(_EXCEPTION_POINTERS* exception_pointers);
+#endif
 
   // Copying and assignment are allowed with the default functions.
 
@@ -0,0 +1,81 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chromium/debug/stack_trace.hh"
+
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#include "chromium/basictypes.hh"
+
+namespace chromium {
+namespace debug {
+
+namespace {
+
+// Demangles C++ symbols in the given text, symbols are of the form
+// "module(_Z3foov+0x1a) [0x4005d4]" as returned by backtrace_symbols().
+void DemangleSymbols(std::string* text) {
+  const std::string::size_type mangled_start = text->find("(_Z");
+  if (mangled_start == std::string::npos)
+    return;
+  const std::string::size_type mangled_end =
+      text->find_first_of(")+", mangled_start);
+  if (mangled_end == std::string::npos)
+    return;
+  const std::string mangled_symbol =
+      text->substr(mangled_start + 1, mangled_end - mangled_start - 1);
+  int status = 0;
+  std::unique_ptr<char, void(*)(void*)> demangled_symbol(
+      abi::__cxa_demangle(mangled_symbol.c_str(), NULL, 0, &status), free);
+  if (status == 0 && demangled_symbol)
+    text->replace(mangled_start + 1, mangled_symbol.size(),
+                  demangled_symbol.get());
+}
+
+}  // namespace
+
+StackTrace::StackTrace()
+{
+  // Though the backtrace API man page does not list any possible negative
+  // return values, we take no chance.
+  count_ = std::max(backtrace(trace_, arraysize(trace_)), 0);
+}
+
+void
+StackTrace::PrintBacktrace() const
+{
+  // Async-signal safe, no allocation.
+  backtrace_symbols_fd(trace_, count_, STDERR_FILENO);
+}
+
+void
+StackTrace::OutputToStream(std::ostream* os) const
+{
+  std::unique_ptr<char*, void(*)(void*)> trace_symbols(
+      backtrace_symbols(trace_, count_), free);
+  if (!trace_symbols) {
+    (*os) << "Unable to get symbols for backtrace.  Dumping raw addresses in "
+          << "trace:\n";
+    for (int i = 0; (i < count_) && os->good(); ++i) {
+      (*os) << "\t" << trace_[i] << "\n";
+    }
+    return;
+  }
+  (*os) << "Backtrace:\n";
+  for (int i = 0; (i < count_) && os->good(); ++i) {
+    std::string trace_symbol(trace_symbols.get()[i]);
+    DemangleSymbols(&trace_symbol);
+    (*os) << "\t" << trace_symbol << "\n";
+  }
+}
+
+}  // namespace debug
+}  // namespace chromium
@@ -0,0 +1,57 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chromium/files/file_util.hh"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace chromium {
+
+namespace {
+
+int CallStat(const char* path, stat_wrapper_t* sb) {
+  return stat64(path, sb);
+}
+
+}  // namespace
+
+void File::Info::FromStat(const stat_wrapper_t& stat_info) {
+  is_directory = S_ISDIR(stat_info.st_mode);
+  is_symbolic_link = S_ISLNK(stat_info.st_mode);
+  size = stat_info.st_size;
+  last_modified = stat_info.st_mtime;
+  last_accessed = stat_info.st_atime;
+  creation_time = stat_info.st_ctime;
+}
+
+bool PathExists(const std::string& path) {
+  return access(path.c_str(), F_OK) == 0;
+}
+
+bool GetFileInfo(const std::string& file_path, File::Info* results) {
+  stat_wrapper_t file_info;
+  if (CallStat(file_path.c_str(), &file_info) != 0)
+    return false;
+  results->FromStat(file_info);
+  return true;
+}
+
+}  // namespace chromium
+
+// -----------------------------------------------------------------------------
+
+namespace file_util {
+
+FILE* OpenFile(const std::string& filename, const char* mode) {
+  FILE* result = NULL;
+  do {
+    result = fopen(filename.c_str(), mode);
+  } while (!result && errno == EINTR);
+  return result;
+}
+
+}  // namespace file_util
@@ -19,6 +19,8 @@
 #ifndef CHROMIUM_MEMORY_SINGLETON_HH__
 #define CHROMIUM_MEMORY_SINGLETON_HH__
 
+#include <cstddef>
+
 #include "chromium/atomicops.hh"
 
 namespace chromium {
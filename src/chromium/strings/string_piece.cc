@@ -4,6 +4,8 @@
 // Copied from strings/stringpiece.cc with modifications
 
 #include <algorithm>
+#include <climits>
+#include <cstring>
 #include <ostream>
 
 #include "chromium/strings/string_piece.hh"
@@ -14,10 +16,7 @@ namespace chromium {
 #if !defined(_MSC_VER)
 namespace internal {
 template class StringPieceDetail<std::string>;
-template class StringPieceDetail<string16>;
 }  // namespace internal
-
-template class BasicStringPiece<string16>;
 #endif
 
 bool operator==(const StringPiece& x, const StringPiece& y) {
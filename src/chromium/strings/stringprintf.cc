@@ -7,7 +7,9 @@
 #include <vector>
 #include <errno.h>
 
+#include "chromium/basictypes.hh"
 #include "chromium/logging.hh"
+#include "chromium/port.hh"
 #include "chromium/strings/string_util.hh"
 
 namespace chromium {
@@ -54,17 +56,17 @@ static void StringAppendVT(StringType* dst,
 #if !defined(_WIN32)
   errno = 0;
 #endif
-  int result = vsnprintfT(stack_buf, _countof(stack_buf), format, ap_copy);
+  int result = vsnprintfT(stack_buf, arraysize(stack_buf), format, ap_copy);
   va_end(ap_copy);
 
-  if (result >= 0 && result < static_cast<int>(_countof(stack_buf))) {
+  if (result >= 0 && result < static_cast<int>(arraysize(stack_buf))) {
     // It fit.
     dst->append(stack_buf, result);
     return;
   }
 
   // Repeatedly increase buffer size until it fits.
-  int mem_length = _countof(stack_buf);
+  int mem_length = arraysize(stack_buf);
   while (true) {
     if (result < 0) {
 #if !defined(_WIN32)
@@ -5,7 +5,11 @@
 #ifndef CHROMIUM_LOCK_IMPL_HH__
 #define CHROMIUM_LOCK_IMPL_HH__
 
+#if defined(_WIN32)
 #include <winsock2.h>
+#elif defined(OS_POSIX)
+#include <pthread.h>
+#endif
 
 namespace chromium {
 namespace internal {
@@ -16,7 +20,11 @@ namespace internal {
 class LockImpl
 {
 public:
+#if defined(_WIN32)
 	typedef CRITICAL_SECTION OSLockType;
+#elif defined(OS_POSIX)
+	typedef pthread_mutex_t OSLockType;
+#endif
 
 	explicit LockImpl();
 	~LockImpl();
@@ -0,0 +1,66 @@
+/* lock_impl.cc
+ *
+ * A basic platform specific lock.
+ *
+ * Copyright (c) 2011 The Chromium Authors. All rights reserved.
+ */
+
+#include "chromium/synchronization/lock_impl.hh"
+
+#include <errno.h>
+#include <string.h>
+
+#include "chromium/logging.hh"
+
+namespace chromium {
+namespace internal {
+
+LockImpl::LockImpl() {
+#ifndef NDEBUG
+/* In debug, setup attributes for lock error checking. */
+	pthread_mutexattr_t mta;
+	int rv = pthread_mutexattr_init (&mta);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+	rv = pthread_mutexattr_settype (&mta, PTHREAD_MUTEX_ERRORCHECK);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+	rv = pthread_mutex_init (&os_lock_, &mta);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+	rv = pthread_mutexattr_destroy (&mta);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+#else
+/* In release, go with the default lock attributes. */
+	pthread_mutex_init (&os_lock_, nullptr);
+#endif
+}
+
+LockImpl::~LockImpl() {
+	const int rv = pthread_mutex_destroy (&os_lock_);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+}
+
+bool
+LockImpl::Try()
+{
+	const int rv = pthread_mutex_trylock (&os_lock_);
+	DCHECK(rv == 0 || rv == EBUSY) << ". " << strerror (rv);
+	return rv == 0;
+}
+
+void
+LockImpl::Lock()
+{
+	const int rv = pthread_mutex_lock (&os_lock_);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+}
+
+void
+LockImpl::Unlock()
+{
+	const int rv = pthread_mutex_unlock (&os_lock_);
+	DCHECK_EQ(rv, 0) << ". " << strerror (rv);
+}
+
+} /* namespace internal */
+} /* namespace chromium */
+
+/* eof */
@@ -0,0 +1,106 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chromium/time/time.hh"
+
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "chromium/basictypes.hh"
+#include "chromium/logging.hh"
+
+using chromium::Time;
+
+// Time -----------------------------------------------------------------------
+
+// Windows uses a Gregorian epoch of 1601.  We need to match this internally
+// so that our time representations match across all platforms.
+//   irb(main):010:0> Time.at(0).getutc()
+//   => Thu Jan 01 00:00:00 UTC 1970
+//   irb(main):011:0> Time.at(-11644473600).getutc()
+//   => Mon Jan 01 00:00:00 UTC 1601
+// static
+const int64_t Time::kWindowsEpochDeltaMicroseconds = 11644473600000000LL;
+
+// static
+const int64_t Time::kTimeTToMicrosecondsOffset = kWindowsEpochDeltaMicroseconds;
+
+// static
+Time Time::NowFromSystemTime() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+    NOTREACHED() << "clock_gettime(CLOCK_REALTIME) failed.";
+    return Time();
+  }
+  return Time((static_cast<int64_t>(ts.tv_sec) * kMicrosecondsPerSecond) +
+              (ts.tv_nsec / kNanosecondsPerMicrosecond) +
+              kTimeTToMicrosecondsOffset);
+}
+
+// static
+Time Time::FromExploded(bool is_local, const Exploded& exploded) {
+  struct tm timestruct;
+  memset(&timestruct, 0, sizeof(timestruct));
+  timestruct.tm_sec    = exploded.second;
+  timestruct.tm_min    = exploded.minute;
+  timestruct.tm_hour   = exploded.hour;
+  timestruct.tm_mday   = exploded.day_of_month;
+  timestruct.tm_mon    = exploded.month - 1;
+  timestruct.tm_year   = exploded.year - 1900;
+  timestruct.tm_wday   = exploded.day_of_week;  // mktime/timegm ignore this
+  timestruct.tm_yday   = 0;     // mktime/timegm ignore this
+  timestruct.tm_isdst  = -1;    // attempt to figure it out
+
+  time_t seconds = is_local ? mktime(&timestruct) : timegm(&timestruct);
+  if (seconds == -1) {
+    NOTREACHED() << "Unable to convert time";
+    return Time(0);
+  }
+  return Time((static_cast<int64_t>(seconds) * kMicrosecondsPerSecond) +
+              (exploded.millisecond * kMicrosecondsPerMillisecond) +
+              kTimeTToMicrosecondsOffset);
+}
+
+void Time::Explode(bool is_local, Exploded* exploded) const {
+  // Time stores times with microsecond resolution, but Exploded only carries
+  // millisecond resolution, so begin by being lossy.  Adjust from Windows
+  // epoch (1601) to Unix epoch (1970);
+  const int64_t microseconds = us_ - kTimeTToMicrosecondsOffset;
+  // The following values are all rounded towards -infinity.
+  int64_t milliseconds;  // Milliseconds since epoch.
+  time_t seconds;        // Seconds since epoch.
+  int millisecond;       // Exploded millisecond value (0-999).
+  if (microseconds >= 0) {
+    // Rounding towards -infinity <=> rounding towards 0, in this case.
+    milliseconds = microseconds / kMicrosecondsPerMillisecond;
+    seconds = static_cast<time_t>(milliseconds / kMillisecondsPerSecond);
+    millisecond = static_cast<int>(milliseconds % kMillisecondsPerSecond);
+  } else {
+    // Round these *down* (towards -infinity).
+    milliseconds = (microseconds - kMicrosecondsPerMillisecond + 1) /
+                   kMicrosecondsPerMillisecond;
+    seconds = static_cast<time_t>((milliseconds - kMillisecondsPerSecond + 1) /
+                                  kMillisecondsPerSecond);
+    // Make this nonnegative (and between 0 and 999 inclusive).
+    millisecond = static_cast<int>(milliseconds % kMillisecondsPerSecond);
+    if (millisecond < 0)
+      millisecond += static_cast<int>(kMillisecondsPerSecond);
+  }
+
+  struct tm timestruct;
+  if (is_local)
+    localtime_r(&seconds, &timestruct);
+  else
+    gmtime_r(&seconds, &timestruct);
+
+  exploded->year         = timestruct.tm_year + 1900;
+  exploded->month        = timestruct.tm_mon + 1;
+  exploded->day_of_week  = timestruct.tm_wday;
+  exploded->day_of_month = timestruct.tm_mday;
+  exploded->hour         = timestruct.tm_hour;
+  exploded->minute       = timestruct.tm_min;
+  exploded->second       = timestruct.tm_sec;
+  exploded->millisecond  = millisecond;
+}
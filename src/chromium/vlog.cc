@@ -4,6 +4,7 @@
 
 #include "chromium/vlog.hh"
 
+#include "chromium/basictypes.hh"
 #include "chromium/logging.hh"
 #include "chromium/strings/string_split.hh"
 
@@ -81,7 +82,7 @@ chromium::StringPiece GetModule(const chromium::StringPiece& file) {
   chromium::StringPiece::size_type extension_start = module.rfind('.');
   module = module.substr(0, extension_start);
   static const char kInlSuffix[] = "-inl";
-  static const int kInlSuffixLen = _countof(kInlSuffix) - 1;
+  static const int kInlSuffixLen = arraysize(kInlSuffix) - 1;
   if (module.ends_with(kInlSuffix))
     module.remove_suffix(kInlSuffixLen);
   return module;
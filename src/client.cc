@@ -4,9 +4,12 @@
 #include "client.hh"
 
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
-#include <windows.h>
+#if defined(_WIN32)
+#	include <windows.h>
+#endif
 
 #include "chromium/logging.hh"
 #include "chromium/strings/string_piece.hh"
@@ -16,12 +19,16 @@
 
 #define MAX_MSG_SIZE 4096
 
+/* RIPC length prefix of each message in a packed buffer. */
+static const uint32_t kPackedHeaderSize = 2;
+
 static const std::string kErrorNone = "";
 static const std::string kErrorUnsupportedMsgClass = "Unsupported message class.";
 static const std::string kErrorUnsupportedRequest = "Unsupported domain type in request.";
 static const std::string kErrorUnsupportedDictionary = "Unsupported dictionary request.";
 static const std::string kErrorUnsupportedNonStreaming = "Unsupported non-streaming request.";
 static const std::string kErrorLoginRequired = "Login required for request.";
+static const std::string kErrorBacklogged = "Outbound queue full, please re-request.";
 
 
 chainy::client_t::client_t (
@@ -30,18 +37,31 @@ chainy::client_t::client_t (
 	RsslChannel* handle,
 	const char* address
 	) :
-	creation_time_ (boost::posix_time::second_clock::universal_time()),
+	creation_time_ (MonotonicTicks()),
 	last_activity_ (creation_time_),
 	provider_ (provider),
 	delegate_ (delegate),
 	address_ (address),
 	handle_ (handle),
 	pending_count_ (0),
+	queued_bytes_ (0),
+	max_queued_bytes_ (0),
+	backlog_start_ (0),
+	lag_ (0),
+	pack_buf_ (nullptr),
+	pack_length_ (0),
+	pack_space_ (0),
+	pack_count_ (0),
+	is_flush_pending_ (false),
+	max_fragment_size_ (0),
 	is_logged_in_ (false),
-	login_token_ (0)
+	login_token_ (0),
+	next_ping_ (0),
+	next_pong_ (0),
+	keepalive_timer_ (this)
 {
-	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
-	ZeroMemory (snap_stats_, sizeof (snap_stats_));
+	memset (cumulative_stats_, 0, sizeof (cumulative_stats_));
+	memset (snap_stats_, 0, sizeof (snap_stats_));
 
 /* Set logger ID */
 	std::ostringstream ss;
@@ -69,16 +89,24 @@ chainy::client_t::client_t (
 chainy::client_t::~client_t()
 {
 	DLOG(INFO) << "~client_t";
+/* Replies never written are returned to the channel pool. */
+	ReleasePack();
+	keepalive_timer_.Cancel();
 /* Remove reference on containing provider. */
 	provider_.reset();
 
 	using namespace boost::posix_time;
-	const auto uptime = second_clock::universal_time() - creation_time_;
+	const auto uptime = milliseconds (MonotonicTicks() - creation_time_);
 	VLOG(3) << prefix_ << "Summary: {"
 		 " \"Uptime\": \"" << to_simple_string (uptime) << "\""
 		", \"MsgsReceived\": " << cumulative_stats_[CLIENT_PC_RSSL_MSGS_RECEIVED] <<
 		", \"MsgsSent\": " << cumulative_stats_[CLIENT_PC_RSSL_MSGS_SENT] <<
+		", \"MsgsPacked\": " << cumulative_stats_[CLIENT_PC_RSSL_MSGS_PACKED] <<
+		", \"PackedBuffersSent\": " << cumulative_stats_[CLIENT_PC_RSSL_PACKED_BUFFERS_SENT] <<
 		", \"MsgsRejected\": " << cumulative_stats_[CLIENT_PC_RSSL_MSGS_REJECTED] <<
+		", \"MaxQueuedBytes\": " << max_queued_bytes_ <<
+		", \"QueueHighWater\": " << cumulative_stats_[CLIENT_PC_QUEUE_HIGH_WATER] <<
+		", \"RequestsShed\": " << cumulative_stats_[CLIENT_PC_ITEM_REQUEST_SHED] <<
 		" }";
 }
 
@@ -90,7 +118,7 @@ chainy::client_t::Initialize()
 	RsslRet rc;
 
 	DCHECK(nullptr != handle_);
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = provider_->last_activity_;
 
 /* Relog negotiated state. */
 	std::stringstream client_hostname, client_ip;
@@ -156,15 +184,36 @@ chainy::client_t::Initialize()
                 ", \"tcpRecvBufSize\": " << static_cast<unsigned> (info.tcpRecvBufSize) << ""
                 ", \"tcpSendBufSize\": " << static_cast<unsigned> (info.tcpSendBufSize) << ""
                 " }";
+	max_fragment_size_ = info.maxFragmentSize;
 /* Derive expected RSSL ping interval from negotiated timeout. */
 	ping_interval_ = handle_->pingTimeout / 3;
 /* Schedule first RSSL ping. */
-	next_ping_ = last_activity_ + boost::posix_time::seconds (ping_interval_);
+	next_ping_ = last_activity_ + SecondsToTicks (ping_interval_);
 /* Treat connect as first RSSL pong. */
-	next_pong_ = last_activity_ + boost::posix_time::seconds (handle_->pingTimeout);
+	next_pong_ = last_activity_ + SecondsToTicks (handle_->pingTimeout);
+	provider_->ScheduleKeepalive (this);
 	return true;
 }
 
+/* Keepalive deadlines re-arm the session timer on the provider loop. */
+void
+chainy::client_t::SetNextPing (
+	ticks_t time_
+	)
+{
+	next_ping_ = time_;
+	provider_->ScheduleKeepalive (this);
+}
+
+void
+chainy::client_t::SetNextPong (
+	ticks_t time_
+	)
+{
+	next_pong_ = time_;
+	provider_->ScheduleKeepalive (this);
+}
+
 /* Propagate close notification to RSSL channel before closing the socket.
  */
 bool
@@ -176,6 +225,8 @@ chainy::client_t::Close()
 		is_logged_in_ = false;
 /* drop active requests. */
 		VLOG(2) << prefix_ << "Removing " << tokens_.size() << " item streams.";
+		for (const auto& token : tokens_)
+			delegate_->OnCancel (reinterpret_cast<uintptr_t> (handle_), token);
 		tokens_.clear();
 /* notify client session is no longer valid via login stream. */
 		return SendClose (
@@ -930,11 +981,25 @@ chainy::client_t::OnItemRequest (
 		cumulative_stats_[CLIENT_PC_ITEM_REISSUE_REQUEST_RECEIVED]++;
 /* Explicitly ignore reissue as it does not alter response data. */
 		return true;
+	} else if (IsBacklogged()) {
+/* Shed new requests whilst the outbound queue is above a high-water mark,
+ * updates to open streams continue such that images remain consistent.
+ */
+		cumulative_stats_[CLIENT_PC_ITEM_REQUEST_REJECTED]++;
+		cumulative_stats_[CLIENT_PC_ITEM_REQUEST_SHED]++;
+		return SendClose (
+			request_token,
+			service_id,
+			model_type,
+			item_name,
+			use_attribinfo_in_updates,
+			RSSL_STREAM_CLOSED_RECOVER, RSSL_SC_TOO_MANY_ITEMS, kErrorBacklogged
+			);
 	} else {
 		tokens_.emplace (request_token);
 	}
 
-	return delegate_->OnRequest (reinterpret_cast<uintptr_t> (handle_), rwf_version(), request_token, service_id, item_name, use_attribinfo_in_updates);
+	return delegate_->OnRequest (reinterpret_cast<uintptr_t> (handle_), rwf_version(), request_token, service_id, item_name, use_attribinfo_in_updates, is_streaming_request);
 }
 
 bool
@@ -943,42 +1008,46 @@ chainy::client_t::OnSourceDirectoryUpdate()
 	return SendDirectoryUpdate (directory_token_, provider_->service_name().c_str());
 }
 
-bool
-chainy::client_t::SendReply (
-	int32_t request_token,
-	const void* data,
-	size_t length,
-	bool and_close
+/* Consecutive replies share one packed buffer written at the end of the loop
+ * iteration, larger replies take a channel buffer of exactly the requested size
+ * as repacked refresh parts may exceed MAX_MSG_SIZE.  The returned length may
+ * exceed the request when the packed free space is larger.
+ */
+RsslBuffer*
+chainy::client_t::GetReplyBuffer (
+	size_t length
 	)
 {
-	RsslBuffer* buf;
+	if (length + kPackedHeaderSize <= max_fragment_size_)
+		return ReservePack (length);
 	RsslError rssl_err;
-	DCHECK(length <= MAX_MSG_SIZE);
-	if (and_close) {
-/* Drop response if token already canceled */
-		if (0 == tokens_.erase (request_token))
-			return true;
-	}
-/* Copy into RSSL channel buffer pool */
-	buf = rsslGetBuffer (handle_, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
+	RsslBuffer* buf = rsslGetBuffer (handle_, static_cast<uint32_t> (length), RSSL_FALSE /* not packed */, &rssl_err);
 	if (nullptr == buf) {
 		LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
-			", \"size\": " << MAX_MSG_SIZE << ""
+			", \"size\": " << length << ""
 			", \"packedBuffer\": false"
 			" }";
-		return false;
+		return nullptr;
 	}
-	CopyMemory (buf->data, data, length);
-	buf->length = static_cast<uint32_t> (length);
-	if (!Submit (buf)) {
-		goto cleanup;
+	return buf;
+}
+
+/* Abandon a reserved reply, the packed buffer is kept for the next reply. */
+void
+chainy::client_t::ReleaseReplyBuffer (
+	RsslBuffer* buf
+	)
+{
+	DCHECK(nullptr != buf);
+	if (buf == pack_buf_) {
+		pack_buf_->length = pack_space_;
+		pack_length_ = 0;
+		return;
 	}
-	cumulative_stats_[CLIENT_PC_ITEM_SENT]++;
-	return true;
-cleanup:
+	RsslError rssl_err;
 	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
 		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
@@ -986,7 +1055,37 @@ cleanup:
 			", \"text\": \"" << rssl_err.text << "\""
 			" }";
 	}
-	return false;
+}
+
+bool
+chainy::client_t::SubmitReply (
+	int32_t request_token,
+	RsslBuffer* buf,
+	bool and_close
+	)
+{
+	DCHECK(nullptr != buf);
+	if (and_close) {
+/* Drop response if token already canceled */
+		if (0 == tokens_.erase (request_token)) {
+			ReleaseReplyBuffer (buf);
+			return true;
+		}
+	}
+	if (buf == pack_buf_) {
+		DCHECK_LE(buf->length, pack_space_);
+		pack_length_ = buf->length;
+		is_flush_pending_ = true;
+		cumulative_stats_[CLIENT_PC_RSSL_MSGS_PACKED]++;
+		cumulative_stats_[CLIENT_PC_ITEM_SENT]++;
+		return true;
+	}
+	if (!Submit (buf)) {
+		ReleaseReplyBuffer (buf);
+		return false;
+	}
+	cumulative_stats_[CLIENT_PC_ITEM_SENT]++;
+	return true;
 }
 
 bool
@@ -999,6 +1098,7 @@ chainy::client_t::OnCloseMsg (
 	cumulative_stats_[CLIENT_PC_CLOSE_MSGS_RECEIVED]++;
 	switch (close_msg->msgBase.domainType) {
 	case RSSL_DMT_MARKET_PRICE:
+	case RSSL_DMT_SYMBOL_LIST:
 		return OnItemClose (close_msg);
 	case RSSL_DMT_LOGIN:
 /* toggle login status. */
@@ -1024,7 +1124,6 @@ chainy::client_t::OnCloseMsg (
 	case RSSL_DMT_MARKET_BY_ORDER:
 	case RSSL_DMT_MARKET_BY_PRICE:
 	case RSSL_DMT_MARKET_MAKER:
-	case RSSL_DMT_SYMBOL_LIST:
 	case RSSL_DMT_YIELD_CURVE:
 	default:
 		cumulative_stats_[CLIENT_PC_CLOSE_MSGS_DISCARDED]++;
@@ -1061,7 +1160,8 @@ chainy::client_t::OnItemClose (
 	}
 
 /* Verify domain model */
-	if (RSSL_DMT_MARKET_PRICE != model_type)
+	if (RSSL_DMT_MARKET_PRICE != model_type
+		&& RSSL_DMT_SYMBOL_LIST != model_type)
 	{
 		cumulative_stats_[CLIENT_PC_CLOSE_MSGS_DISCARDED]++;
 		LOG(INFO) << prefix_ << "Discarding close request for unsupported message model type.";
@@ -1077,6 +1177,7 @@ chainy::client_t::OnItemClose (
 		tokens_.erase (it);
 		cumulative_stats_[CLIENT_PC_ITEM_CLOSED]++;
 		DLOG(INFO) << prefix_ << "Closed open request.";
+		return delegate_->OnCancel (reinterpret_cast<uintptr_t> (handle_), request_token);
 	}
 /* Question: close on streaming or non-streaming request? */
 	return true;
@@ -1410,9 +1511,121 @@ chainy::client_t::Submit (
 	)
 {
 	DCHECK(nullptr != buf);
+/* Keep replies already packed ahead of this message. */
+	if (!WritePack())
+		return 0;
 	const int status = provider_->Submit (handle_, buf);
-	if (status) cumulative_stats_[CLIENT_PC_RSSL_MSGS_SENT]++;
+	if (status) {
+		cumulative_stats_[CLIENT_PC_RSSL_MSGS_SENT]++;
+		is_flush_pending_ = true;
+	}
 	return status;
 }
 
+/* Reserve the free space of the open packed buffer for a reply.  The previous
+ * reply is packed only once the next is known to fit behind it, such that the
+ * final reply of a buffer is written unpacked as RSSL expects.
+ */
+RsslBuffer*
+chainy::client_t::ReservePack (
+	size_t length
+	)
+{
+	RsslError rssl_err;
+	if (nullptr != pack_buf_) {
+		if (pack_length_ + kPackedHeaderSize + length > pack_space_) {
+			if (!WritePack())
+				return nullptr;
+		} else if (pack_length_ > 0) {
+			pack_buf_->length = pack_length_;
+			RsslBuffer* buf = rsslPackBuffer (handle_, pack_buf_, &rssl_err);
+			if (nullptr == buf) {
+				cumulative_stats_[CLIENT_PC_RSSL_PACK_EXCEPTION]++;
+				LOG(ERROR) << prefix_ << "rsslPackBuffer: { "
+					  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+					", \"sysError\": " << rssl_err.sysError << ""
+					", \"text\": \"" << rssl_err.text << "\""
+					" }";
+				ReleasePack();
+				return nullptr;
+			}
+			pack_buf_ = buf;
+			pack_length_ = 0;
+			pack_space_ = buf->length;
+			++pack_count_;
+		}
+	}
+	if (nullptr == pack_buf_) {
+		pack_buf_ = rsslGetBuffer (handle_, max_fragment_size_, RSSL_TRUE /* packed */, &rssl_err);
+		if (nullptr == pack_buf_) {
+			LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
+				  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+				", \"sysError\": " << rssl_err.sysError << ""
+				", \"text\": \"" << rssl_err.text << "\""
+				", \"size\": " << max_fragment_size_ << ""
+				", \"packedBuffer\": true"
+				" }";
+			return nullptr;
+		}
+		pack_space_ = pack_buf_->length;
+		pack_count_ = 0;
+	}
+	DCHECK_GE(pack_space_, length);
+	pack_buf_->length = pack_space_;
+	return pack_buf_;
+}
+
+/* Queue the open packed buffer on the channel, flushed by the provider. */
+bool
+chainy::client_t::WritePack()
+{
+	if (nullptr == pack_buf_)
+		return true;
+/* Nothing encoded, otherwise an abandoned reservation leaves an empty final slot. */
+	if (0 == pack_count_ && 0 == pack_length_) {
+		ReleasePack();
+		return true;
+	}
+	RsslBuffer* buf = pack_buf_;
+	buf->length = pack_length_;
+	pack_buf_ = nullptr;
+	pack_length_ = 0;
+	pack_space_ = 0;
+	pack_count_ = 0;
+	if (!provider_->Submit (handle_, buf)) {
+		RsslError rssl_err;
+		if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
+			LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+				  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+				", \"sysError\": " << rssl_err.sysError << ""
+				", \"text\": \"" << rssl_err.text << "\""
+				" }";
+		}
+		return false;
+	}
+	cumulative_stats_[CLIENT_PC_RSSL_MSGS_SENT]++;
+	cumulative_stats_[CLIENT_PC_RSSL_PACKED_BUFFERS_SENT]++;
+	is_flush_pending_ = true;
+	return true;
+}
+
+void
+chainy::client_t::ReleasePack()
+{
+	if (nullptr == pack_buf_)
+		return;
+	RsslError rssl_err;
+	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (pack_buf_, &rssl_err)) {
+		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			" }";
+	}
+	pack_buf_ = nullptr;
+	pack_length_ = 0;
+	pack_space_ = 0;
+	pack_count_ = 0;
+}
+
 /* eof */
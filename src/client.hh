@@ -9,6 +9,9 @@
 #include <unordered_map>
 #include <unordered_set>
 
+/* Boost Atomics */
+#include <boost/atomic.hpp>
+
 /* Boost Posix Time */
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -20,6 +23,8 @@
 #include "upa.hh"
 #include "config.hh"
 #include "deleter.hh"
+#include "monotonic_clock.hh"
+#include "timing_wheel.hh"
 
 namespace chainy
 {
@@ -67,6 +72,11 @@ namespace chainy
 		CLIENT_PC_ITEM_CLOSE_VALIDATED,
 		CLIENT_PC_OMM_INACTIVE_CLIENT_SESSION_RECEIVED,
 		CLIENT_PC_OMM_INACTIVE_CLIENT_SESSION_EXCEPTION,
+		CLIENT_PC_RSSL_MSGS_PACKED,
+		CLIENT_PC_RSSL_PACKED_BUFFERS_SENT,
+		CLIENT_PC_RSSL_PACK_EXCEPTION,
+		CLIENT_PC_ITEM_REQUEST_SHED,
+		CLIENT_PC_QUEUE_HIGH_WATER,
 		CLIENT_PC_MAX
 	};
 
@@ -81,9 +91,9 @@ namespace chainy
 		public:
 		    Delegate() {}
 
-		    virtual bool OnRequest (uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates) = 0;
-/* TBD */
-//		    virtual bool OnCancel (uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates) = 0;
+		    virtual bool OnRequest (uintptr_t handle, uint16_t rwf_version, int32_t token, uint16_t service_id, const std::string& item_name, bool use_attribinfo_in_updates, bool is_streaming) = 0;
+/* Streaming request closed by the client or the client session ended. */
+		    virtual bool OnCancel (uintptr_t handle, int32_t token) = 0;
 
 		protected:
 		    virtual ~Delegate() {}
@@ -96,13 +106,19 @@ namespace chainy
 		bool Close();
 
 		bool OnSourceDirectoryUpdate();
-		bool SendReply (int32_t token, const void* data, size_t length) {
-			return SendReply (token, data, length, false);
+/* Replies are encoded in place: reserve a channel buffer of at least length
+ * bytes, encode into data and set length to the encoded size, then submit or
+ * release.  No other reply may be reserved in between.
+ */
+		RsslBuffer* GetReplyBuffer (size_t length);
+		void ReleaseReplyBuffer (RsslBuffer* buf);
+		bool SubmitReply (int32_t token, RsslBuffer* buf) {
+			return SubmitReply (token, buf, false);
 		}
-		bool SendReplyAndClose (int32_t token, const void* data, size_t length) {
-			return SendReply (token, data, length, true);
+		bool SubmitReplyAndClose (int32_t token, RsslBuffer* buf) {
+			return SubmitReply (token, buf, true);
 		}
-		bool SendReply (int32_t token, const void* data, size_t length, bool and_close);
+		bool SubmitReply (int32_t token, RsslBuffer* buf, bool and_close);
 
 /* RSSL client socket */
 		RsslChannel*const handle() const {
@@ -120,6 +136,22 @@ namespace chainy
 		const std::unordered_set<int32_t>& tokens() const {
 			return tokens_;
 		}
+		uint32_t max_fragment_size() const {
+			return max_fragment_size_;
+		}
+		const std::string& address() const {
+			return address_;
+		}
+/* Outbound queue depth and seconds above a high-water mark, safe from any thread. */
+		uint32_t queued_bytes() const {
+			return queued_bytes_.load();
+		}
+		unsigned queued_msgs() const {
+			return pending_count_.load();
+		}
+		uint32_t lag() const {
+			return lag_.load();
+		}
 
 	private:
 		bool OnMsg (RsslDecodeIterator* it, const RsslMsg* msg);
@@ -140,19 +172,18 @@ namespace chainy
 		bool SendDirectoryUpdate (int32_t token, const char* service_name);
 		bool SendClose (int32_t token, uint16_t service_id, uint8_t model_type, const chromium::StringPiece& item_name, bool use_attribinfo_in_updates, uint8_t stream_state, uint8_t status_code, const chromium::StringPiece& status_text);
 		int Submit (RsslBuffer* buf);
+		RsslBuffer* ReservePack (size_t length);
+		bool WritePack();
+		void ReleasePack();
 
-		const boost::posix_time::ptime& NextPing() const {
+		ticks_t NextPing() const {
 			return next_ping_;
 		}
-		const boost::posix_time::ptime& NextPong() const {
+		ticks_t NextPong() const {
 			return next_pong_;
 		}
-		void SetNextPing (const boost::posix_time::ptime& time_) {
-			next_ping_ = time_;
-		}
-		void SetNextPong (const boost::posix_time::ptime& time_) {
-			next_pong_ = time_;
-		}
+		void SetNextPing (ticks_t time_);
+		void SetNextPong (ticks_t time_);
 		void IncrementPendingCount() {
 			pending_count_++;
 		}
@@ -162,6 +193,9 @@ namespace chainy
 		unsigned GetPendingCount() const {
 			return pending_count_;
 		}
+		bool IsBacklogged() const {
+			return 0 != backlog_start_;
+		}
 
 		std::shared_ptr<provider_t> provider_;
 		Delegate* delegate_;
@@ -176,7 +210,25 @@ namespace chainy
 /* UPA socket. */
 		RsslChannel* handle_;
 /* Pending messages to flush. */
-		unsigned pending_count_;
+		boost::atomic<unsigned> pending_count_;
+/* Bytes pending in the RSSL output queue after the last write or flush. */
+		boost::atomic<uint32_t> queued_bytes_;
+		uint32_t max_queued_bytes_;
+/* Outbound queue first above a high-water mark, zero whilst below. */
+		ticks_t backlog_start_;
+		boost::atomic<uint32_t> lag_;
+/* Open packed buffer of replies, data points to the free space. */
+		RsslBuffer* pack_buf_;
+/* Reply encoded into the free space of the packed buffer but not yet packed. */
+		uint32_t pack_length_;
+/* Size of the free space. */
+		uint32_t pack_space_;
+/* Replies already packed ahead of the free space. */
+		unsigned pack_count_;
+/* Written since the last end of loop flush. */
+		bool is_flush_pending_;
+/* Negotiated largest message size before fragmentation. */
+		uint32_t max_fragment_size_;
 
 /* Watchlist of all items. */
 		std::unordered_set<int32_t> tokens_;
@@ -185,14 +237,16 @@ namespace chainy
 		int32_t directory_token_;
 		int32_t login_token_;
 /* RSSL keepalive state. */
-		boost::posix_time::ptime next_ping_;
-		boost::posix_time::ptime next_pong_;
+		ticks_t next_ping_;
+		ticks_t next_pong_;
 		unsigned ping_interval_;
+/* Earliest keepalive or backlog deadline on the provider timing wheel. */
+		timing_wheel_t::timer_t keepalive_timer_;
 
 		friend provider_t;
 
 /** Performance Counters **/
-		boost::posix_time::ptime creation_time_, last_activity_;
+		ticks_t creation_time_, last_activity_;
 		uint32_t cumulative_stats_[CLIENT_PC_MAX];
 		uint32_t snap_stats_[CLIENT_PC_MAX];
 
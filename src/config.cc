@@ -10,7 +10,9 @@ static const char* kVendorName = "Thomson Reuters";
 chainy::config_t::config_t() :
 /* default values */
 	upstream_service_name ("ELEKTRON_EDGE"),
-	rssl_server ("nylabads1"),
+	warm_standby (false),
+	consumer_shards (1),
+	request_batch_size (500),
 	upstream_rssl_port (kDefaultRsslPort),
 	downstream_service_name ("NOCACHE_VTA"),
 	downstream_rssl_port ("24002"),
@@ -20,9 +22,21 @@ chainy::config_t::config_t() :
 	instance_id (""),
 	position (""),
 	vendor_name (kVendorName),
-	session_capacity (8)
+	session_capacity (8),
+	link_prefetch_depth (16),
+	repack_refresh (false),
+	flatten_depth (0),
+	chain_memory_limit (0),
+	snapshot_interval (300),
+	read_budget (64),
+	read_budget_time (1000),
+	provider_shards (1),
+	client_queue_bytes (1024 * 1024),
+	client_queue_msgs (1024),
+	client_lag_timeout (30)
 {
 /* C++11 initializer lists not supported in MSVC2010 */
+	rssl_servers.push_back ("nylabads1");
 }
 
 /* eof */
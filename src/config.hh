@@ -20,8 +20,17 @@ namespace chainy
 //  TREP-RT service name, e.g. IDN_RDF, hEDD, ELEKTRON_DD.
 		std::string upstream_service_name, downstream_service_name;
 
-//  TREP-RT RSSL hostname or IPv4 address to consume content from.
-		std::string rssl_server;
+//  TREP-RT RSSL hostnames or IPv4 addresses to consume content from, in order of preference.
+		std::vector<std::string> rssl_servers;
+
+//  Hold every item open on a second server for failover without resubscription.
+		bool warm_standby;
+
+//  Upstream connections, chains are partitioned across each by root name.
+		unsigned consumer_shards;
+
+//  Items per upstream batch request where supported by the provider, 1 to request individually.
+		unsigned request_batch_size;
 
 //  TREP-RT RSSL port, e.g. 14002, 14003.
 		std::string upstream_rssl_port, downstream_rssl_port;
@@ -57,14 +66,63 @@ namespace chainy
 
 //  Symbol map.
 		std::string symbol_path;
+
+//  Count of chain links to request ahead of the chain walk, 0 to disable.
+		unsigned link_prefetch_depth;
+
+//  Repack chain constituents into refresh parts of the negotiated fragment size.
+		bool repack_refresh;
+
+//  Levels of chains within chains to expand into one symbol list, 0 to disable.
+		unsigned flatten_depth;
+
+//  Approximate memory of chains resolved on demand before idle chains are evicted, 0 for unlimited.
+		size_t chain_memory_limit;
+
+//  Additional chain link layouts by field name.
+		std::string chain_template_path;
+
+//  Field dictionary cache file retained between restarts, empty to disable.
+		std::string dictionary_cache_path;
+
+//  Snapshot file of resolved chains served on restart until walked afresh, empty to disable.
+		std::string snapshot_path;
+
+//  Seconds between checkpoints of resolved chains to the snapshot file, 0 for shutdown only.
+		unsigned snapshot_interval;
+
+//  Messages read from one channel per readiness notification before yielding.
+		unsigned read_budget;
+
+//  Microseconds spent reading one channel per readiness notification before yielding.
+		unsigned read_budget_time;
+
+//  Provider worker loops, client sessions are distributed across each.
+		unsigned provider_shards;
+
+//  Bytes queued for write to one client session before new requests are shed, 0 to disable.
+		unsigned client_queue_bytes;
+
+//  Messages queued for write to one client session before new requests are shed, 0 to disable.
+		unsigned client_queue_msgs;
+
+//  Seconds a client session may remain above a queue high-water mark before disconnect, 0 to disable.
+		unsigned client_lag_timeout;
 	};
 
 	inline
 	std::ostream& operator<< (std::ostream& o, const config_t& config) {
 		std::ostringstream ss;
+		for (auto it = config.rssl_servers.begin(); it != config.rssl_servers.end(); ++it) {
+			if (it != config.rssl_servers.begin()) ss << ", ";
+			ss << '"' << *it << '"';
+		}
 		o << "config_t: { "
 			  "\"upstream_service_name\": \"" << config.upstream_service_name << "\""
-			", \"rssl_server\": \"" << config.rssl_server << "\""
+			", \"rssl_servers\": [ " << ss.str() << " ]"
+			", \"warm_standby\": " << (config.warm_standby ? "true" : "false") << 
+			", \"consumer_shards\": " << config.consumer_shards << 
+			", \"request_batch_size\": " << config.request_batch_size << 
 			", \"upstream_rssl_port\": \"" << config.upstream_rssl_port << "\""
 			", \"downstream_service_name\": \"" << config.downstream_service_name << "\""
 			", \"downstream_rssl_port\": \"" << config.downstream_rssl_port << "\""
@@ -76,6 +134,20 @@ namespace chainy
 			", \"vendor_name\": \"" << config.vendor_name << "\""
 			", \"session_capacity\": " << config.session_capacity << 
 			", \"symbol_path\": " << config.symbol_path << 
+			", \"link_prefetch_depth\": " << config.link_prefetch_depth << 
+			", \"repack_refresh\": " << (config.repack_refresh ? "true" : "false") << 
+			", \"flatten_depth\": " << config.flatten_depth << 
+			", \"chain_memory_limit\": " << config.chain_memory_limit << 
+			", \"chain_template_path\": \"" << config.chain_template_path << "\""
+			", \"dictionary_cache_path\": \"" << config.dictionary_cache_path << "\""
+			", \"snapshot_path\": \"" << config.snapshot_path << "\""
+			", \"snapshot_interval\": " << config.snapshot_interval << 
+			", \"read_budget\": " << config.read_budget << 
+			", \"read_budget_time\": " << config.read_budget_time << 
+			", \"provider_shards\": " << config.provider_shards << 
+			", \"client_queue_bytes\": " << config.client_queue_bytes << 
+			", \"client_queue_msgs\": " << config.client_queue_msgs << 
+			", \"client_lag_timeout\": " << config.client_lag_timeout << 
 			" }";
 		return o;
 	}
@@ -4,9 +4,15 @@
 #include "consumer.hh"
 
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
-#include <windows.h>
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
 
 #include <rtr/rsslPayloadEntry.h>
 
@@ -21,29 +27,39 @@
 static const std::string kRdmFieldDictionaryName ("RWFFld");
 static const std::string kEnumTypeDictionaryName ("RWFEnum");
 
+/* Reads between samples of the clock against the read budget deadline, the
+ * microsecond budget is finer than the coarse monotonic tick.
+ */
+static const unsigned kReadsPerClockSample = 8;
+
 chainy::consumer_t::consumer_t (
 	const chainy::config_t& config,
 	std::shared_ptr<chainy::upa_t> upa,
 	Delegate* delegate 
 	) :
-	creation_time_ (boost::posix_time::second_clock::universal_time()),
+	creation_time_ (MonotonicTicks()),
 	last_activity_ (creation_time_),
 	config_ (config),
 	upa_ (upa),
 	delegate_ (delegate),
-	connection_ (nullptr),
-	is_muted_ (true),
+	active_ (&sessions_[0]),
+	standby_ (&sessions_[1]),
 	keep_running_ (true),
 	service_id_ (1),	// first and only service
 	cache_handle_ (nullptr),
+	dictionary_verbosity_ (RDM_DICTIONARY_MINIMAL),
+	dictionary_service_id_ (0),
 	refresh_count_ (0),
 	in_sync_ (false),
-	pending_trigger_ (true),
 	wakeup_pipe_in_ (net::kInvalidSocket),
-	wakeup_pipe_out_ (net::kInvalidSocket)
+	wakeup_pipe_out_ (net::kInvalidSocket),
+	token_ (1)
 {
-	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
-	ZeroMemory (snap_stats_, sizeof (snap_stats_));
+	memset (cumulative_stats_, 0, sizeof (cumulative_stats_));
+	memset (snap_stats_, 0, sizeof (snap_stats_));
+/* Standby starts on the next server of the list. */
+	standby_->is_standby = true;
+	standby_->server = config_.rssl_servers.size() > 1 ? 1 : 0;
 }
 
 chainy::consumer_t::~consumer_t()
@@ -54,22 +70,42 @@ chainy::consumer_t::~consumer_t()
 	upa_.reset();
 // MessagePump
 	if (net::kInvalidSocket != wakeup_pipe_in_) {
+#if defined(_WIN32)
 		closesocket (wakeup_pipe_in_);
+#else
+		close (wakeup_pipe_in_);
+#endif
 	}
 	if (net::kInvalidSocket != wakeup_pipe_out_) {
+#if defined(_WIN32)
 		closesocket (wakeup_pipe_out_);
+#else
+		close (wakeup_pipe_out_);
+#endif
 	}
 /* Summary output */
 	using namespace boost::posix_time;
-	auto uptime = second_clock::universal_time() - creation_time_;
+	auto uptime = milliseconds (MonotonicTicks() - creation_time_);
 	VLOG(3) << "Consumer summary: {"
 		 " \"Uptime\": \"" << to_simple_string (uptime) << "\""
 		", \"ConnectionsInitiated\": " << cumulative_stats_[CONSUMER_PC_CONNECTION_INITIATED] <<
 		", \"ClientSessions\": " << cumulative_stats_[CONSUMER_PC_CLIENT_SESSION_ACCEPTED] <<
 		", \"MsgsReceived\": " << cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED] <<
 		", \"MsgsMalformed\": " << cumulative_stats_[CONSUMER_PC_RSSL_MSGS_MALFORMED] <<
+		", \"ReadBatches\": " << cumulative_stats_[CONSUMER_PC_RSSL_READ_BATCHES] <<
+		", \"ReadBudgetExhausted\": " << cumulative_stats_[CONSUMER_PC_RSSL_READ_BUDGET_EXHAUSTED] <<
 		", \"MsgsSent\": " << cumulative_stats_[CONSUMER_PC_RSSL_MSGS_SENT] <<
 		", \"MsgsEnqueued\": " << cumulative_stats_[CONSUMER_PC_RSSL_MSGS_ENQUEUED] <<
+		", \"ItemStreamsClosed\": " << cumulative_stats_[CONSUMER_PC_ITEM_STREAM_CLOSED] <<
+		", \"ItemRequestsSent\": " << cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_SENT] <<
+		", \"BatchRequestsSent\": " << cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_BATCH_SENT] <<
+		", \"ViewRequested\": " << cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VIEW_REQUESTED] <<
+		", \"RefreshBytes\": " << cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_REFRESH_BYTES] <<
+		", \"StandbyMsgsReceived\": " << cumulative_stats_[CONSUMER_PC_STANDBY_MSGS_RECEIVED] <<
+		", \"StandbyPromoted\": " << cumulative_stats_[CONSUMER_PC_STANDBY_PROMOTED] <<
+		", \"ServerFailover\": " << cumulative_stats_[CONSUMER_PC_SERVER_FAILOVER] <<
+		", \"DictionaryCacheHit\": " << cumulative_stats_[CONSUMER_PC_DICTIONARY_CACHE_HIT] <<
+		", \"DictionaryCacheMiss\": " << cumulative_stats_[CONSUMER_PC_DICTIONARY_CACHE_MISS] <<
 		" }";
 }
 
@@ -80,7 +116,9 @@ chainy::consumer_t::Initialize()
 {
 	RsslRet rc;
 
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = MonotonicTicks();
+/* RDM data dictionary, requested once by the first active session. */
+	rsslClearDataDictionary (&rdm_dictionary_);
 
 /* RSSL Version Info. */
 	if (!upa_->VerifyVersion())
@@ -95,9 +133,20 @@ chainy::consumer_t::Initialize()
 		return false;
 	}
 
+/* Field dictionary retained between restarts. */
+	if (!config_.dictionary_cache_path.empty()) {
+		dictionary_cache_.reset (new dictionary_cache_t (config_.dictionary_cache_path));
+		if (dictionary_cache_->Open())
+			LOG(INFO) << "Field dictionary cache version \"" << dictionary_cache_->version() << "\".";
+	}
+
 // MessageLoop 
 	this->pump_ = shared_from_this();
 
+	if (!selector_.Open())
+		return false;
+
+#if defined(_WIN32)
 	{
 		struct sockaddr_in addr;
 		SOCKET listener;
@@ -133,6 +182,17 @@ chainy::consumer_t::Initialize()
 		sockerr = closesocket (listener);
 		DCHECK (sockerr != SOCKET_ERROR);
 	}
+#else
+	{
+		int fds[2];
+		if (-1 == socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds)) {
+			DLOG(ERROR) << "socketpair failed, errno: " << errno;
+			return false;
+		}
+		wakeup_pipe_in_ = fds[0];
+		wakeup_pipe_out_ = fds[1];
+	}
+#endif
 
 	return true;
 }
@@ -141,10 +201,12 @@ void
 chainy::consumer_t::Close()
 {
 /* Close all RSSL connections. */
-	if (nullptr != connection_) {
-		VLOG(3) << "Closing connection.";
-		Close (connection_);
-		connection_ = nullptr;
+	for (auto& session : sessions_) {
+		if (nullptr == session.channel)
+			continue;
+		VLOG(3) << "Closing " << (session.is_standby ? "standby " : "") << "connection.";
+		Close (session.channel);
+		session.channel = nullptr;
 	}
 /* Last value cache. */
 	if (nullptr != cache_handle_) {
@@ -166,15 +228,13 @@ chainy::consumer_t::Run()
 	DLOG(INFO) << "Run";
 	DCHECK(keep_running_) << "Quit must have been called outside of Run!";
 
-	FD_ZERO (&in_rfds_); FD_ZERO (&out_rfds_);
-	FD_ZERO (&in_wfds_); FD_ZERO (&out_wfds_);
-	FD_ZERO (&in_efds_); FD_ZERO (&out_efds_);
-	in_nfds_ = out_nfds_ = 0;
+	selector_.Clear();
+	out_nfds_ = 0;
 	in_tv_.tv_sec = 0;
 	in_tv_.tv_usec = 1000 * 100;
 
 // MessagePump wakeup events
-	FD_SET (wakeup_pipe_out_, &in_rfds_);
+	selector_.Set (wakeup_pipe_out_, selector_t::kReadable);
 
 	for (;;) {
 		bool did_work = DoInternalWork();
@@ -200,14 +260,8 @@ chainy::consumer_t::Run()
 		if (did_work)
 			continue;
 
-/* Reset fd state */
-		out_rfds_ = in_rfds_;
-		out_wfds_ = in_wfds_;
-		out_efds_ = in_efds_;
-		out_tv_.tv_sec = in_tv_.tv_sec;
-		out_tv_.tv_usec = in_tv_.tv_usec;
-
-		out_nfds_ = select (in_nfds_ + 1, &out_rfds_, &out_wfds_, &out_efds_, &out_tv_);
+		delegate_->OnIdle();
+		out_nfds_ = selector_.Wait (in_tv_);
 	}
 
 	keep_running_ = true;
@@ -219,99 +273,126 @@ chainy::consumer_t::DoInternalWork()
 	DVLOG(3) << "DoInternalWork";
 	bool did_work = false;
 
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = MonotonicTicks();
+
+/* Items created by tasks since the last pass. */
+	FlushItemRequests();
 
 /* Only check keepalives on timeout */
-	if (out_nfds_ <= 0
-		&& nullptr != connection_)
-	{
-		RsslChannel* c = connection_;
-		DVLOG(3) << "timeout, state " << internal::channel_state_string (c->state);
-		if (RSSL_CH_STATE_ACTIVE == c->state) {
-			if (last_activity_ >= NextPing()) {
-				Ping (c);
-			}
-			if (last_activity_ >= NextPong()) {
-				cumulative_stats_[CONSUMER_PC_RSSL_PONG_TIMEOUT]++;
-				LOG(ERROR) << "Pong timeout from peer, aborting connection.";
-				Abort (c);
-			}
-		}
-		if (FD_ISSET (c->socketId, &out_efds_)) {
-			cumulative_stats_[CONSUMER_PC_CONNECTION_EXCEPTION]++;
-			DVLOG(3) << "Socket exception.";
-/* Erase connection */
-			connection_ = nullptr;
+	if (out_nfds_ <= 0) {
+		for (auto& session : sessions_) {
+			RsslChannel* c = session.channel;
+			if (nullptr == c)
+				continue;
+			DVLOG(3) << "timeout, state " << internal::channel_state_string (c->state);
+			CheckKeepalive (&session);
+			if (selector_.IsReady (c->socketId, selector_t::kException)) {
+				cumulative_stats_[CONSUMER_PC_CONNECTION_EXCEPTION]++;
+				DVLOG(3) << "Socket exception.";
 /* Remove RSSL socket from further event notification */
-			FD_CLR (c->socketId, &in_rfds_);
-			FD_CLR (c->socketId, &in_wfds_);
-			FD_CLR (c->socketId, &in_efds_);
+				selector_.Unset (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 /* Ensure RSSL has closed out */
-			if (RSSL_CH_STATE_CLOSED != c->state)
-				Close (c);
+				if (RSSL_CH_STATE_CLOSED != c->state)
+					Close (c);
+/* Erase connection */
+				OnSessionLost (&session);
+			}
 		}
-		
 		return false;
 	}
 
-/* Client connection */
-	if (nullptr == connection_) {
-		Connect();
+/* Client connections, the standby only when configured. */
+	if (nullptr == active_->channel) {
+		Connect (active_);
+		did_work = true;
+	}
+	if (config_.warm_standby && nullptr == standby_->channel) {
+		Connect (standby_);
 		did_work = true;
 	}
 
-	if (nullptr != connection_) {
-		RsslChannel* c = connection_;
+	for (auto& session : sessions_) {
+		RsslChannel* c = session.channel;
+		if (nullptr == c)
+			continue;
 /* incoming */
-		if (FD_ISSET (c->socketId, &out_rfds_)) {
-			FD_CLR (c->socketId, &out_rfds_);
+		if (selector_.IsReady (c->socketId, selector_t::kReadable)) {
+			selector_.ClearReady (c->socketId, selector_t::kReadable);
 			OnCanReadWithoutBlocking (c);
 			did_work = true;
 		}
 /* outgoing */
-		if (FD_ISSET (c->socketId, &out_wfds_)) {
-			FD_CLR (c->socketId, &out_wfds_);
+		if (selector_.IsReady (c->socketId, selector_t::kWritable)) {
+			selector_.ClearReady (c->socketId, selector_t::kWritable);
 			OnCanWriteWithoutBlocking (c);
 			did_work = true;
 		}
 /* Keepalive timeout on active session above connection */
-		if (RSSL_CH_STATE_ACTIVE == c->state) {
-			if (last_activity_ >= NextPing()) {
-				Ping (c);
-			}
-			if (last_activity_ >= NextPong()) {
-				cumulative_stats_[CONSUMER_PC_RSSL_PONG_TIMEOUT]++;
-				LOG(ERROR) << "Pong timeout from peer, aborting connection.";
-				Abort (c);
-			}
-		}
+		CheckKeepalive (&session);
 /* disconnects */
-		if (FD_ISSET (c->socketId, &out_efds_)) {
+		if (selector_.IsReady (c->socketId, selector_t::kException)) {
 			cumulative_stats_[CONSUMER_PC_CONNECTION_EXCEPTION]++;
 			DVLOG(3) << "Socket exception.";
-/* Erase connection */
-			connection_ = nullptr;
 /* Remove RSSL socket from further event notification */
-			FD_CLR (c->socketId, &in_rfds_);
-			FD_CLR (c->socketId, &in_wfds_);
-			FD_CLR (c->socketId, &in_efds_);
+			selector_.Unset (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 /* Ensure RSSL has closed out */
 			if (RSSL_CH_STATE_CLOSED != c->state)
 				Close (c);
+/* Erase connection */
+			OnSessionLost (&session);
 /* We want to hit select for timeout before reconnecting. */
 			did_work = false;
 		}
 	}
 
 // MessagePump wakeup event
-	if (FD_ISSET (wakeup_pipe_out_, &out_rfds_)) {
-		FD_CLR (wakeup_pipe_out_, &out_rfds_);
+	if (selector_.IsReady (wakeup_pipe_out_, selector_t::kReadable)) {
+		selector_.ClearReady (wakeup_pipe_out_, selector_t::kReadable);
 		OnWakeup();     
 	}
 
+/* Links discovered by this pass. */
+	FlushItemRequests();
 	return did_work;
 }
 
+/* Request item streams created since the last pass on each session permitted
+ * to subscribe, muted sessions request them on resubscription.  Items not
+ * requested on the active session remain pending for the next pass.
+ */
+void
+chainy::consumer_t::FlushItemRequests()
+{
+	if (pending_.empty())
+		return;
+	std::vector<std::shared_ptr<item_stream_t>> items;
+	std::unordered_set<int32_t> tokens;
+	items.reserve (pending_.size());
+	for (const auto& it : pending_) {
+		auto sp = it.lock();
+/* an item may be pending from both a pass and a resubscription */
+		if ((bool)sp && !sp->is_closed && -1 != sp->token && tokens.insert (sp->token).second)
+			items.push_back (sp);
+	}
+	pending_.clear();
+	for (auto& session : sessions_) {
+		if (nullptr == session.channel || session.is_muted)
+			continue;
+		std::vector<std::shared_ptr<item_stream_t>> unrequested;
+		for (const auto& sp : items) {
+			if (0 == session.requests.count (sp->token))
+				unrequested.push_back (sp);
+		}
+		if (!unrequested.empty())
+			SendItemRequests (session.channel, unrequested);
+	}
+/* retry items the active session did not request, e.g. out of buffers */
+	for (const auto& sp : items) {
+		if (0 == active_->requests.count (sp->token))
+			pending_.push_back (sp);
+	}
+}
+
 void
 chainy::consumer_t::Quit()
 {
@@ -352,7 +433,9 @@ chainy::consumer_t::OnWakeup()
  * Create an outbound connection to the well-known hostname and port of an Interactive Provider. 
  */
 void
-chainy::consumer_t::Connect()
+chainy::consumer_t::Connect (
+	upstream_t* session
+	)
 {
 #ifndef NDEBUG
 	RsslConnectOptions addr = RSSL_INIT_CONNECT_OPTS;
@@ -362,15 +445,18 @@ chainy::consumer_t::Connect()
 #endif
 	RsslError rssl_err;
 
-	DCHECK (nullptr == connection_);
+	DCHECK (nullptr == session->channel);
 	cumulative_stats_[CONSUMER_PC_CONNECTION_INITIATED]++;
-	VLOG(2) << "Initiating new connection.";
+	const std::string& server = config_.rssl_servers[session->server];
+	VLOG(2) << "Initiating new " << (session->is_standby ? "standby " : "") << "connection to \"" << server << "\".";
 
-	addr.connectionInfo.unified.address = const_cast<char*> (config_.rssl_server.c_str());
+	addr.connectionInfo.unified.address = const_cast<char*> (server.c_str());
 	addr.connectionInfo.unified.serviceName = const_cast<char*> (config_.upstream_rssl_port.c_str());
 	addr.protocolType = RSSL_RWF_PROTOCOL_TYPE;
 	addr.majorVersion = RSSL_RWF_MAJOR_VERSION;
 	addr.minorVersion = RSSL_RWF_MINOR_VERSION;
+/* Session state is found from the channel. */
+	addr.userSpecPtr = session;
 	RsslChannel* c = rsslConnect (&addr, &rssl_err);
 	if (nullptr == c) {
 		LOG(ERROR) << "rsslConnect: { "
@@ -382,19 +468,18 @@ chainy::consumer_t::Connect()
 			", \"majorVersion\": " << addr.majorVersion << ""
 			", \"minorVersion\": " << addr.minorVersion << ""
 			" }";
+		RotateServer (session);
 	} else {
-		connection_ = c;
-		component_text_.clear();
-		app_text_.clear();
+		session->channel = c;
+		session->component_text.clear();
+		session->app_text.clear();
 /* Set logger ID */
 		std::ostringstream ss;
 		ss << c << ':';
-		prefix_.assign (ss.str());
+		session->prefix.assign (ss.str());
 
 /* Wait for session */
-		FD_SET (c->socketId, &in_rfds_);
-		FD_SET (c->socketId, &in_wfds_);
-		FD_SET (c->socketId, &in_efds_);
+		selector_.Set (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 
 		cumulative_stats_[CONSUMER_PC_CONNECTION_ACCEPTED]++;
 
@@ -411,6 +496,118 @@ chainy::consumer_t::Connect()
 	}
 }
 
+/* Forget the state of a closed session, a warm standby replaces a lost active
+ * session, and the lost session moves on to the next server of the list.
+ */
+void
+chainy::consumer_t::OnSessionLost (
+	upstream_t* session
+	)
+{
+	DCHECK (nullptr != session->channel);
+	session->channel = nullptr;
+	session->is_muted = true;
+	session->has_directory = false;
+	session->supports_batch = false;
+	session->supports_view = false;
+	session->pending_count = 0;
+	session->requests.clear();
+	session->refresh_count = 0;
+/* A dictionary part way through retrieval is requested again in full. */
+	if (!session->is_standby
+		&& nullptr == cache_handle_
+		&& rdm_dictionary_.isInitialized)
+	{
+		rsslDeleteDataDictionary (&rdm_dictionary_);
+	}
+	if (session == active_
+		&& nullptr != standby_->channel
+		&& !standby_->is_muted)
+	{
+		Promote();
+	}
+	RotateServer (session);
+}
+
+/* Next server of the list, avoiding the server of the other session whilst
+ * another is available.
+ */
+void
+chainy::consumer_t::RotateServer (
+	upstream_t* session
+	)
+{
+	const size_t count = config_.rssl_servers.size();
+	const upstream_t* other = (session == active_) ? standby_ : active_;
+	session->server = (session->server + 1) % count;
+	if (count > 1 && session->server == other->server)
+		session->server = (session->server + 1) % count;
+	cumulative_stats_[CONSUMER_PC_SERVER_FAILOVER]++;
+	VLOG(2) << "Next " << (session->is_standby ? "standby " : "") << "server \"" << config_.rssl_servers[session->server] << "\".";
+}
+
+/* Swap the standby in as the active session.  Each item image of the standby
+ * replaces the last value cache and is replayed to the delegate as a refresh,
+ * chains publish only the difference and requests continue to be accepted.
+ */
+void
+chainy::consumer_t::Promote()
+{
+	DCHECK (nullptr != standby_->channel);
+	cumulative_stats_[CONSUMER_PC_STANDBY_PROMOTED]++;
+	std::swap (active_, standby_);
+	active_->is_standby = false;
+	standby_->is_standby = true;
+	LOG(INFO) << active_->prefix << "Promoting standby session: { "
+		  "\"server\": \"" << config_.rssl_servers[active_->server] << "\""
+		", \"itemStreams\": " << active_->requests.size() << ""
+		", \"refreshed\": " << active_->refresh_count << ""
+		" }";
+	for (auto it = directory_.begin(); it != directory_.end(); ++it) {
+		auto sp = it->lock();
+		if (!(bool)sp)
+			continue;
+/* Items without an image on the standby follow with their refresh. */
+		auto request = active_->requests.find (sp->token);
+		if (request != active_->requests.end()
+			&& request->second
+			&& nullptr != sp->standby_entry_handle)
+		{
+			if (0 == sp->refresh_received++)
+				refresh_count_++;
+			if (!ReplayImage (active_->channel, sp)) {
+				Abort (active_->channel);
+				return;
+			}
+		}
+/* Cached only whilst standby. */
+		if (nullptr != sp->standby_entry_handle) {
+			rsslPayloadEntryDestroy (sp->standby_entry_handle);
+			sp->standby_entry_handle = nullptr;
+		}
+	}
+	CheckSyncState();
+}
+
+void
+chainy::consumer_t::CheckKeepalive (
+	upstream_t* session
+	)
+{
+	RsslChannel* c = session->channel;
+	DCHECK (nullptr != c);
+	if (RSSL_CH_STATE_ACTIVE != c->state)
+		return;
+	if (last_activity_ >= session->next_ping) {
+		Ping (c);
+	}
+	if (last_activity_ >= session->next_pong) {
+		cumulative_stats_[CONSUMER_PC_RSSL_PONG_TIMEOUT]++;
+		LOG(ERROR) << session->prefix << "Pong timeout from peer, aborting connection.";
+		Abort (c);
+	}
+}
+
 void
 chainy::consumer_t::OnCanReadWithoutBlocking (
 	RsslChannel* c
@@ -462,18 +659,15 @@ chainy::consumer_t::OnInitializingState (
 		if ((state.flags & RSSL_IP_FD_CHANGE) == RSSL_IP_FD_CHANGE) {
 			cumulative_stats_[CONSUMER_PC_RSSL_PROTOCOL_DOWNGRADE]++;
 			LOG(INFO) << "RSSL protocol downgrade, reconnected.";
-			FD_CLR (state.oldSocket, &in_rfds_); FD_SET (c->socketId, &in_rfds_);
-			FD_CLR (state.oldSocket, &in_wfds_); FD_SET (c->socketId, &in_wfds_);
-			FD_CLR (state.oldSocket, &in_efds_); FD_SET (c->socketId, &in_efds_);
+			selector_.Unset (state.oldSocket, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
+			selector_.Set (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 		} else {
 			LOG(INFO) << "RSSL connection in progress.";
 		}
 		break;
 	case RSSL_RET_SUCCESS:
 		OnActiveSession (c);
-		FD_SET (c->socketId, &in_rfds_);
-		FD_SET (c->socketId, &in_wfds_);
-		FD_SET (c->socketId, &in_efds_);
+		selector_.Set (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 		break;
 	default:
 		LOG(ERROR) << "rsslInitChannel: { "
@@ -534,11 +728,12 @@ chainy::consumer_t::OnActiveWriteState (
 	rc = rsslFlush (c, &rssl_err);
 	if (RSSL_RET_SUCCESS == rc) {
 		cumulative_stats_[CONSUMER_PC_RSSL_FLUSH]++;
-		FD_CLR (c->socketId, &in_wfds_);
+		selector_.Unset (c->socketId, selector_t::kWritable);
 /* Sent data equivalent to a ping. */
-		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_SENT] += GetPendingCount();
-		ClearPendingCount();
-		SetNextPing (last_activity_ + boost::posix_time::seconds (ping_interval_));
+		upstream_t* session = GetSession (c);
+		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_SENT] += session->pending_count;
+		session->pending_count = 0;
+		session->next_ping = last_activity_ + SecondsToTicks (session->ping_interval);
 	} else if (rc > 0) {
 		DVLOG(1) << static_cast<signed> (rc) << " bytes pending.";
 	} else {
@@ -556,9 +751,8 @@ chainy::consumer_t::Abort (
 	)
 {
 	DCHECK (nullptr != c);
-	FD_CLR (c->socketId, &out_rfds_);
-	FD_CLR (c->socketId, &out_wfds_);
-	FD_SET (c->socketId, &out_efds_);
+	selector_.ClearReady (c->socketId, selector_t::kReadable | selector_t::kWritable);
+	selector_.SetReady (c->socketId, selector_t::kException);
 }
 
 void
@@ -595,11 +789,11 @@ chainy::consumer_t::OnActiveSession (
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = MonotonicTicks();
 	cumulative_stats_[CONSUMER_PC_OMM_ACTIVE_CLIENT_SESSION_RECEIVED]++;
 
 /* Relog negotiated state. */
-	LOG(INFO) << prefix_ <<
+	LOG(INFO) << GetSession (c)->prefix <<
 		  "RSSL negotiated state: { "
 		  "\"connectionType\": \"" << internal::connection_type_string (c->connectionType) << "\""
 		", \"majorVersion\": " << static_cast<unsigned> (c->majorVersion) << ""
@@ -622,7 +816,8 @@ chainy::consumer_t::OnActiveSession (
 	}
 
 /* Save some details for instrumentation */
-	component_text_.assign (info.componentInfo[0]->componentVersion.data, info.componentInfo[0]->componentVersion.length);
+	upstream_t* session = GetSession (c);
+	session->component_text.assign (info.componentInfo[0]->componentVersion.data, info.componentInfo[0]->componentVersion.length);
 
 /* Log connected infrastructure. */
 	std::stringstream components;
@@ -635,7 +830,7 @@ chainy::consumer_t::OnActiveSession (
 	}
 	components << " ]";
 
-	LOG(INFO) << prefix_ <<
+	LOG(INFO) << GetSession (c)->prefix <<
 		  "channelInfo: { "
 		  "\"clientToServerPings\": \"" << (info.clientToServerPings ? "true" : "false") << "\""
 		", \"componentInfo\": " << components.str() << ""
@@ -654,16 +849,12 @@ chainy::consumer_t::OnActiveSession (
 		", \"tcpRecvBufSize\": " << static_cast<unsigned> (info.tcpRecvBufSize) << ""
 		", \"tcpSendBufSize\": " << static_cast<unsigned> (info.tcpSendBufSize) << ""
 		" }";
-/* First token aka stream id */
-	token_ = 1;
 /* Derive expected RSSL ping interval from negotiated timeout. */
-	ping_interval_ = c->pingTimeout / 3;
+	session->ping_interval = c->pingTimeout / 3;
 /* Schedule first RSSL ping. */
-	next_ping_ = last_activity_ + boost::posix_time::seconds (ping_interval_);
+	session->next_ping = last_activity_ + SecondsToTicks (session->ping_interval);
 /* Treat connect as first RSSL pong. */
-	next_pong_ = last_activity_ + boost::posix_time::seconds (c->pingTimeout);
-/* Reset RDM data dictionary and wait to request from upstream. */
-	rsslClearDataDictionary (&rdm_dictionary_);
+	session->next_pong = last_activity_ + SecondsToTicks (c->pingTimeout);
 	return SendLoginRequest (c);
 }
 
@@ -699,7 +890,7 @@ chainy::consumer_t::SendLoginRequest (
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
-	VLOG(2) << prefix_ << "Sending MMT_LOGIN request.";
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_LOGIN request.";
 
 /* Set the message model type. */
 	request.msgBase.domainType = RSSL_DMT_LOGIN;
@@ -723,7 +914,7 @@ chainy::consumer_t::SendLoginRequest (
 
 	buf = rsslGetBuffer (c, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
 	if (nullptr == buf) {
-		LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -734,7 +925,7 @@ chainy::consumer_t::SendLoginRequest (
 	}
 	rc = rsslSetEncodeIteratorBuffer (&it, buf);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -743,7 +934,7 @@ chainy::consumer_t::SendLoginRequest (
 	}
 	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorRWFVersion: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -754,7 +945,7 @@ chainy::consumer_t::SendLoginRequest (
 	}
 	rc = rsslEncodeMsgInit (&it, reinterpret_cast<RsslMsg*> (&request), MAX_MSG_SIZE);
 	if (RSSL_RET_ENCODE_MSG_KEY_OPAQUE != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgInit: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgInit: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -767,7 +958,7 @@ chainy::consumer_t::SendLoginRequest (
 	element_list.flags = RSSL_ELF_HAS_STANDARD_DATA;
 	rc = rsslEncodeElementListInit (&it, &element_list, nullptr /* element id dictionary */, 9 /* count of elements */);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeElementListInit: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListInit: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -781,7 +972,7 @@ chainy::consumer_t::SendLoginRequest (
         element_entry.name      = RSSL_ENAME_ALLOW_SUSPECT_DATA;
         rc = rsslEncodeElementEntry (&it, &element_entry, &disallow_suspect_data);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -798,7 +989,7 @@ chainy::consumer_t::SendLoginRequest (
         data_buffer.length = static_cast<uint32_t> (config_.application_id.size());
         rc = rsslEncodeElementEntry (&it, &element_entry, &data_buffer);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -815,7 +1006,7 @@ chainy::consumer_t::SendLoginRequest (
         data_buffer.length = static_cast<uint32_t> (config_.application_name.size());
         rc = rsslEncodeElementEntry (&it, &element_entry, &data_buffer);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -832,7 +1023,7 @@ chainy::consumer_t::SendLoginRequest (
         data_buffer.length = static_cast<uint32_t> (config_.instance_id.size());
         rc = rsslEncodeElementEntry (&it, &element_entry, &data_buffer);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -849,7 +1040,7 @@ chainy::consumer_t::SendLoginRequest (
         data_buffer.length = static_cast<uint32_t> (config_.position.size());
         rc = rsslEncodeElementEntry (&it, &element_entry, &data_buffer);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -865,7 +1056,7 @@ chainy::consumer_t::SendLoginRequest (
 	element_entry.name	= RSSL_ENAME_PROV_PERM_EXP;
 	rc = rsslEncodeElementEntry (&it, &element_entry, &provide_permission_expressions);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -881,7 +1072,7 @@ chainy::consumer_t::SendLoginRequest (
         element_entry.name      = RSSL_ENAME_PROV_PERM_PROF;
         rc = rsslEncodeElementEntry (&it, &element_entry, &disable_permission_profile);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -897,7 +1088,7 @@ chainy::consumer_t::SendLoginRequest (
         element_entry.name      = RSSL_ENAME_ROLE;
         rc = rsslEncodeElementEntry (&it, &element_entry, &consumer_role);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -913,7 +1104,7 @@ chainy::consumer_t::SendLoginRequest (
         element_entry.name      = RSSL_ENAME_SINGLE_OPEN;
         rc = rsslEncodeElementEntry (&it, &element_entry, &single_open);
         if (RSSL_RET_SUCCESS != rc) {
-                LOG(ERROR) << prefix_ << "rsslEncodeElementEntry: { "
+                LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
                           "\"returnCode\": " << static_cast<signed> (rc) << ""
                         ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
                         ", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -925,7 +1116,7 @@ chainy::consumer_t::SendLoginRequest (
         }
 	rc = rsslEncodeElementListComplete (&it, RSSL_TRUE /* commit */);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeElementListComplete: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListComplete: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -934,7 +1125,7 @@ chainy::consumer_t::SendLoginRequest (
 	}
 	rc = rsslEncodeMsgKeyAttribComplete (&it, RSSL_TRUE /* commit */);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgKeyAttribComplete: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgKeyAttribComplete: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -942,7 +1133,7 @@ chainy::consumer_t::SendLoginRequest (
 		goto cleanup;
 	}
 	if (RSSL_RET_SUCCESS != rsslEncodeMsgComplete (&it, RSSL_TRUE /* commit */)) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgComplete: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgComplete: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -950,17 +1141,17 @@ chainy::consumer_t::SendLoginRequest (
 		goto cleanup;
 	}
 	buf->length = rsslGetEncodedBufferLength (&it);
-	LOG_IF(WARNING, 0 == buf->length) << prefix_ << "rsslGetEncodedBufferLength returned 0.";
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
 
 	DLOG(INFO) << request;
 /* Message validation: must use ASSERT libraries for error description :/ */
 //	if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
 //		cumulative_stats_[CONSUMER_PC_MMT_LOGIN_MALFORMED]++;
-//		LOG(ERROR) << prefix_ << "rsslValidateMsg failed.";
+//		LOG(ERROR) << GetSession (c)->prefix << "rsslValidateMsg failed.";
 //		goto cleanup;
 //	} else {
 //		cumulative_stats_[CONSUMER_PC_MMT_LOGIN_VALIDATED]++;
-//		DVLOG(4) << prefix_ << "rsslValidateMsg succeeded.";
+//		DVLOG(4) << GetSession (c)->prefix << "rsslValidateMsg succeeded.";
 //	}
 
 	if (!Submit (c, buf)) {
@@ -971,7 +1162,7 @@ chainy::consumer_t::SendLoginRequest (
 cleanup:
 	cumulative_stats_[CONSUMER_PC_MMT_LOGIN_EXCEPTION]++;
 	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
-		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1006,7 +1197,7 @@ chainy::consumer_t::SendDirectoryRequest (
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
-	VLOG(2) << prefix_ << "Sending MMT_DIRECTORY request.";
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_DIRECTORY request.";
 
 /* Set the message model type. */
 	request.msgBase.domainType = RSSL_DMT_SOURCE;
@@ -1025,7 +1216,7 @@ chainy::consumer_t::SendDirectoryRequest (
 
 	buf = rsslGetBuffer (c, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
 	if (nullptr == buf) {
-		LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1036,7 +1227,7 @@ chainy::consumer_t::SendDirectoryRequest (
 	}
 	rc = rsslSetEncodeIteratorBuffer (&it, buf);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1045,7 +1236,7 @@ chainy::consumer_t::SendDirectoryRequest (
 	}
 	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorRWFVersion: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1056,7 +1247,7 @@ chainy::consumer_t::SendDirectoryRequest (
 	}
 	rc = rsslEncodeMsg (&it, reinterpret_cast<RsslMsg*> (&request));
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgInit: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgInit: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1064,17 +1255,17 @@ chainy::consumer_t::SendDirectoryRequest (
 		goto cleanup;
 	}
 	buf->length = rsslGetEncodedBufferLength (&it);
-	LOG_IF(WARNING, 0 == buf->length) << prefix_ << "rsslGetEncodedBufferLength returned 0.";
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
 
 	DLOG(INFO) << request;
 /* Message validation: must use ASSERT libraries for error description :/ */
 	if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
 		cumulative_stats_[CONSUMER_PC_MMT_DIRECTORY_MALFORMED]++;
-		LOG(ERROR) << prefix_ << "rsslValidateMsg failed.";
+		LOG(ERROR) << GetSession (c)->prefix << "rsslValidateMsg failed.";
 		goto cleanup;
 	} else {
 		cumulative_stats_[CONSUMER_PC_MMT_DIRECTORY_VALIDATED]++;
-		DVLOG(4) << prefix_ << "rsslValidateMsg succeeded.";
+		DVLOG(4) << GetSession (c)->prefix << "rsslValidateMsg succeeded.";
 	}
 
 	if (!Submit (c, buf)) {
@@ -1087,7 +1278,7 @@ chainy::consumer_t::SendDirectoryRequest (
 cleanup:
 	cumulative_stats_[CONSUMER_PC_MMT_DIRECTORY_EXCEPTION]++;
 	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
-		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1100,7 +1291,8 @@ bool
 chainy::consumer_t::SendDictionaryRequest (
 	RsslChannel* c,
 	const uint16_t service_id,
-	const std::string& dictionary_name
+	const std::string& dictionary_name,
+	const uint32_t verbosity
 	)
 {
 #ifndef NDEBUG
@@ -1123,7 +1315,7 @@ chainy::consumer_t::SendDictionaryRequest (
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
-	VLOG(2) << prefix_ << "Sending MMT_DICTIONARY request.";
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_DICTIONARY request.";
 
 /* Set the message model type. */
 	request.msgBase.domainType = RSSL_DMT_DICTIONARY;
@@ -1139,12 +1331,12 @@ chainy::consumer_t::SendDictionaryRequest (
 	request.msgBase.msgKey.serviceId = service_id;
 	request.msgBase.msgKey.name.data   = const_cast<char*> (dictionary_name.c_str());
 	request.msgBase.msgKey.name.length = static_cast<uint32_t> (dictionary_name.size());
-	request.msgBase.msgKey.filter = RDM_DICTIONARY_MINIMAL;		/* for caching */
+	request.msgBase.msgKey.filter = verbosity;	/* minimal for caching, info for version only */
         request.msgBase.msgKey.flags = RSSL_MKF_HAS_SERVICE_ID | RSSL_MKF_HAS_NAME | RSSL_MKF_HAS_FILTER;
 
 	buf = rsslGetBuffer (c, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
 	if (nullptr == buf) {
-		LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1155,7 +1347,7 @@ chainy::consumer_t::SendDictionaryRequest (
 	}
 	rc = rsslSetEncodeIteratorBuffer (&it, buf);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1164,7 +1356,7 @@ chainy::consumer_t::SendDictionaryRequest (
 	}
 	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorRWFVersion: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1175,7 +1367,7 @@ chainy::consumer_t::SendDictionaryRequest (
 	}
 	rc = rsslEncodeMsg (&it, reinterpret_cast<RsslMsg*> (&request));
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgInit: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgInit: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1183,17 +1375,17 @@ chainy::consumer_t::SendDictionaryRequest (
 		goto cleanup;
 	}
 	buf->length = rsslGetEncodedBufferLength (&it);
-	LOG_IF(WARNING, 0 == buf->length) << prefix_ << "rsslGetEncodedBufferLength returned 0.";
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
 
 	DLOG(INFO) << request;
 /* Message validation: must use ASSERT libraries for error description :/ */
 	if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
 		cumulative_stats_[CONSUMER_PC_MMT_DICTIONARY_MALFORMED]++;
-		LOG(ERROR) << prefix_ << "rsslValidateMsg failed.";
+		LOG(ERROR) << GetSession (c)->prefix << "rsslValidateMsg failed.";
 		goto cleanup;
 	} else {
 		cumulative_stats_[CONSUMER_PC_MMT_DICTIONARY_VALIDATED]++;
-		DVLOG(4) << prefix_ << "rsslValidateMsg succeeded.";
+		DVLOG(4) << GetSession (c)->prefix << "rsslValidateMsg succeeded.";
 	}
 
 	if (!Submit (c, buf)) {
@@ -1202,11 +1394,16 @@ chainy::consumer_t::SendDictionaryRequest (
 	cumulative_stats_[CONSUMER_PC_MMT_DICTIONARY_SENT]++;
 /* re-use token on failure. */
 	dictionary_token_ = token_++;
+	dictionary_verbosity_ = verbosity;
+	dictionary_service_id_ = service_id;
+/* capture a full retrieval for the cache */
+	if ((bool)dictionary_cache_ && RDM_DICTIONARY_MINIMAL == verbosity)
+		dictionary_cache_->Clear();
 	return true;
 cleanup:
 	cumulative_stats_[CONSUMER_PC_MMT_DICTIONARY_EXCEPTION]++;
 	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
-		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1227,13 +1424,16 @@ chainy::consumer_t::SendItemRequest (
  */
 	RsslRequestMsg request = RSSL_INIT_REQUEST_MSG;
 	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+	RsslElementList	element_list = RSSL_INIT_ELEMENT_LIST;
         RsslBuffer data_buffer = RSSL_INIT_BUFFER;
 #else
 	RsslRequestMsg request;
 	RsslEncodeIterator it;
+	RsslElementList	element_list;
         RsslBuffer data_buffer;
 	rsslClearRequestMsg (&request);
 	rsslClearEncodeIterator (&it);
+	rsslClearElementList (&element_list);
         rsslClearBuffer (&data_buffer);
 #endif
 	RsslBuffer* buf;
@@ -1241,17 +1441,27 @@ chainy::consumer_t::SendItemRequest (
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
-	VLOG(2) << prefix_ << "Sending MMT_MARKET_PRICE request.";
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_MARKET_PRICE request.";
+
+/* Restrict to the fields of interest when the provider supports views. */
+	const bool has_view = GetSession (c)->supports_view && !view_.empty();
+	const uint32_t size = MAX_MSG_SIZE + (has_view ? static_cast<uint32_t> (view_.size()) * 2 : 0);
 
 /* Set the message model type. */
 	request.msgBase.domainType = RSSL_DMT_MARKET_PRICE;
 /* Set request type. */
 	request.msgBase.msgClass = RSSL_MC_REQUEST;
 	request.flags = RSSL_RQMF_STREAMING;
+	if (has_view) {
+		request.flags |= RSSL_RQMF_HAS_VIEW;
+/* View definition as payload. */
+		request.msgBase.containerType = RSSL_DT_ELEMENT_LIST;
+	} else {
 /* No view thus no payload. */
-	request.msgBase.containerType = RSSL_DT_NO_DATA;
-/* Set the stream token. */
-	request.msgBase.streamId = token_;
+		request.msgBase.containerType = RSSL_DT_NO_DATA;
+	}
+/* Set the stream token, common to each session. */
+	request.msgBase.streamId = item_stream->token;
 
 /* In RFA lingo an attribute object */
 	request.msgBase.msgKey.nameType    = RDM_INSTRUMENT_NAME_TYPE_RIC;
@@ -1260,20 +1470,20 @@ chainy::consumer_t::SendItemRequest (
 	request.msgBase.msgKey.serviceId = service_id_;
         request.msgBase.msgKey.flags = RSSL_MKF_HAS_NAME_TYPE | RSSL_MKF_HAS_NAME | RSSL_MKF_HAS_SERVICE_ID;
 
-	buf = rsslGetBuffer (c, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
+	buf = rsslGetBuffer (c, size, RSSL_FALSE /* not packed */, &rssl_err);
 	if (nullptr == buf) {
-		LOG(ERROR) << prefix_ << "rsslGetBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
-			", \"size\": " << MAX_MSG_SIZE << ""
+			", \"size\": " << size << ""
 			", \"packedBuffer\": false"
 			" }";
 		return false;
 	}
 	rc = rsslSetEncodeIteratorBuffer (&it, buf);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorBuffer: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1282,7 +1492,7 @@ chainy::consumer_t::SendItemRequest (
 	}
 	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslSetEncodeIteratorRWFVersion: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1291,42 +1501,90 @@ chainy::consumer_t::SendItemRequest (
 			" }";
 		goto cleanup;
 	}
-	rc = rsslEncodeMsg (&it, reinterpret_cast<RsslMsg*> (&request));
-	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslEncodeMsgInit: { "
-			  "\"returnCode\": " << static_cast<signed> (rc) << ""
-			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
-			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
-			" }";
-		goto cleanup;
+	if (!has_view) {
+		rc = rsslEncodeMsg (&it, reinterpret_cast<RsslMsg*> (&request));
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsg: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			goto cleanup;
+		}
+	} else {
+		rc = rsslEncodeMsgInit (&it, reinterpret_cast<RsslMsg*> (&request), size);
+		if (RSSL_RET_ENCODE_CONTAINER != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgInit: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				", \"dataMaxSize\": " << size << ""
+				" }";
+			goto cleanup;
+		}
+		element_list.flags = RSSL_ELF_HAS_STANDARD_DATA;
+		rc = rsslEncodeElementListInit (&it, &element_list, nullptr /* element id dictionary */, 0 /* count of elements */);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListInit: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				", \"flags\": \"RSSL_ELF_HAS_STANDARD_DATA\""
+				" }";
+			goto cleanup;
+		}
+		if (!EncodeView (c, &it))
+			goto cleanup;
+		rc = rsslEncodeElementListComplete (&it, RSSL_TRUE /* commit */);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListComplete: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			goto cleanup;
+		}
+		rc = rsslEncodeMsgComplete (&it, RSSL_TRUE /* commit */);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgComplete: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			goto cleanup;
+		}
 	}
 	buf->length = rsslGetEncodedBufferLength (&it);
-	LOG_IF(WARNING, 0 == buf->length) << prefix_ << "rsslGetEncodedBufferLength returned 0.";
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
 
 	DLOG(INFO) << request;
+	if (DCHECK_IS_ON()) {
 /* Message validation: must use ASSERT libraries for error description :/ */
-	if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
-		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_MALFORMED]++;
-		LOG(ERROR) << prefix_ << "rsslValidateMsg failed.";
-		goto cleanup;
-	} else {
-		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VALIDATED]++;
-		DVLOG(4) << prefix_ << "rsslValidateMsg succeeded.";
+		if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_MALFORMED]++;
+			LOG(ERROR) << GetSession (c)->prefix << "rsslValidateMsg failed.";
+			goto cleanup;
+		} else {
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VALIDATED]++;
+			DVLOG(4) << GetSession (c)->prefix << "rsslValidateMsg succeeded.";
+		}
 	}
 
 	if (!Submit (c, buf)) {
 		goto cleanup;
 	} else {
 		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_SENT]++;
-/* update token state only on success, re-use token on failure. */
-		auto status = tokens_.emplace (item_stream->token = token_++, item_stream);
+		if (has_view)
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VIEW_REQUESTED]++;
+/* update session state only on success, request again on failure. */
+		auto status = GetSession (c)->requests.emplace (item_stream->token, false);
 		assert (true == status.second);
 		return true;
 	}
 cleanup:
 	cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_EXCEPTION]++;
 	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
-		LOG(WARNING) << prefix_ << "rsslReleaseBuffer: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
 			", \"text\": \"" << rssl_err.text << "\""
@@ -1335,126 +1593,734 @@ cleanup:
 	return false;
 }
 
-/* Create an item stream for a given symbol name.  The Item Stream maintains
- * the provider state on behalf of the application.
+/* Request a run of item streams in one message, the provider opens each item
+ * on the stream id following the batch token in list order and closes the
+ * batch stream itself.
  */
 bool
-chainy::consumer_t::CreateItemStream (
-        const char* item_name,
-        std::shared_ptr<item_stream_t> item_stream
-        )
-{
-        VLOG(4) << "Creating item stream for RIC \"" << item_name << "\".";
-	item_stream->item_name.assign (item_name);
-	item_stream->service_name.assign (service_name());
-	if (!is_muted_) {
-		if (!SendItemRequest (connection_, item_stream))
-			return false;
-	} else {
-/* no-op */
-	}
-	directory_.emplace_front (item_stream);
-	DVLOG(4) << "Directory size: " << directory_.size();
-        last_activity_ = boost::posix_time::microsec_clock::universal_time();
-	return true;
-}
-
-bool
-chainy::consumer_t::Resubscribe (
-	RsslChannel* c
-	)
-{
-	DCHECK (nullptr != c);
-
-	if (is_muted_) {
-		DVLOG(3) << "Cancelling item resubscription due to pending session.";
-		return true;
-	}
-
-        std::for_each (directory_.begin(),
-			directory_.end(),
-			[&](std::weak_ptr<item_stream_t> it)
-	{
-                if (auto sp = it.lock()) {
-/* only non-fulfilled items */
-                        if (-1 == sp->token)
-                                SendItemRequest (c, sp);
-                }
-        });
-	return true;
-}
-
-void
-chainy::consumer_t::CreateInfo (
-	chainy::ConsumerInfo* info
-	)
-{
-/* address per configuration */
-	info->ip.assign (config_.rssl_server);
-	info->ip.append (":");
-	info->ip.append (config_.upstream_rssl_port);
-
-	if (nullptr != connection_ && RSSL_CH_STATE_ACTIVE == connection_->state) {
-/* on active channel */
-		info->component.assign (component_text_);
-/* on login success */
-		info->app.assign (app_text_);
-	} else {
-		info->component.clear();
-		info->app.clear();
-	}
-
-/* whether consumer is connected, logged in, and active */
-	info->is_active = !is_muted_;
-
-/* app level request count */
-	info->msgs_received = cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED];
-}
-
-void
-chainy::consumer_t::OnActiveReadState (
-	RsslChannel* c
+chainy::consumer_t::SendBatchRequest (
+	RsslChannel* c,
+	int32_t batch_token,
+	const std::vector<std::shared_ptr<item_stream_t>>& items
 	)
 {
+#ifndef NDEBUG
+	RsslRequestMsg request = RSSL_INIT_REQUEST_MSG;
+	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+	RsslElementList	element_list = RSSL_INIT_ELEMENT_LIST;
+	RsslElementEntry element_entry = RSSL_INIT_ELEMENT_ENTRY;
+	RsslArray array = RSSL_INIT_ARRAY;
+        RsslBuffer data_buffer = RSSL_INIT_BUFFER;
+#else
+	RsslRequestMsg request;
+	RsslEncodeIterator it;
+	RsslElementList	element_list;
+	RsslElementEntry element_entry;
+	RsslArray array;
+        RsslBuffer data_buffer;
+	rsslClearRequestMsg (&request);
+	rsslClearEncodeIterator (&it);
+	rsslClearElementList (&element_list);
+	rsslClearElementEntry (&element_entry);
+	rsslClearArray (&array);
+        rsslClearBuffer (&data_buffer);
+#endif
 	RsslBuffer* buf;
-	RsslReadInArgs in_args;
-	RsslReadOutArgs out_args;
 	RsslError rssl_err;
 	RsslRet rc;
 
 	DCHECK (nullptr != c);
+	DCHECK (!items.empty());
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_MARKET_PRICE batch request of " << items.size() << " items.";
 
-	rsslClearReadInArgs (&in_args);
-
-	if (logging::DEBUG_MODE) {
-		rsslClearReadOutArgs (&out_args);
-/* In place of absent API: rsslClearError (&rssl_err); */
-		rssl_err.rsslErrorId = 0;
-		rssl_err.sysError = 0;
-		rssl_err.text[0] = '\0';
-	}
+/* The view applies to every item of the batch. */
+	const bool has_view = GetSession (c)->supports_view && !view_.empty();
 
-	buf = rsslReadEx (c, &in_args, &out_args, &rc, &rssl_err);
-	if (logging::DEBUG_MODE) {
-		std::stringstream return_code;
-		if (rc > 0) {
-			return_code << "\"pendingBytes\": " << static_cast<signed> (rc);
-		} else {
-			return_code << "\"returnCode\": \"" << static_cast<signed> (rc) << ""
-				     ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\"";
-		}
-		VLOG(1) << "rsslReadEx: { "
-			  << return_code.str() << ""
-			", \"bytesRead\": " << out_args.bytesRead << ""
-			", \"uncompressedBytesRead\": " << out_args.uncompressedBytesRead << ""
-			", \"rsslErrorId\": " << rssl_err.rsslErrorId << ""
-			", \"sysError\": " << rssl_err.sysError << ""
-			", \"text\": \"" << rssl_err.text << "\""
-			" }";
-	}
+/* Item names with length prefix follow the request header. */
+	uint32_t size = MAX_MSG_SIZE;
+	for (const auto& item_stream : items)
+		size += static_cast<uint32_t> (item_stream->item_name.size()) + 3;
+	if (has_view)
+		size += static_cast<uint32_t> (view_.size()) * 2;
 
-	cumulative_stats_[CONSUMER_PC_BYTES_RECEIVED] += out_args.bytesRead;
-	cumulative_stats_[CONSUMER_PC_UNCOMPRESSED_BYTES_RECEIVED] += out_args.uncompressedBytesRead;
+/* Set the message model type. */
+	request.msgBase.domainType = RSSL_DMT_MARKET_PRICE;
+/* Set request type. */
+	request.msgBase.msgClass = RSSL_MC_REQUEST;
+	request.flags = RSSL_RQMF_STREAMING | RSSL_RQMF_HAS_BATCH;
+	if (has_view)
+		request.flags |= RSSL_RQMF_HAS_VIEW;
+/* Item list as payload. */
+	request.msgBase.containerType = RSSL_DT_ELEMENT_LIST;
+/* Set the batch token, items follow on consecutive tokens. */
+	request.msgBase.streamId = batch_token;
+
+/* Key without a name, names are carried by the item list. */
+	request.msgBase.msgKey.nameType  = RDM_INSTRUMENT_NAME_TYPE_RIC;
+	request.msgBase.msgKey.serviceId = service_id_;
+        request.msgBase.msgKey.flags = RSSL_MKF_HAS_NAME_TYPE | RSSL_MKF_HAS_SERVICE_ID;
+
+	buf = rsslGetBuffer (c, size, RSSL_FALSE /* not packed */, &rssl_err);
+	if (nullptr == buf) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			", \"size\": " << size << ""
+			", \"packedBuffer\": false"
+			" }";
+		return false;
+	}
+	rc = rsslSetEncodeIteratorBuffer (&it, buf);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"majorVersion\": " << static_cast<unsigned> (c->majorVersion) << ""
+			", \"minorVersion\": " << static_cast<unsigned> (c->minorVersion) << ""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslEncodeMsgInit (&it, reinterpret_cast<RsslMsg*> (&request), size);
+	if (RSSL_RET_ENCODE_CONTAINER != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"dataMaxSize\": " << size << ""
+			" }";
+		goto cleanup;
+	}
+	element_list.flags = RSSL_ELF_HAS_STANDARD_DATA;
+	rc = rsslEncodeElementListInit (&it, &element_list, nullptr /* element id dictionary */, 0 /* count of elements */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"flags\": \"RSSL_ELF_HAS_STANDARD_DATA\""
+			" }";
+		goto cleanup;
+	}
+	element_entry.dataType	= RSSL_DT_ARRAY;
+	element_entry.name	= RSSL_ENAME_BATCH_ITEM_LIST;
+	rc = rsslEncodeElementEntryInit (&it, &element_entry, 0 /* size unknown */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntryInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"name\": \"RSSL_ENAME_BATCH_ITEM_LIST\""
+			", \"dataType\": \"" << rsslDataTypeToString (element_entry.dataType) << "\""
+			" }";
+		goto cleanup;
+	}
+	array.primitiveType = RSSL_DT_ASCII_STRING;
+	array.itemLength = 0;	/* variable length entries */
+	rc = rsslEncodeArrayInit (&it, &array);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	for (const auto& item_stream : items) {
+		data_buffer.data   = const_cast<char*> (item_stream->item_name.c_str());
+		data_buffer.length = static_cast<uint32_t> (item_stream->item_name.size());
+		rc = rsslEncodeArrayEntry (&it, nullptr, &data_buffer);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayEntry: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				", \"itemName\": \"" << item_stream->item_name << "\""
+				" }";
+			goto cleanup;
+		}
+	}
+	rc = rsslEncodeArrayComplete (&it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslEncodeElementEntryComplete (&it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntryComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	if (has_view && !EncodeView (c, &it))
+		goto cleanup;
+	rc = rsslEncodeElementListComplete (&it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementListComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslEncodeMsgComplete (&it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsgComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	buf->length = rsslGetEncodedBufferLength (&it);
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
+
+	if (DCHECK_IS_ON()) {
+/* Message validation: must use ASSERT libraries for error description :/ */
+		if (!rsslValidateMsg (reinterpret_cast<RsslMsg*> (&request))) {
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_MALFORMED]++;
+			LOG(ERROR) << GetSession (c)->prefix << "rsslValidateMsg failed.";
+			goto cleanup;
+		} else {
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VALIDATED]++;
+			DVLOG(4) << GetSession (c)->prefix << "rsslValidateMsg succeeded.";
+		}
+	}
+
+	if (!Submit (c, buf)) {
+		goto cleanup;
+	} else {
+		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_BATCH_SENT]++;
+		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_SENT] += static_cast<uint32_t> (items.size());
+		if (has_view)
+			cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_VIEW_REQUESTED] += static_cast<uint32_t> (items.size());
+/* update session state only on success, request again on failure. */
+		upstream_t* session = GetSession (c);
+		for (const auto& item_stream : items)
+			session->requests.emplace (item_stream->token, false);
+		return true;
+	}
+cleanup:
+	cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_BATCH_EXCEPTION]++;
+	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			" }";
+	}
+	return false;
+}
+
+/* Encode the field id view into an open element list of a request.
+ */
+bool
+chainy::consumer_t::EncodeView (
+	RsslChannel* c,
+	RsslEncodeIterator* it
+	)
+{
+#ifndef NDEBUG
+	RsslElementEntry element_entry = RSSL_INIT_ELEMENT_ENTRY;
+	RsslArray array = RSSL_INIT_ARRAY;
+#else
+	RsslElementEntry element_entry;
+	RsslArray array;
+	rsslClearElementEntry (&element_entry);
+	rsslClearArray (&array);
+#endif
+	RsslUInt view_type = RDM_VIEW_TYPE_FIELD_ID_LIST;
+	RsslRet rc;
+
+	DCHECK (!view_.empty());
+	element_entry.dataType	= RSSL_DT_UINT;
+	element_entry.name	= RSSL_ENAME_VIEW_TYPE;
+	rc = rsslEncodeElementEntry (it, &element_entry, &view_type);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntry: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"name\": \"RSSL_ENAME_VIEW_TYPE\""
+			", \"dataType\": \"" << rsslDataTypeToString (element_entry.dataType) << "\""
+			" }";
+		return false;
+	}
+	element_entry.dataType	= RSSL_DT_ARRAY;
+	element_entry.name	= RSSL_ENAME_VIEW_DATA;
+	rc = rsslEncodeElementEntryInit (it, &element_entry, 0 /* size unknown */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntryInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"name\": \"RSSL_ENAME_VIEW_DATA\""
+			", \"dataType\": \"" << rsslDataTypeToString (element_entry.dataType) << "\""
+			" }";
+		return false;
+	}
+	array.primitiveType = RSSL_DT_INT;
+	array.itemLength = 2;	/* fixed width field identifiers */
+	rc = rsslEncodeArrayInit (it, &array);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayInit: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	for (const auto fid : view_) {
+		const RsslInt value = fid;
+		rc = rsslEncodeArrayEntry (it, nullptr, &value);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayEntry: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				", \"fid\": " << fid << ""
+				" }";
+			return false;
+		}
+	}
+	rc = rsslEncodeArrayComplete (it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeArrayComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	rc = rsslEncodeElementEntryComplete (it, RSSL_TRUE /* commit */);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeElementEntryComplete: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		return false;
+	}
+	return true;
+}
+
+/* Request item streams on a session, in batches when the provider supports
+ * them.  Items open on neither session are moved to a fresh run of tokens
+ * following a batch token.  Items open on the other session keep their tokens,
+ * a prefix of an earlier batch is requested again as a batch with the same
+ * batch token, all others alone.
+ */
+bool
+chainy::consumer_t::SendItemRequests (
+	RsslChannel* c,
+	const std::vector<std::shared_ptr<item_stream_t>>& items
+	)
+{
+	upstream_t* session = GetSession (c);
+	const upstream_t* other = (session == active_) ? standby_ : active_;
+	const size_t batch_size = config_.request_batch_size;
+	std::vector<std::shared_ptr<item_stream_t>> fresh, held;
+
+	if (!session->supports_batch || batch_size < 2) {
+		for (const auto& item_stream : items) {
+			if (!SendItemRequest (c, item_stream))
+				return false;
+		}
+		return true;
+	}
+
+	for (const auto& item_stream : items) {
+		if (0 == other->requests.count (item_stream->token))
+			fresh.push_back (item_stream);
+		else
+			held.push_back (item_stream);
+	}
+
+	for (size_t i = 0; i < fresh.size(); i += batch_size) {
+		const std::vector<std::shared_ptr<item_stream_t>> batch (fresh.begin() + i, fresh.begin() + std::min (i + batch_size, fresh.size()));
+		if (1 == batch.size()) {
+			if (!SendItemRequest (c, batch.front()))
+				return false;
+			continue;
+		}
+		const int32_t batch_token = token_++;
+		for (const auto& item_stream : batch) {
+			tokens_.erase (item_stream->token);
+			item_stream->token = token_++;
+			item_stream->batch_token = batch_token;
+			tokens_.emplace (item_stream->token, item_stream);
+		}
+		if (!SendBatchRequest (c, batch_token, batch))
+			return false;
+	}
+
+	std::sort (held.begin(), held.end(), [](const std::shared_ptr<item_stream_t>& lhs, const std::shared_ptr<item_stream_t>& rhs) {
+		return lhs->token < rhs->token;
+	});
+	for (size_t i = 0; i < held.size();) {
+		const int32_t batch_token = held[i]->batch_token;
+		size_t count = 1;
+		if (-1 != batch_token && held[i]->token == batch_token + 1) {
+			while (i + count < held.size()
+				&& count < batch_size
+				&& held[i + count]->batch_token == batch_token
+				&& held[i + count]->token == held[i]->token + static_cast<int32_t> (count))
+			{
+				++count;
+			}
+		}
+		if (1 == count) {
+			if (!SendItemRequest (c, held[i]))
+				return false;
+		} else {
+			const std::vector<std::shared_ptr<item_stream_t>> batch (held.begin() + i, held.begin() + i + count);
+			if (!SendBatchRequest (c, batch_token, batch))
+				return false;
+		}
+		i += count;
+	}
+	return true;
+}
+
+/* Cancel an open item stream with the upstream provider.
+ */
+bool
+chainy::consumer_t::SendItemClose (
+	RsslChannel* c,
+        std::shared_ptr<item_stream_t> item_stream
+	)
+{
+#ifndef NDEBUG
+	RsslCloseMsg request = RSSL_INIT_CLOSE_MSG;
+	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+#else
+	RsslCloseMsg request;
+	RsslEncodeIterator it;
+	rsslClearCloseMsg (&request);
+	rsslClearEncodeIterator (&it);
+#endif
+	RsslBuffer* buf;
+	RsslError rssl_err;
+	RsslRet rc;
+
+	DCHECK (nullptr != c);
+	DCHECK (-1 != item_stream->token);
+	VLOG(2) << GetSession (c)->prefix << "Sending MMT_MARKET_PRICE close.";
+
+/* Set the message model type. */
+	request.msgBase.domainType = RSSL_DMT_MARKET_PRICE;
+/* Set request type. */
+	request.msgBase.msgClass = RSSL_MC_CLOSE;
+	request.msgBase.containerType = RSSL_DT_NO_DATA;
+/* Set the stream token. */
+	request.msgBase.streamId = item_stream->token;
+
+	buf = rsslGetBuffer (c, MAX_MSG_SIZE, RSSL_FALSE /* not packed */, &rssl_err);
+	if (nullptr == buf) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslGetBuffer: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			", \"size\": " << MAX_MSG_SIZE << ""
+			", \"packedBuffer\": false"
+			" }";
+		return false;
+	}
+	rc = rsslSetEncodeIteratorBuffer (&it, buf);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"majorVersion\": " << static_cast<unsigned> (c->majorVersion) << ""
+			", \"minorVersion\": " << static_cast<unsigned> (c->minorVersion) << ""
+			" }";
+		goto cleanup;
+	}
+	rc = rsslEncodeMsg (&it, reinterpret_cast<RsslMsg*> (&request));
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslEncodeMsg: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
+		goto cleanup;
+	}
+	buf->length = rsslGetEncodedBufferLength (&it);
+	LOG_IF(WARNING, 0 == buf->length) << GetSession (c)->prefix << "rsslGetEncodedBufferLength returned 0.";
+
+	if (!Submit (c, buf)) {
+		goto cleanup;
+	} else {
+		cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_CLOSE_SENT]++;
+		return true;
+	}
+cleanup:
+	cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_CLOSE_EXCEPTION]++;
+	if (RSSL_RET_SUCCESS != rsslReleaseBuffer (buf, &rssl_err)) {
+		LOG(WARNING) << GetSession (c)->prefix << "rsslReleaseBuffer: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			" }";
+	}
+	return false;
+}
+
+/* Create an item stream for a given symbol name.  The Item Stream maintains
+ * the provider state on behalf of the application.  The upstream request is
+ * sent by the message pump and retried until sent, creation cannot fail.
+ */
+bool
+chainy::consumer_t::CreateItemStream (
+        const char* item_name,
+        std::shared_ptr<item_stream_t> item_stream
+        )
+{
+        VLOG(4) << "Creating item stream for RIC \"" << item_name << "\".";
+	item_stream->item_name.assign (item_name);
+	item_stream->service_name.assign (service_name());
+	item_stream->token = token_++;
+	item_stream->batch_token = -1;
+	tokens_.emplace (item_stream->token, item_stream);
+	directory_.emplace_front (item_stream);
+	item_stream->directory_entry = directory_.begin();
+	item_stream->is_listed = true;
+	DVLOG(4) << "Directory size: " << directory_.size();
+/* requested with other items created by the same pass of the message pump */
+	pending_.push_back (item_stream);
+	return true;
+}
+
+/* Remove an item stream from the watchlist, the upstream subscription is
+ * cancelled if one is open.  Late responses on the token are discarded.
+ */
+bool
+chainy::consumer_t::CloseItemStream (
+        std::shared_ptr<item_stream_t> item_stream
+        )
+{
+        VLOG(4) << "Closing item stream for RIC \"" << item_stream->item_name << "\".";
+	if (-1 != item_stream->token) {
+		for (auto& session : sessions_) {
+			auto request = session.requests.find (item_stream->token);
+			if (request == session.requests.end())
+				continue;
+			if (!session.is_muted)
+				SendItemClose (session.channel, item_stream);
+			if (request->second)
+				session.refresh_count--;
+			session.requests.erase (request);
+		}
+		tokens_.erase (item_stream->token);
+		item_stream->token = -1;
+	}
+/* Release last value cache. */
+	if (nullptr != item_stream->standby_entry_handle) {
+		rsslPayloadEntryDestroy (item_stream->standby_entry_handle);
+		item_stream->standby_entry_handle = nullptr;
+	}
+	cumulative_stats_[CONSUMER_PC_ITEM_STREAM_CLOSED]++;
+/* Remove from synchronisation accounting. */
+	if (0 != item_stream->refresh_received || item_stream->is_closed) {
+		DCHECK_GT (refresh_count_, 0U);
+		refresh_count_--;
+	}
+	item_stream->is_closed = true;
+	if (item_stream->is_listed) {
+		directory_.erase (item_stream->directory_entry);
+		item_stream->is_listed = false;
+	}
+	DVLOG(4) << "Directory size: " << directory_.size();
+	CheckSyncState();
+	return true;
+}
+
+bool
+chainy::consumer_t::Resubscribe (
+	RsslChannel* c
+	)
+{
+	DCHECK (nullptr != c);
+
+	upstream_t* session = GetSession (c);
+	if (session->is_muted) {
+		DVLOG(3) << "Cancelling item resubscription due to pending session.";
+		return true;
+	}
+
+	std::vector<std::shared_ptr<item_stream_t>> items;
+        std::for_each (directory_.begin(),
+			directory_.end(),
+			[&](std::weak_ptr<item_stream_t> it)
+	{
+                if (auto sp = it.lock()) {
+/* only items not open on this session nor closed upstream */
+                        if (!sp->is_closed && 0 == session->requests.count (sp->token))
+                                items.push_back (sp);
+                }
+        });
+	SendItemRequests (c, items);
+/* failures on the active session are retried with items created since */
+	if (session == active_) {
+		for (const auto& sp : items) {
+			if (0 == session->requests.count (sp->token))
+				pending_.push_back (sp);
+		}
+	}
+	return true;
+}
+
+void
+chainy::consumer_t::CreateInfo (
+	chainy::ConsumerInfo* info
+	)
+{
+/* address per configuration */
+	info->ip.assign (config_.rssl_servers[active_->server]);
+	info->ip.append (":");
+	info->ip.append (config_.upstream_rssl_port);
+
+	if (nullptr != active_->channel && RSSL_CH_STATE_ACTIVE == active_->channel->state) {
+/* on active channel */
+		info->component.assign (active_->component_text);
+/* on login success */
+		info->app.assign (active_->app_text);
+	} else {
+		info->component.clear();
+		info->app.clear();
+	}
+
+/* whether consumer is connected, logged in, and active */
+	info->is_active = !active_->is_muted;
+
+/* app level request count */
+	info->msgs_received = cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED];
+
+/* warm standby */
+	if (config_.warm_standby) {
+		info->standby_ip.assign (config_.rssl_servers[standby_->server]);
+		info->standby_ip.append (":");
+		info->standby_ip.append (config_.upstream_rssl_port);
+	} else {
+		info->standby_ip.clear();
+	}
+	info->is_standby_active = !standby_->is_muted;
+	info->standby_msgs_received = cumulative_stats_[CONSUMER_PC_STANDBY_MSGS_RECEIVED];
+	info->standby_promoted = cumulative_stats_[CONSUMER_PC_STANDBY_PROMOTED];
+
+/* open and closed item streams */
+	info->item_streams = static_cast<unsigned> (directory_.size());
+	info->item_streams_closed = cumulative_stats_[CONSUMER_PC_ITEM_STREAM_CLOSED];
+}
+
+/* Upstream bursts of refreshes after a reconnect would otherwise starve the
+ * standby session and timers, read until drained or the budget is spent.
+ */
+void
+chainy::consumer_t::OnActiveReadState (
+	RsslChannel* c
+	)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds (config_.read_budget_time);
+	unsigned reads = 0;
+	RsslRet rc;
+
+	DCHECK (nullptr != c);
+
+	cumulative_stats_[CONSUMER_PC_RSSL_READ_BATCHES]++;
+	do {
+		rc = OnRead (c);
+		++reads;
+/* session closed by the read, the channel is pending removal */
+		if (selector_.IsReady (c->socketId, selector_t::kException))
+			return;
+	} while (rc > 0
+		&& reads < config_.read_budget
+		&& (0 != reads % kReadsPerClockSample || std::chrono::steady_clock::now() < deadline));
+	if (rc > 0) {
+		cumulative_stats_[CONSUMER_PC_RSSL_READ_BUDGET_EXHAUSTED]++;
+/* pending buffer needs flushing out before IO notification can resume */
+		selector_.SetReady (c->socketId, selector_t::kReadable);
+	}
+}
+
+/* Returns pending byte count from one rsslReadEx. */
+RsslRet
+chainy::consumer_t::OnRead (
+	RsslChannel* c
+	)
+{
+	RsslBuffer* buf;
+	RsslReadInArgs in_args;
+	RsslReadOutArgs out_args;
+	RsslError rssl_err;
+	RsslRet rc;
+
+	DCHECK (nullptr != c);
+
+	rsslClearReadInArgs (&in_args);
+
+	if (logging::DEBUG_MODE) {
+		rsslClearReadOutArgs (&out_args);
+/* In place of absent API: rsslClearError (&rssl_err); */
+		rssl_err.rsslErrorId = 0;
+		rssl_err.sysError = 0;
+		rssl_err.text[0] = '\0';
+	}
+
+	buf = rsslReadEx (c, &in_args, &out_args, &rc, &rssl_err);
+	if (logging::DEBUG_MODE) {
+		std::stringstream return_code;
+		if (rc > 0) {
+			return_code << "\"pendingBytes\": " << static_cast<signed> (rc);
+		} else {
+			return_code << "\"returnCode\": \"" << static_cast<signed> (rc) << ""
+				     ", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\"";
+		}
+		VLOG(1) << "rsslReadEx: { "
+			  << return_code.str() << ""
+			", \"bytesRead\": " << out_args.bytesRead << ""
+			", \"uncompressedBytesRead\": " << out_args.uncompressedBytesRead << ""
+			", \"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			" }";
+	}
+
+	upstream_t* session = GetSession (c);
+/* standby traffic is accounted apart from the active feed */
+	if (session->is_standby) {
+		cumulative_stats_[CONSUMER_PC_STANDBY_BYTES_RECEIVED] += out_args.bytesRead;
+	} else {
+		cumulative_stats_[CONSUMER_PC_BYTES_RECEIVED] += out_args.bytesRead;
+		cumulative_stats_[CONSUMER_PC_UNCOMPRESSED_BYTES_RECEIVED] += out_args.uncompressedBytesRead;
+	}
 
 	switch (rc) {
 /* Reliable multicast events with hard-fail override. */
@@ -1479,12 +2345,12 @@ check_closed_state:
 	case RSSL_RET_READ_FD_CHANGE:
 		cumulative_stats_[CONSUMER_PC_RSSL_RECONNECT]++;
 		LOG(INFO) << "RSSL reconnected.";
-		FD_CLR (c->oldSocketId, &in_rfds_); FD_SET (c->socketId, &in_rfds_);
-		FD_CLR (c->oldSocketId, &in_efds_); FD_SET (c->socketId, &in_efds_);
+		selector_.Unset (c->oldSocketId, selector_t::kReadable | selector_t::kException);
+		selector_.Set (c->socketId, selector_t::kReadable | selector_t::kException);
 		break;
 	case RSSL_RET_READ_PING:
 		cumulative_stats_[CONSUMER_PC_RSSL_PONG_RECEIVED]++;
-		SetNextPong (last_activity_ + boost::posix_time::seconds (c->pingTimeout));
+		session->next_pong = last_activity_ + SecondsToTicks (c->pingTimeout);
 		DVLOG(1) << "RSSL pong.";
 		break;
 	case RSSL_RET_FAILURE:
@@ -1504,17 +2370,14 @@ check_closed_state:
 	case RSSL_RET_SUCCESS:
 	default: 
 		if (nullptr != buf) {
-			cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED]++;
+			cumulative_stats_[session->is_standby ? CONSUMER_PC_STANDBY_MSGS_RECEIVED : CONSUMER_PC_RSSL_MSGS_RECEIVED]++;
 			OnMsg (c, buf);
 /* Received data equivalent to a heartbeat pong. */
-			SetNextPong (last_activity_ + boost::posix_time::seconds (c->pingTimeout));
-		}
-		if (rc > 0) {
-/* pending buffer needs flushing out before IO notification can resume */
-			FD_SET (c->socketId, &out_rfds_);
+			session->next_pong = last_activity_ + SecondsToTicks (c->pingTimeout);
 		}
 		break;
 	}
+	return rc;
 }
 
 void
@@ -1607,7 +2470,8 @@ chainy::consumer_t::OnMsg (
 {
         DCHECK (nullptr != it);
         DCHECK (nullptr != msg);
-        cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED]++;
+	if (!GetSession (c)->is_standby)
+		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_RECEIVED]++;
 
         switch (msg->msgBase.domainType) {
 	case RSSL_DMT_LOGIN:
@@ -1620,7 +2484,7 @@ chainy::consumer_t::OnMsg (
 		return OnDictionary (c, it, msg);
 	default:
                 cumulative_stats_[CONSUMER_PC_RSSL_MSGS_REJECTED]++;
-                LOG(WARNING) << prefix_ << "Uncaught message: " << msg;
+                LOG(WARNING) << GetSession (c)->prefix << "Uncaught message: " << msg;
                 return true;
         }
 }
@@ -1645,7 +2509,7 @@ chainy::consumer_t::OnLoginResponse (
         cumulative_stats_[CONSUMER_PC_MMT_LOGIN_RECEIVED]++;
 	rc = rsslDecodeRDMLoginMsg (it, msg, &response, &data_buffer, &rssl_err_info);
 	if (RSSL_RET_BUFFER_TOO_SMALL == rc) {
-		LOG(ERROR) << prefix_ << "rsslDecodeRDMLoginMsg: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslDecodeRDMLoginMsg: { "
 				  "\"returnCode\": " << static_cast<signed> (rc) << ""
 				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1654,7 +2518,7 @@ chainy::consumer_t::OnLoginResponse (
 	}
 	if (RSSL_RET_SUCCESS != rc) {
 		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_MALFORMED]++;
-		LOG(WARNING) << prefix_ << "rsslDecodeRDMLoginMsg: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslDecodeRDMLoginMsg: { "
 				  "\"rsslErrorInfoCode\": \"" << internal::error_info_code_string (rssl_err_info.rsslErrorInfoCode) << "\""
 				", \"rsslError\": { "
 					  "\"rsslErrorId\": " << rssl_err_info.rsslError.rsslErrorId << ""
@@ -1689,7 +2553,7 @@ chainy::consumer_t::OnLoginResponse (
 	case RDM_LG_MT_ACK:
 	default:
                 cumulative_stats_[CONSUMER_PC_MMT_LOGIN_DISCARDED]++;
-		LOG(WARNING) << prefix_ << "Uncaught: " << msg;
+		LOG(WARNING) << GetSession (c)->prefix << "Uncaught: " << msg;
 	}
 
 	switch (state.streamState) {
@@ -1703,7 +2567,7 @@ chainy::consumer_t::OnLoginResponse (
 // by-definition, ignore
 			return true;;
 		default:
-			LOG(WARNING) << prefix_ << "Uncaught data state: " << msg;
+			LOG(WARNING) << GetSession (c)->prefix << "Uncaught data state: " << msg;
 			return true;
 		}
 
@@ -1711,7 +2575,7 @@ chainy::consumer_t::OnLoginResponse (
 		return OnLoginClosed (c, response);
 
 	default:
-		LOG(WARNING) << prefix_ << "Uncaught stream state: " << msg;
+		LOG(WARNING) << GetSession (c)->prefix << "Uncaught stream state: " << msg;
 		return true;
 	}
 }
@@ -1737,7 +2601,7 @@ chainy::consumer_t::OnDirectory (
         cumulative_stats_[CONSUMER_PC_MMT_DIRECTORY_RECEIVED]++;
 	rc = rsslDecodeRDMDirectoryMsg (it, msg, &response, &data_buffer, &rssl_err_info);
 	if (RSSL_RET_BUFFER_TOO_SMALL == rc) {
-		LOG(ERROR) << prefix_ << "rsslDecodeRDMDirectoryMsg: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslDecodeRDMDirectoryMsg: { "
 				  "\"returnCode\": " << static_cast<signed> (rc) << ""
 				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1746,7 +2610,7 @@ chainy::consumer_t::OnDirectory (
 	}
 	if (RSSL_RET_SUCCESS != rc) {
 		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_MALFORMED]++;
-		LOG(WARNING) << prefix_ << "rsslDecodeRDMDirectoryMsg: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslDecodeRDMDirectoryMsg: { "
 				  "\"rsslErrorInfoCode\": \"" << internal::error_info_code_string (rssl_err_info.rsslErrorInfoCode) << "\""
 				", \"rsslError\": { "
 					  "\"rsslErrorId\": " << rssl_err_info.rsslError.rsslErrorId << ""
@@ -1767,7 +2631,7 @@ chainy::consumer_t::OnDirectory (
 	case RDM_DR_MT_CLOSE:
 	case RDM_DR_MT_STATUS:
 	default:
-		LOG(WARNING) << prefix_ << "Uncaught directory response message type: " << msg;
+		LOG(WARNING) << GetSession (c)->prefix << "Uncaught directory response message type: " << msg;
 		return true;
 	}
 }
@@ -1795,19 +2659,30 @@ chainy::consumer_t::OnDirectoryRefresh (
 		}
 	}
 
+	upstream_t* session = GetSession (c);
+	session->has_directory = true;
 /* Request on first directory message, can be messy with multiple refresh messages
- * being received before dictionary response.
+ * being received before dictionary response.  The dictionary is shared by
+ * each session and requested only by the active session.
  */
 	if (!rdm_dictionary_.isInitialized) {
+		if (session->is_standby)
+			return true;
 		if (0 == response.serviceCount) {
-			LOG(WARNING) << prefix_ << "Upstream provider has no configured services, unable to request a dictionary.";
+			LOG(WARNING) << GetSession (c)->prefix << "Upstream provider has no configured services, unable to request a dictionary.";
 			return true;
 		}
 		const RsslRDMService& service = response.serviceList[0];
-/* Hard code to RDM dictionary for TREP deployment. */
-		if (!SendDictionaryRequest (c, static_cast<uint16_t> (service.serviceId), kRdmFieldDictionaryName))
+/* Hard code to RDM dictionary for TREP deployment, a cached dictionary is
+ * validated by version before the download is skipped.
+ */
+		const uint32_t verbosity = ((bool)dictionary_cache_ && dictionary_cache_->is_open()) ? RDM_DICTIONARY_INFO : RDM_DICTIONARY_MINIMAL;
+		if (!SendDictionaryRequest (c, static_cast<uint16_t> (service.serviceId), kRdmFieldDictionaryName, verbosity))
 			return false;
 	}
+/* Dictionary retained from an earlier session. */
+	if (nullptr != cache_handle_)
+		session->is_muted = false;
 
 	return Resubscribe (c);
 }
@@ -1854,7 +2729,7 @@ chainy::consumer_t::OnDictionary (
         cumulative_stats_[CONSUMER_PC_MMT_DICTIONARY_RECEIVED]++;
 	rc = rsslDecodeRDMDictionaryMsg (it, msg, &response, &data_buffer, &rssl_err_info);
 	if (RSSL_RET_BUFFER_TOO_SMALL == rc) {
-		LOG(ERROR) << prefix_ << "rsslDecodeRDMDictionaryMsg: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslDecodeRDMDictionaryMsg: { "
 				  "\"returnCode\": " << static_cast<signed> (rc) << ""
 				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
@@ -1863,7 +2738,7 @@ chainy::consumer_t::OnDictionary (
 	}
 	if (RSSL_RET_SUCCESS != rc) {
 		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_MALFORMED]++;
-		LOG(WARNING) << prefix_ << "rsslDecodeRDMDirectoryMsg: { "
+		LOG(WARNING) << GetSession (c)->prefix << "rsslDecodeRDMDirectoryMsg: { "
 				  "\"rsslErrorInfoCode\": \"" << internal::error_info_code_string (rssl_err_info.rsslErrorInfoCode) << "\""
 				", \"rsslError\": { "
 					  "\"rsslErrorId\": " << rssl_err_info.rsslError.rsslErrorId << ""
@@ -1877,13 +2752,13 @@ chainy::consumer_t::OnDictionary (
 
 	switch (response.rdmMsgBase.rdmMsgType) {
 	case RDM_DC_MT_REFRESH:
-		return OnDictionaryRefresh (c, it, response.refresh);
+		return OnDictionaryRefresh (c, it, msg, response.refresh);
 /* Status can show a new dictionary but is not implemented in TREP-RT infrastructure, so ignore. */
 	case RDM_DC_MT_STATUS:
 /* Close should only happen when the infrastructure is in shutdown, defer to closed MMT_LOGIN. */
 	case RDM_DC_MT_CLOSE:
 	default:
-		LOG(WARNING) << prefix_ << "Uncaught dictionay response message type: " << msg;
+		LOG(WARNING) << GetSession (c)->prefix << "Uncaught dictionay response message type: " << msg;
 		return true;
 	}
 }
@@ -1895,6 +2770,7 @@ bool
 chainy::consumer_t::OnDictionaryRefresh (
 	RsslChannel* c,
 	RsslDecodeIterator* it,
+	RsslMsg* msg,
 	const RsslRDMDictionaryRefresh& response
 	)
 {
@@ -1905,9 +2781,33 @@ chainy::consumer_t::OnDictionaryRefresh (
         DCHECK (nullptr != c);
 
 	DLOG(INFO) << "OnDictionaryRefresh";
+	if (0 != (response.flags & RDM_DC_RFF_HAS_INFO))
+		dictionary_version_.assign (response.version.data, response.version.length);
+
+/* Version probe of the cached dictionary, decoded locally on a match. */
+	if (RDM_DICTIONARY_INFO == dictionary_verbosity_) {
+		DCHECK ((bool)dictionary_cache_);
+		if (!dictionary_version_.empty()
+			&& dictionary_version_ == dictionary_cache_->version()
+			&& dictionary_cache_->Decode (&rdm_dictionary_))
+		{
+			cumulative_stats_[CONSUMER_PC_DICTIONARY_CACHE_HIT]++;
+			LOG(INFO) << GetSession (c)->prefix << "Field dictionary version \"" << dictionary_version_ << "\" loaded from cache.";
+			return OnDictionaryComplete (c);
+		}
+		cumulative_stats_[CONSUMER_PC_DICTIONARY_CACHE_MISS]++;
+		LOG(INFO) << GetSession (c)->prefix << "Field dictionary cache version \"" << dictionary_cache_->version() << "\" unusable for upstream version \"" << dictionary_version_ << "\", requesting in full.";
+		if (rdm_dictionary_.isInitialized)
+			rsslDeleteDataDictionary (&rdm_dictionary_);
+		dictionary_cache_->Close();
+		return SendDictionaryRequest (c, dictionary_service_id_, kRdmFieldDictionaryName, RDM_DICTIONARY_MINIMAL);
+	}
+
+	if ((bool)dictionary_cache_)
+		dictionary_cache_->Append (c->majorVersion, c->minorVersion, msg->msgBase.encDataBody);
 	rc = rsslDecodeFieldDictionary (it, &rdm_dictionary_, RDM_DICTIONARY_MINIMAL, &data_buffer);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(ERROR) << prefix_ << "rsslDecodeFieldDictionary: { "
+		LOG(ERROR) << GetSession (c)->prefix << "rsslDecodeFieldDictionary: { "
 			  "\"text\": \"" << std::string (data_buffer.data, data_buffer.length) << "\""
 			" }";
 		return false;
@@ -1920,38 +2820,65 @@ chainy::consumer_t::OnDictionaryRefresh (
  * }
  */
 	if (0 != (response.flags & RDM_DC_RFF_IS_COMPLETE)) {
-		RsslPayloadCacheConfigOptions cache_config;
-		RsslCacheError rssl_cache_err;
+		if ((bool)dictionary_cache_ && dictionary_cache_->Commit (dictionary_version_))
+			dictionary_cache_->Open();
+		return OnDictionaryComplete (c);
+	}
+	return true;
+}
+
+/* Field dictionary loaded by retrieval or from cache, rebuild the last value
+ * cache and permit item requests.
+ */
+bool
+chainy::consumer_t::OnDictionaryComplete (
+	RsslChannel* c
+	)
+{
+	RsslPayloadCacheConfigOptions cache_config;
+	RsslCacheError rssl_cache_err;
+	RsslRet rc;
 
-		rsslCacheErrorClear (&rssl_cache_err);
+	rsslCacheErrorClear (&rssl_cache_err);
 
-		VLOG(3) << "Dictionary reception complete.";
+	VLOG(3) << "Dictionary reception complete.";
 
 /* Re/build cache on demand to permit new dictionary. */
-		if (nullptr != cache_handle_) {
-			rsslPayloadCacheDestroy (cache_handle_);
-		}
-		cache_config.maxItems = 0;	// unlimited
-		cache_handle_ = rsslPayloadCacheCreate (&cache_config, &rssl_cache_err);
-		if (nullptr == cache_handle_) {
-			LOG(ERROR) << prefix_ << "rsslPayloadCacheCreate: { "
-				  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
-				", \"text\": \"" << rssl_cache_err.text << "\""
-				" }";
-			return false;
+	if (nullptr != cache_handle_) {
+		rsslPayloadCacheDestroy (cache_handle_);
+/* entries are destroyed with the cache */
+		for (auto it = directory_.begin(); it != directory_.end(); ++it) {
+			if (auto sp = it->lock())
+				sp->standby_entry_handle = nullptr;
 		}
+	}
+	cache_config.maxItems = 0;	// unlimited
+	cache_handle_ = rsslPayloadCacheCreate (&cache_config, &rssl_cache_err);
+	if (nullptr == cache_handle_) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslPayloadCacheCreate: { "
+			  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
+			", \"text\": \"" << rssl_cache_err.text << "\""
+			" }";
+		return false;
+	}
 /* Bind the new dictionary into the cache object. */
-		rc = rsslPayloadCacheSetDictionary (cache_handle_, &rdm_dictionary_, kRdmFieldDictionaryName.c_str(), &rssl_cache_err);
-		if (RSSL_RET_SUCCESS != rc) {
-			LOG(ERROR) << prefix_ << "rsslPayloadCacheSetDictionary: { "
-				  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
-				", \"text\": \"" << rssl_cache_err.text << "\""
-				" }";
+	rc = rsslPayloadCacheSetDictionary (cache_handle_, &rdm_dictionary_, kRdmFieldDictionaryName.c_str(), &rssl_cache_err);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslPayloadCacheSetDictionary: { "
+			  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
+			", \"text\": \"" << rssl_cache_err.text << "\""
+			" }";
+		return false;
+	}
+	if (!delegate_->OnDictionary (rdm_dictionary_))
+		return false;
+/* Permit new subscriptions on each session with a directory. */
+	for (auto& session : sessions_) {
+		if (nullptr == session.channel || !session.has_directory)
+			continue;
+		session.is_muted = false;
+		if (!Resubscribe (session.channel) && session.channel == c)
 			return false;
-		}
-/* Permit new subscriptions. */
-		is_muted_ = false;
-		return Resubscribe (c);
 	}
 	return true;
 }
@@ -1969,8 +2896,16 @@ chainy::consumer_t::OnLoginSuccess (
 		if (0 != (response.refresh.flags & RDM_LG_RFF_HAS_APPLICATION_NAME)) {
 			chromium::StringPiece application_name (response.refresh.applicationName.data,
 								response.refresh.applicationName.length);
-			app_text_.assign (application_name.as_string());
-			LOG(INFO) << prefix_ << "applicationName: \"" << application_name << "\"";
+			GetSession (c)->app_text.assign (application_name.as_string());
+			LOG(INFO) << GetSession (c)->prefix << "applicationName: \"" << application_name << "\"";
+		}
+		if (0 != (response.refresh.flags & RDM_LG_RFF_HAS_SUPPORT_BATCH)) {
+			GetSession (c)->supports_batch = 0 != response.refresh.supportBatchRequests;
+			VLOG(1) << GetSession (c)->prefix << "supportBatchRequests: " << response.refresh.supportBatchRequests;
+		}
+		if (0 != (response.refresh.flags & RDM_LG_RFF_HAS_SUPPORT_VIEW)) {
+			GetSession (c)->supports_view = 0 != response.refresh.supportViewRequests;
+			VLOG(1) << GetSession (c)->prefix << "supportViewRequests: " << response.refresh.supportViewRequests;
 		}
 	default:
 		break;
@@ -1986,7 +2921,7 @@ chainy::consumer_t::OnLoginSuspect (
 	)
 {
 	DLOG(INFO) << "OnLoginSuspect";
-	is_muted_ = true;
+	GetSession (c)->is_muted = true;
 	return true;
 }
 
@@ -1997,7 +2932,7 @@ chainy::consumer_t::OnLoginClosed (
 	)
 {
 	DLOG(INFO) << "OnLoginClosed";
-	is_muted_ = true;
+	GetSession (c)->is_muted = true;
 	return true;
 }
 
@@ -2013,18 +2948,45 @@ chainy::consumer_t::OnMarketPrice (
 	DCHECK(nullptr != handle);
         DCHECK(nullptr != it);
         DCHECK(nullptr != msg);
-	DCHECK(!tokens_.empty());
-	DCHECK(tokens_.find (msg->msgBase.streamId) != tokens_.end());
+
+	if (GetSession (handle)->is_standby)
+		return OnStandbyMarketPrice (handle, it, msg);
 
         cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_RECEIVED]++;
-/* complete failure if we are sent a bogus token */
-	auto stream = tokens_[msg->msgBase.streamId].lock();
+/* responses may still be in flight for a token closed by the application */
+	auto search = tokens_.find (msg->msgBase.streamId);
+	if (search == tokens_.end()) {
+		cumulative_stats_[CONSUMER_PC_RESPONSE_MSGS_DISCARDED]++;
+		DVLOG(3) << GetSession (handle)->prefix << "Discarding response on closed token " << msg->msgBase.streamId << ".";
+		return true;
+	}
+	auto stream = search->second.lock();
+	if (!(bool)stream) {
+		cumulative_stats_[CONSUMER_PC_RESPONSE_MSGS_DISCARDED]++;
+		tokens_.erase (search);
+		return true;
+	}
+
+/* Session accounting of the request. */
+	auto request = active_->requests.find (msg->msgBase.streamId);
+	if (request != active_->requests.end()) {
+		if (rsslIsFinalMsg (msg)) {
+			if (request->second)
+				active_->refresh_count--;
+			active_->requests.erase (request);
+		} else if (RSSL_MC_REFRESH == msg->msgBase.msgClass && !request->second) {
+			request->second = true;
+			active_->refresh_count++;
+		}
+	}
 
 /* Verify stream state. */
 	if (rsslIsFinalMsg (msg)) {
 		VLOG(2) << "Stream closed for \"" << stream->item_name << "\".";
 		if (!stream->is_closed) {
-			refresh_count_++;
+/* a final refresh is accounted below */
+			if (0 == stream->refresh_received && RSSL_MC_REFRESH != msg->msgBase.msgClass)
+				refresh_count_++;
 			stream->is_closed = true;
 		}
 	}
@@ -2044,6 +3006,8 @@ chainy::consumer_t::OnMarketPrice (
         case RSSL_MC_STATUS:
 		VLOG(1) << "Ignoring status";
 		stream->status_received++;
+		if (rsslIsFinalMsg (msg))
+			rc = delegate_->OnClose (stream);
 		break;
 
         case RSSL_MC_CLOSE:
@@ -2051,18 +3015,23 @@ chainy::consumer_t::OnMarketPrice (
         case RSSL_MC_GENERIC:
         default:
                 cumulative_stats_[CONSUMER_PC_RSSL_MSGS_REJECTED]++;
-                LOG(WARNING) << prefix_ << "Uncaught message: " << msg;
+                LOG(WARNING) << GetSession (handle)->prefix << "Uncaught message: " << msg;
                 return rc;
         }
 
 /* Refresh state check */
+	CheckSyncState();
+	return rc;
+}
+
+void
+chainy::consumer_t::CheckSyncState()
+{
 	if (!in_sync_ && refresh_count_ == directory_.size()) {
 		in_sync_ = true;
-		LOG(INFO) << "Service " << stream->service_name << " synchronized.";
+		LOG(INFO) << "Service " << service_name() << " synchronized.";
 		delegate_->OnSync();
 	}
-
-	return rc;
 }
 
 bool
@@ -2073,6 +3042,8 @@ chainy::consumer_t::OnMarketPriceRefresh (
 	std::shared_ptr<item_stream_t> stream
 	)
 {
+/* Payload size, reduced by any view of the request. */
+	cumulative_stats_[CONSUMER_PC_MMT_MARKET_PRICE_REFRESH_BYTES] += msg->msgBase.encDataBody.length;
 	return OnMarketPriceUpdate (handle, it, msg, stream);
 }
 
@@ -2083,6 +3054,88 @@ chainy::consumer_t::OnMarketPriceUpdate (
 	RsslMsg* msg,
 	std::shared_ptr<item_stream_t> stream
 	)
+{
+	DCHECK(nullptr != handle);
+	DCHECK(nullptr != it);
+	DCHECK(nullptr != msg);
+
+/* The delegate keeps the image, only the standby session is cached. */
+	if (!delegate_->OnWrite (stream, handle->majorVersion, handle->minorVersion, msg))
+		return false;
+	return true;
+}
+
+/* Warm standby: keep a last value cache of each item without notifying the
+ * delegate, the images are replayed on promotion.  Returns false to abort the
+ * standby connection.
+ */
+bool
+chainy::consumer_t::OnStandbyMarketPrice (
+	RsslChannel* handle,
+	RsslDecodeIterator* it,
+	RsslMsg* msg
+	)
+{
+	upstream_t* session = GetSession (handle);
+
+	DCHECK(nullptr != it);
+	DCHECK(nullptr != msg);
+	DCHECK(session->is_standby);
+
+	auto request = session->requests.find (msg->msgBase.streamId);
+	auto search = tokens_.find (msg->msgBase.streamId);
+	if (request == session->requests.end() || search == tokens_.end()) {
+		cumulative_stats_[CONSUMER_PC_STANDBY_MSGS_DISCARDED]++;
+		DVLOG(3) << session->prefix << "Discarding standby response on closed token " << msg->msgBase.streamId << ".";
+		return true;
+	}
+	auto stream = search->second.lock();
+	if (!(bool)stream) {
+		cumulative_stats_[CONSUMER_PC_STANDBY_MSGS_DISCARDED]++;
+		return true;
+	}
+
+/* Closure on the standby is left to the active session, the item is requested
+ * again with the next resubscription of the standby.
+ */
+	if (rsslIsFinalMsg (msg)) {
+		VLOG(2) << session->prefix << "Standby stream closed for \"" << stream->item_name << "\".";
+		if (request->second)
+			session->refresh_count--;
+		session->requests.erase (request);
+		return true;
+	}
+
+	switch (msg->msgBase.msgClass) {
+	case RSSL_MC_REFRESH:
+		if (!request->second) {
+			request->second = true;
+			session->refresh_count++;
+		}
+		break;
+	case RSSL_MC_UPDATE:
+/* an update ahead of the first image would leave a partial cache entry */
+		if (!request->second) {
+			cumulative_stats_[CONSUMER_PC_STANDBY_MSGS_DISCARDED]++;
+			return true;
+		}
+		break;
+	default:
+		return true;
+	}
+	return ApplyToCache (handle, it, msg, stream->item_name, &stream->standby_entry_handle);
+}
+
+/* Apply a refresh or update to a last value cache entry, created on demand.
+ */
+bool
+chainy::consumer_t::ApplyToCache (
+	RsslChannel* handle,
+	RsslDecodeIterator* it,
+	RsslMsg* msg,
+	const std::string& item_name,
+	RsslPayloadEntryHandle* entry
+	)
 {
 	RsslCacheError rssl_cache_err;
 	RsslRet rc;
@@ -2090,16 +3143,17 @@ chainy::consumer_t::OnMarketPriceUpdate (
 	DCHECK(nullptr != handle);
 	DCHECK(nullptr != it);
 	DCHECK(nullptr != msg);
+	DCHECK(nullptr != entry);
 	DCHECK(nullptr != cache_handle_);
 
 	rsslCacheErrorClear (&rssl_cache_err);
 
 /* lazy cache creation */
-	if (nullptr == stream->payload_entry_handle) {
-		DVLOG(3) << "Creating payload entry for \"" << stream->item_name << "\"";
-		stream->payload_entry_handle = rsslPayloadEntryCreate (cache_handle_, &rssl_cache_err);
-		if (nullptr == stream->payload_entry_handle) {
-			LOG(ERROR) << prefix_ << "rsslPayloadEntryCreate: { "
+	if (nullptr == *entry) {
+		DVLOG(3) << "Creating payload entry for \"" << item_name << "\"";
+		*entry = rsslPayloadEntryCreate (cache_handle_, &rssl_cache_err);
+		if (nullptr == *entry) {
+			LOG(ERROR) << GetSession (handle)->prefix << "rsslPayloadEntryCreate: { "
 				  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
 				", \"text\": \"" << rssl_cache_err.text << "\""
 				" }";
@@ -2110,26 +3164,97 @@ chainy::consumer_t::OnMarketPriceUpdate (
 	rc = rsslSetDecodeIteratorBuffer (it, &msg->msgBase.encDataBody);
 	if (RSSL_RET_SUCCESS != rc) {
 /* Invalid buffer or internal error, discard the message. */
-		LOG(ERROR) << prefix_ << "rsslSetDecodeIteratorBuffer: { "
+		LOG(ERROR) << GetSession (handle)->prefix << "rsslSetDecodeIteratorBuffer: { "
 			  "\"returnCode\": " << static_cast<signed> (rc) << ""
 			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
 			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
 			" }";
 		return false;
 	}
-	DVLOG(3) << "Applying payload update for \"" << stream->item_name << "\"";
-	rc = rsslPayloadEntryApply (stream->payload_entry_handle, it, msg, &rssl_cache_err);
+	DVLOG(3) << "Applying payload update for \"" << item_name << "\"";
+	rc = rsslPayloadEntryApply (*entry, it, msg, &rssl_cache_err);
 	if (RSSL_RET_SUCCESS != rc) {
-		LOG(WARNING) << prefix_ << "rsslPayloadEntryApply: { "
+		LOG(WARNING) << GetSession (handle)->prefix << "rsslPayloadEntryApply: { "
 				  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
 				", \"text\": \"" << rssl_cache_err.text << "\""
 				" }";
 		return false;
 	}
+	return true;
+}
 
-	if (!delegate_->OnWrite (stream, handle->majorVersion, handle->minorVersion, msg))
+/* Present the cached image of an item to the delegate as a refresh.  Returns
+ * false to abort the connection.
+ */
+bool
+chainy::consumer_t::ReplayImage (
+	RsslChannel* c,
+	std::shared_ptr<item_stream_t> item_stream
+	)
+{
+#ifndef NDEBUG
+	RsslRefreshMsg refresh = RSSL_INIT_REFRESH_MSG;
+	RsslEncodeIterator it = RSSL_INIT_ENCODE_ITERATOR;
+#else
+	RsslRefreshMsg refresh;
+	RsslEncodeIterator it;
+	rsslClearRefreshMsg (&refresh);
+	rsslClearEncodeIterator (&it);
+#endif
+	char buffer[8192];
+	RsslBuffer data_buffer = { static_cast<uint32_t> (sizeof (buffer)), buffer };
+	RsslCacheError rssl_cache_err;
+	RsslRet rc;
+
+	DCHECK (nullptr != c);
+	DCHECK (nullptr != item_stream->standby_entry_handle);
+
+	rsslCacheErrorClear (&rssl_cache_err);
+
+	rc = rsslSetEncodeIteratorBuffer (&it, &data_buffer);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorBuffer: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			" }";
 		return false;
-	return true;
+	}
+	rc = rsslSetEncodeIteratorRWFVersion (&it, c->majorVersion, c->minorVersion);
+	if (RSSL_RET_SUCCESS != rc) {
+		LOG(ERROR) << GetSession (c)->prefix << "rsslSetEncodeIteratorRWFVersion: { "
+			  "\"returnCode\": " << static_cast<signed> (rc) << ""
+			", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+			", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+			", \"majorVersion\": " << static_cast<unsigned> (c->majorVersion) << ""
+			", \"minorVersion\": " << static_cast<unsigned> (c->minorVersion) << ""
+			" }";
+		return false;
+	}
+/* Single part retrieval, link records are well within the buffer. */
+	rc = rsslPayloadEntryRetrieve (item_stream->standby_entry_handle, &it, nullptr /* cursor */, &rssl_cache_err);
+	if (RSSL_RET_SUCCESS != rc) {
+/* The next refresh or update of the item carries on from the active session. */
+		LOG(WARNING) << GetSession (c)->prefix << "rsslPayloadEntryRetrieve: { "
+			  "\"rsslErrorId\": " << rssl_cache_err.rsslErrorId << ""
+			", \"text\": \"" << rssl_cache_err.text << "\""
+			", \"itemName\": \"" << item_stream->item_name << "\""
+			" }";
+		return true;
+	}
+
+	refresh.msgBase.domainType = RSSL_DMT_MARKET_PRICE;
+	refresh.msgBase.msgClass = RSSL_MC_REFRESH;
+	refresh.msgBase.streamId = item_stream->token;
+	refresh.msgBase.containerType = rsslPayloadEntryGetDataType (item_stream->standby_entry_handle);
+	refresh.msgBase.encDataBody.data = buffer;
+	refresh.msgBase.encDataBody.length = rsslGetEncodedBufferLength (&it);
+	refresh.flags = RSSL_RFMF_SOLICITED | RSSL_RFMF_REFRESH_COMPLETE | RSSL_RFMF_CLEAR_CACHE;
+	refresh.state.streamState = RSSL_STREAM_OPEN;
+	refresh.state.dataState = RSSL_DATA_OK;
+
+	DVLOG(3) << "Replaying standby image for \"" << item_stream->item_name << "\"";
+	return delegate_->OnWrite (item_stream, c->majorVersion, c->minorVersion, reinterpret_cast<RsslMsg*> (&refresh));
 }
 
 int
@@ -2149,7 +3274,7 @@ chainy::consumer_t::Submit (
 	rsslClearWriteInArgs (&in_args);
 	in_args.rsslPriority = RSSL_LOW_PRIORITY;	/* flushing priority */
 /* direct write on clear socket, enqueue when writes are pending */
-	const bool should_write_direct = !FD_ISSET (c->socketId, &in_wfds_);
+	const bool should_write_direct = !selector_.IsSet (c->socketId, selector_t::kWritable);
 	in_args.writeInFlags = should_write_direct ? RSSL_WRITE_DIRECT_SOCKET_WRITE : 0;
 
 try_again:
@@ -2179,7 +3304,7 @@ try_again:
 			" }";
 	}
 	if (rc > 0) {
-		IncrementPendingCount();
+		GetSession (c)->pending_count++;
 		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_ENQUEUED]++;
 		goto pending;
 	}
@@ -2192,12 +3317,12 @@ try_again:
 	case RSSL_RET_BUFFER_NO_BUFFERS:		/* empty buffer pool: spin wait until buffer is available. */
 		cumulative_stats_[CONSUMER_PC_RSSL_WRITE_NO_BUFFERS]++;
 pending:
-		FD_SET (c->socketId, &in_wfds_);	/* pending output */
+		selector_.Set (c->socketId, selector_t::kWritable);	/* pending output */
 		return -1;
 	case RSSL_RET_SUCCESS:				/* sent, no flush required. */
 		cumulative_stats_[CONSUMER_PC_RSSL_MSGS_SENT]++;
 /* Sent data equivalent to a ping. */
-		SetNextPing (last_activity_ + boost::posix_time::seconds (ping_interval_));
+		GetSession (c)->next_ping = last_activity_ + SecondsToTicks (GetSession (c)->ping_interval);
 		return 1;
 	default:
 		cumulative_stats_[CONSUMER_PC_RSSL_WRITE_EXCEPTION]++;
@@ -2254,7 +3379,7 @@ pending:
  * automatically.  If this fails then either the client has stalled or the systems is out of 
  * resources.  Suitable consequence is to force a disconnect.
  */
-		FD_SET (c->socketId, &out_efds_);
+		selector_.SetReady (c->socketId, selector_t::kException);
 		LOG(INFO) << "rsslPing: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
@@ -2264,7 +3389,7 @@ pending:
 	case RSSL_RET_SUCCESS:				/* sent, no flush required. */
 		cumulative_stats_[CONSUMER_PC_RSSL_PING_SENT]++;
 /* Advance ping expiration only on success. */
-		SetNextPing (last_activity_ + boost::posix_time::seconds (ping_interval_));
+		GetSession (c)->next_ping = last_activity_ + SecondsToTicks (GetSession (c)->ping_interval);
 		return 1;
 	default:
 		cumulative_stats_[CONSUMER_PC_RSSL_PING_EXCEPTION]++;
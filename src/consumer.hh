@@ -4,14 +4,13 @@
 #ifndef CONSUMER_HH_
 #define CONSUMER_HH_
 
-#include <winsock2.h>
-
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <boost/unordered_map.hpp>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 /* Boost Atomics */
 #include <boost/atomic.hpp>
@@ -37,8 +36,11 @@
 #include "client.hh"
 #include "config.hh"
 #include "deleter.hh"
+#include "dictionary_cache.hh"
 #include "chainy_http_server.hh"
 #include "message_loop.hh"
+#include "monotonic_clock.hh"
+#include "selector.hh"
 
 namespace chainy
 {
@@ -73,6 +75,8 @@ namespace chainy
 		CONSUMER_PC_RSSL_SLOW_READER,
 		CONSUMER_PC_RSSL_PACKET_GAP_DETECTED,
 		CONSUMER_PC_RSSL_READ_FAILURE,
+		CONSUMER_PC_RSSL_READ_BATCHES,
+		CONSUMER_PC_RSSL_READ_BUDGET_EXHAUSTED,
 		CONSUMER_PC_CLIENT_INIT_EXCEPTION,
 		CONSUMER_PC_DIRECTORY_MAP_EXCEPTION,
 		CONSUMER_PC_RSSL_PING_EXCEPTION,
@@ -102,11 +106,25 @@ namespace chainy
                 CONSUMER_PC_MMT_DICTIONARY_RECEIVED,
                 CONSUMER_PC_MMT_DICTIONARY_EXCEPTION,
                 CONSUMER_PC_MMT_DICTIONARY_SENT,
+		CONSUMER_PC_DICTIONARY_CACHE_HIT,
+		CONSUMER_PC_DICTIONARY_CACHE_MISS,
                 CONSUMER_PC_MMT_MARKET_PRICE_RECEIVED,
                 CONSUMER_PC_MMT_MARKET_PRICE_VALIDATED,
                 CONSUMER_PC_MMT_MARKET_PRICE_MALFORMED,
                 CONSUMER_PC_MMT_MARKET_PRICE_EXCEPTION,
                 CONSUMER_PC_MMT_MARKET_PRICE_SENT,
+                CONSUMER_PC_MMT_MARKET_PRICE_CLOSE_SENT,
+                CONSUMER_PC_MMT_MARKET_PRICE_CLOSE_EXCEPTION,
+		CONSUMER_PC_MMT_MARKET_PRICE_BATCH_SENT,
+		CONSUMER_PC_MMT_MARKET_PRICE_BATCH_EXCEPTION,
+		CONSUMER_PC_MMT_MARKET_PRICE_VIEW_REQUESTED,
+		CONSUMER_PC_MMT_MARKET_PRICE_REFRESH_BYTES,
+                CONSUMER_PC_ITEM_STREAM_CLOSED,
+		CONSUMER_PC_STANDBY_BYTES_RECEIVED,
+		CONSUMER_PC_STANDBY_MSGS_RECEIVED,
+		CONSUMER_PC_STANDBY_MSGS_DISCARDED,
+		CONSUMER_PC_STANDBY_PROMOTED,
+		CONSUMER_PC_SERVER_FAILOVER,
 /* marker */
 		CONSUMER_PC_MAX
 	};
@@ -116,13 +134,18 @@ namespace chainy
 	public:
 		explicit item_stream_t()
 			: token (-1),
-			  payload_entry_handle (nullptr),
+			  batch_token (-1),
+			  standby_entry_handle (nullptr),
+			  last_activity (TicksToSeconds (MonotonicTicks())),
+			  last_refresh (0),
+			  last_status (0),
+			  last_update (0),
 			  msg_count (0),
-			  last_activity (boost::posix_time::second_clock::universal_time()),
 			  refresh_received (0),
 			  status_received (0),
 			  update_received (0),
-			  is_closed (false)
+			  is_closed (false),
+			  is_listed (false)
 		{
 		}
 
@@ -132,23 +155,79 @@ namespace chainy
 /* Service origin, e.g. IDN_RDF */
 		std::string service_name;
 
-/* Subscription handle which is valid from login success to login close. */
+/* Stream id on every upstream session, valid whilst on the watchlist. */
 		int32_t token;
+/* Stream id of the batch request the token follows, -1 if requested alone. */
+		int32_t batch_token;
 
-/* Last value cache, created on-demand. */
-		RsslPayloadEntryHandle payload_entry_handle;
+/* Last value cache of the warm standby session, replayed on promotion.  The
+ * delegate holds its own image of the active session.
+ */
+		RsslPayloadEntryHandle standby_entry_handle;
 
-/* Performance counters */
-		boost::posix_time::ptime last_activity;
-		boost::posix_time::ptime last_refresh;
-		boost::posix_time::ptime last_status;
-		boost::posix_time::ptime last_update;
+/* Performance counters, seconds of the monotonic clock. */
+		uint32_t last_activity;
+		uint32_t last_refresh;
+		uint32_t last_status;
+		uint32_t last_update;
 		uint32_t msg_count;		/* including unknown message types */
 		uint32_t refresh_received;
 		uint32_t status_received;
 		uint32_t update_received;
 
 		bool is_closed;
+/* Position on the watchlist for removal in constant time. */
+		bool is_listed;
+		std::list<std::weak_ptr<item_stream_t>>::iterator directory_entry;
+	};
+
+/* RSSL session with one upstream server.  The active session feeds the
+ * delegate, a warm standby holds the same watchlist open on the next server
+ * of the list and is promoted without resubscription when the active fails.
+ */
+	struct upstream_t
+	{
+		explicit upstream_t()
+			: channel (nullptr),
+			  server (0),
+			  is_standby (false),
+			  is_muted (true),
+			  has_directory (false),
+			  supports_batch (false),
+			  supports_view (false),
+			  next_ping (0),
+			  next_pong (0),
+			  ping_interval (0),
+			  pending_count (0),
+			  refresh_count (0)
+		{
+		}
+
+		RsslChannel* channel;
+/* Index into the configured server list. */
+		size_t server;
+		bool is_standby;
+/* flag that is false until permission is granted to submit data. */
+		bool is_muted;
+/* Directory refresh received, items may be requested once the dictionary is loaded. */
+		bool has_directory;
+/* Login refresh advertised support for batch requests. */
+		bool supports_batch;
+/* Login refresh advertised support for view requests. */
+		bool supports_view;
+		std::string component_text;	/* API or TREP component name and version */
+		std::string app_text;		/* App name */
+/* unique id per connection. */
+		std::string prefix;
+/* RSSL keepalive state. */
+		ticks_t next_ping;
+		ticks_t next_pong;
+		unsigned ping_interval;
+/* Pending messages to flush. */
+		unsigned pending_count;
+/* Item streams open on this channel by token, true once refreshed. */
+		boost::unordered_map<int32_t, bool> requests;
+		unsigned refresh_count;
 	};
 
 	class consumer_t
@@ -164,8 +243,13 @@ namespace chainy
                     Delegate() {}
                 
                     virtual bool OnSync() = 0;
-		    virtual bool OnTrigger() = 0;
                     virtual bool OnWrite (std::shared_ptr<item_stream_t> item_stream, const uint8_t rwf_major_version, const uint8_t rwf_minor_version, RsslMsg* msg) = 0;
+/* Field dictionary received or replaced, before any item stream is requested. */
+                    virtual bool OnDictionary (const RsslDataDictionary& dictionary) = 0;
+/* Item stream closed by the upstream provider, e.g. not found. */
+                    virtual bool OnClose (std::shared_ptr<item_stream_t> item_stream) = 0;
+/* Message pump idle before waiting on the sockets. */
+                    virtual void OnIdle() = 0;
                 
                 protected:
                     virtual ~Delegate() {}
@@ -185,7 +269,14 @@ namespace chainy
 		void OnWakeup();
 
 		bool CreateItemStream (const char* name, std::shared_ptr<item_stream_t> item_stream);
+		bool CloseItemStream (std::shared_ptr<item_stream_t> item_stream);
 		bool Resubscribe (RsslChannel* handle);
+/* Field id view of item requests, empty for full records.  Items already open
+ * retain their view.
+ */
+		void SetView (const std::vector<RsslFieldId>& fids) {
+			view_ = fids;
+		}
 
 // ConsumerDelegate methods:
 		virtual void CreateInfo(ConsumerInfo* info) override;
@@ -205,8 +296,14 @@ namespace chainy
 
 	private:
 		bool DoInternalWork();
+		void FlushItemRequests();
 
-		void Connect();
+		void Connect (upstream_t* session);
+		void OnSessionLost (upstream_t* session);
+		void RotateServer (upstream_t* session);
+		void Promote();
+		bool ReplayImage (RsslChannel* c, std::shared_ptr<item_stream_t> item_stream);
+		void CheckKeepalive (upstream_t* session);
 
 		void OnCanReadWithoutBlocking (RsslChannel* handle);
 		void OnCanWriteWithoutBlocking (RsslChannel* handle);
@@ -217,6 +314,7 @@ namespace chainy
 		bool OnActiveSession (RsslChannel* handle);
 
 		void OnActiveReadState (RsslChannel* handle);
+		RsslRet OnRead (RsslChannel* handle);
 		void OnActiveWriteState (RsslChannel* handle);
 		void OnMsg (RsslChannel* handle, RsslBuffer* buf);
 		bool OnMsg (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg);
@@ -228,15 +326,23 @@ namespace chainy
 		bool OnDirectoryRefresh (RsslChannel* c, const RsslRDMDirectoryRefresh& response);
 		bool OnDirectoryUpdate (RsslChannel* c, const RsslRDMDirectoryUpdate& response);
 		bool OnDictionary (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg);
-		bool OnDictionaryRefresh (RsslChannel* c, RsslDecodeIterator* it, const RsslRDMDictionaryRefresh& response);
+		bool OnDictionaryRefresh (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg, const RsslRDMDictionaryRefresh& response);
+		bool OnDictionaryComplete (RsslChannel* c);
 		bool OnMarketPrice (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg);
 		bool OnMarketPriceRefresh (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg, std::shared_ptr<item_stream_t> stream);
 		bool OnMarketPriceUpdate (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg, std::shared_ptr<item_stream_t> stream);
+		bool OnStandbyMarketPrice (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg);
+		bool ApplyToCache (RsslChannel* c, RsslDecodeIterator* it, RsslMsg* msg, const std::string& item_name, RsslPayloadEntryHandle* entry);
 
 		bool SendLoginRequest (RsslChannel* c);
 		bool SendDirectoryRequest (RsslChannel* c);
-		bool SendDictionaryRequest (RsslChannel* c, const uint16_t service_id, const std::string& dictionary_name);
+		bool SendDictionaryRequest (RsslChannel* c, const uint16_t service_id, const std::string& dictionary_name, const uint32_t verbosity);
 		bool SendItemRequest (RsslChannel* c, std::shared_ptr<item_stream_t> item_stream);
+		bool SendItemRequests (RsslChannel* c, const std::vector<std::shared_ptr<item_stream_t>>& items);
+		bool SendBatchRequest (RsslChannel* c, int32_t batch_token, const std::vector<std::shared_ptr<item_stream_t>>& items);
+		bool EncodeView (RsslChannel* c, RsslEncodeIterator* it);
+		bool SendItemClose (RsslChannel* c, std::shared_ptr<item_stream_t> item_stream);
+		void CheckSyncState();
 
 		int Submit (RsslChannel* c, RsslBuffer* buf);
 		int Ping (RsslChannel* c);
@@ -244,27 +350,9 @@ namespace chainy
 		void SetServiceId (uint16_t service_id) {
 			service_id_.store (service_id);
 		}
-                const boost::posix_time::ptime& NextPing() const {
-                        return next_ping_;
-                }
-                const boost::posix_time::ptime& NextPong() const {
-                        return next_pong_;
-                }
-                void SetNextPing (const boost::posix_time::ptime& time_) {
-                        next_ping_ = time_;
-                }
-                void SetNextPong (const boost::posix_time::ptime& time_) {
-                        next_pong_ = time_;
-                }
-                void IncrementPendingCount() {
-                        pending_count_++;
-                }
-                void ClearPendingCount() {
-                        pending_count_ = 0;
-                }
-                unsigned GetPendingCount() const {
-                        return pending_count_;
-                }
+		static upstream_t* GetSession (const RsslChannel* c) {
+			return static_cast<upstream_t*> (c->userSpecPtr);
+		}
 
 		const config_t& config_;
 
@@ -273,10 +361,9 @@ namespace chainy
 /* This flag is set to false when Run should return. */
 		boost::atomic_bool keep_running_;
 
-		int in_nfds_, out_nfds_;
-		fd_set in_rfds_, in_wfds_, in_efds_;
-		fd_set out_rfds_, out_wfds_, out_efds_;
-		struct timeval in_tv_, out_tv_;
+		selector_t selector_;
+		int out_nfds_;
+		struct timeval in_tv_;
 
 // The time at which we should call DoDelayedWork.
 		std::chrono::steady_clock::time_point delayed_work_time_;
@@ -286,44 +373,41 @@ namespace chainy
 // ... read end; OnWakeup reads it and then breaks Run() out of its sleep
 		net::SocketDescriptor wakeup_pipe_out_;
 
-/* UPA client connection */
-		RsslChannel* connection_;
-		std::string component_text_;	/* API or TREP component name and version */
-		std::string app_text_;		/* App name */
-/* unique id per connection. */
-		std::string prefix_;
-/* flag that is false until permission is granted to submit data. */
-                bool is_muted_;
-
+/* UPA upstream sessions, the second is used only as a warm standby. */
+		upstream_t sessions_[2];
+		upstream_t* active_;
+		upstream_t* standby_;
+
 /* Directory mapped ServiceID */
 		boost::atomic_uint16_t service_id_;
-/* Pending messages to flush. */
-                unsigned pending_count_;
 /* Field dictionary for caching */
 		RsslDataDictionary rdm_dictionary_;
+/* Field dictionary retained between restarts, validated by version. */
+		std::unique_ptr<dictionary_cache_t> dictionary_cache_;
+		std::string dictionary_version_;
+/* Verbosity and service of the dictionary request in flight. */
+		uint32_t dictionary_verbosity_;
+		uint16_t dictionary_service_id_;
+/* Fields of interest to the delegate in ascending order. */
+		std::vector<RsslFieldId> view_;
 /* Watchlist of all items. */
                 std::list<std::weak_ptr<item_stream_t>> directory_;
 		boost::unordered_map<int32_t, std::weak_ptr<item_stream_t>> tokens_;
+/* Item streams created since the last pass, requested together. */
+		std::vector<std::weak_ptr<item_stream_t>> pending_;
 /* Last value cache. */
 		RsslPayloadCacheHandle cache_handle_;
 /* Response monitoring for tokens. */
 		unsigned refresh_count_;
 		bool in_sync_;
-		bool pending_trigger_;
 		Delegate* delegate_;
-/* Item requests may appear before login success has been granted.  */
-                bool is_logged_in_;
-		int32_t token_;		/* incrementing unique id for streams */
+		int32_t token_;		/* incrementing unique id for streams across sessions */
                 int32_t directory_token_;
                 int32_t dictionary_token_;
                 int32_t login_token_;	/* should always be 1 */
-/* RSSL keepalive state. */
-                boost::posix_time::ptime next_ping_;
-                boost::posix_time::ptime next_pong_;
-                unsigned ping_interval_;
 
 /** Performance Counters **/
-		boost::posix_time::ptime creation_time_, last_activity_;
+		ticks_t creation_time_, last_activity_;
 		uint32_t cumulative_stats_[CONSUMER_PC_MAX];
 		uint32_t snap_stats_[CONSUMER_PC_MAX];
 
@@ -0,0 +1,188 @@
+/* On-disk cache of the encoded RDM field dictionary.
+ */
+
+#include "dictionary_cache.hh"
+
+#include <cstring>
+
+#include "chromium/logging.hh"
+
+namespace {
+
+/* Format 1 follows the header with the version string then every refresh part
+ * as a 32-bit length and the encoded series, decoded with the header RWF version.
+ */
+static const chainy::file_prefix_t kPrefix = { { 'C', 'H', 'A', 'I', 'N', 'Y', 'F', 'D' }, 1 };
+
+}  // namespace anon
+
+chainy::dictionary_cache_t::dictionary_cache_t (
+	const std::string& path
+	)
+	: path_ (path)
+	, rwf_major_version_ (0)
+	, rwf_minor_version_ (0)
+{
+	memset (&header_, 0, sizeof (header_));
+}
+
+/* A cache without a version or parts, or with parts not exactly filling the
+ * file, would fail to decode and is discarded for a fresh retrieval upstream.
+ */
+bool
+chainy::dictionary_cache_t::Open()
+{
+	const uint8_t* version;
+
+	Close();
+	if (!file_.Open (path_))
+		return false;
+	if (!file_.ReadHeader (kPrefix, &header_, sizeof (header_)))
+		goto invalid;
+	{
+		file_reader_t reader (file_.data() + sizeof (header_), file_.size() - sizeof (header_));
+		if (0 == header_.version_length
+			|| !reader.ReadBytes (header_.version_length, &version))
+		{
+			goto invalid;
+		}
+		version_.assign (reinterpret_cast<const char*> (version), header_.version_length);
+		for (uint32_t i = 0; i < header_.part_count; ++i) {
+			uint32_t length;
+			const uint8_t* part;
+			if (!reader.ReadValue (&length)
+				|| !reader.ReadBytes (length, &part))
+			{
+				goto invalid;
+			}
+			parts_.emplace_back (part, length);
+		}
+		if (parts_.empty() || 0 != reader.remaining())
+			goto invalid;
+	}
+	return true;
+invalid:
+	LOG(WARNING) << "Ignoring invalid field dictionary cache \"" << path_ << "\".";
+	Close();
+	return false;
+}
+
+void
+chainy::dictionary_cache_t::Close()
+{
+	parts_.clear();
+	version_.clear();
+	file_.Close();
+}
+
+bool
+chainy::dictionary_cache_t::Decode (
+	RsslDataDictionary* dictionary
+	)
+{
+	char buffer[1024];
+	RsslBuffer error_text = { static_cast<uint32_t> (sizeof (buffer)), buffer };
+	RsslRet rc;
+
+	DCHECK (is_open());
+	for (const auto& part : parts_) {
+#ifndef NDEBUG
+		RsslDecodeIterator it = RSSL_INIT_DECODE_ITERATOR;
+#else
+		RsslDecodeIterator it;
+		rsslClearDecodeIterator (&it);
+#endif
+		RsslBuffer data_buffer = { part.second, const_cast<char*> (reinterpret_cast<const char*> (part.first)) };
+		rc = rsslSetDecodeIteratorBuffer (&it, &data_buffer);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << "rsslSetDecodeIteratorBuffer: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				" }";
+			return false;
+		}
+		rc = rsslSetDecodeIteratorRWFVersion (&it, header_.rwf_major_version, header_.rwf_minor_version);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << "rsslSetDecodeIteratorRWFVersion: { "
+				  "\"returnCode\": " << static_cast<signed> (rc) << ""
+				", \"enumeration\": \"" << rsslRetCodeToString (rc) << "\""
+				", \"text\": \"" << rsslRetCodeInfo (rc) << "\""
+				", \"majorVersion\": " << static_cast<unsigned> (header_.rwf_major_version) << ""
+				", \"minorVersion\": " << static_cast<unsigned> (header_.rwf_minor_version) << ""
+				" }";
+			return false;
+		}
+		rc = rsslDecodeFieldDictionary (&it, dictionary, RDM_DICTIONARY_MINIMAL, &error_text);
+		if (RSSL_RET_SUCCESS != rc) {
+			LOG(ERROR) << "rsslDecodeFieldDictionary: { "
+				  "\"text\": \"" << std::string (error_text.data, error_text.length) << "\""
+				", \"path\": \"" << path_ << "\""
+				" }";
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+chainy::dictionary_cache_t::Clear()
+{
+	captured_.clear();
+}
+
+void
+chainy::dictionary_cache_t::Append (
+	uint8_t rwf_major_version,
+	uint8_t rwf_minor_version,
+	const RsslBuffer& part
+	)
+{
+	rwf_major_version_ = rwf_major_version;
+	rwf_minor_version_ = rwf_minor_version;
+	captured_.emplace_back (part.data, part.data + part.length);
+}
+
+/* Consumers of other shards may commit the same dictionary concurrently, each
+ * writes its own temporary file.
+ */
+bool
+chainy::dictionary_cache_t::Commit (
+	const std::string& version
+	)
+{
+	header_t header;
+	std::vector<uint32_t> lengths;
+	std::vector<chromium::StringPiece> pieces;
+
+	if (captured_.empty() || version.empty() || version.size() > UINT16_MAX) {
+		captured_.clear();
+		return false;
+	}
+	memset (&header, 0, sizeof (header));
+	header.prefix = kPrefix;
+	header.rwf_major_version = rwf_major_version_;
+	header.rwf_minor_version = rwf_minor_version_;
+	header.version_length = static_cast<uint16_t> (version.size());
+	header.part_count = static_cast<uint32_t> (captured_.size());
+
+/* lengths are referenced in place and must not reallocate */
+	lengths.reserve (captured_.size());
+	pieces.push_back (chromium::StringPiece (reinterpret_cast<const char*> (&header), sizeof (header)));
+	pieces.push_back (version);
+	for (const auto& part : captured_) {
+		lengths.push_back (static_cast<uint32_t> (part.size()));
+		pieces.push_back (chromium::StringPiece (reinterpret_cast<const char*> (&lengths.back()), sizeof (uint32_t)));
+		pieces.push_back (chromium::StringPiece (part.data(), part.size()));
+	}
+	const bool is_written = CommitFile (path_, pieces);
+	captured_.clear();
+	if (!is_written) {
+		LOG(WARNING) << "Cannot write field dictionary cache \"" << path_ << "\".";
+		return false;
+	}
+	LOG(INFO) << "Field dictionary version \"" << version << "\" written to \"" << path_ << "\".";
+	return true;
+}
+
+/* eof */
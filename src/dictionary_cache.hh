@@ -0,0 +1,80 @@
+/* On-disk cache of the encoded RDM field dictionary.
+ *
+ * The minimal field dictionary is kept as retrieved, one encoded series per
+ * refresh part, and decoded locally on load.  The file starts with a header of
+ * the dictionary version and RWF version of the parts, each part follows as a
+ * length and payload in host byte order.  A retrieval is captured then written
+ * to a temporary file and renamed over the cache, any mapping of the previous
+ * file remains valid.
+ */
+
+#ifndef DICTIONARY_CACHE_HH_
+#define DICTIONARY_CACHE_HH_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+/* UPA 7.4 */
+#include <upa/upa.h>
+
+#include "mapped_file.hh"
+
+namespace chainy
+{
+
+	class dictionary_cache_t :
+		boost::noncopyable
+	{
+	public:
+		explicit dictionary_cache_t (const std::string& path);
+
+/* Map and validate the cache file, returns false if absent or invalid. */
+		bool Open();
+		void Close();
+		bool is_open() const {
+			return file_.is_open();
+		}
+/* Dictionary version of the open cache file. */
+		const std::string& version() const {
+			return version_;
+		}
+/* Decode every cached part into a cleared dictionary. */
+		bool Decode (RsslDataDictionary* dictionary);
+
+/* Capture of a dictionary retrieval in progress. */
+		void Clear();
+		void Append (uint8_t rwf_major_version, uint8_t rwf_minor_version, const RsslBuffer& part);
+/* Replace the cache file with the captured parts, the capture is cleared. */
+		bool Commit (const std::string& version);
+
+	private:
+		struct header_t {
+			file_prefix_t prefix;
+			uint8_t rwf_major_version;
+			uint8_t rwf_minor_version;
+			uint16_t version_length;
+			uint32_t part_count;
+		};
+
+		const std::string path_;
+		mapped_file_t file_;
+		header_t header_;
+		std::string version_;
+/* Parts of the mapped file. */
+		std::vector<std::pair<const uint8_t*, uint32_t>> parts_;
+/* Captured parts with their RWF version, one version per retrieval. */
+		uint8_t rwf_major_version_;
+		uint8_t rwf_minor_version_;
+		std::vector<std::vector<char>> captured_;
+	};
+
+} /* namespace chainy */
+
+#endif /* DICTIONARY_CACHE_HH_ */
+
+/* eof */
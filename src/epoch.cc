@@ -0,0 +1,103 @@
+/* Epoch based reclamation of objects published between threads.
+ */
+
+#include "epoch.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+
+chainy::epoch_t::reader_t::reader_t (
+	epoch_t* domain
+	)
+	: domain_ (domain)
+	, epoch_ (kOffline)
+{
+	boost::lock_guard<boost::mutex> lock (domain_->readers_lock_);
+	domain_->readers_.push_back (this);
+}
+
+chainy::epoch_t::reader_t::~reader_t()
+{
+	boost::lock_guard<boost::mutex> lock (domain_->readers_lock_);
+	auto it = std::find (domain_->readers_.begin(), domain_->readers_.end(), this);
+	if (it != domain_->readers_.end())
+		domain_->readers_.erase (it);
+}
+
+/* Sequentially consistent announcement orders the store of the observed epoch
+ * before any subsequent load of a published pointer, pairing with the writer
+ * publishing before scanning reader epochs.
+ */
+chainy::epoch_t::guard_t::guard_t (
+	epoch_t& domain
+	)
+	: reader_ (domain.GetReader())
+{
+/* critical sections do not nest */
+	DCHECK (kOffline == reader_->epoch_.load (boost::memory_order_relaxed));
+	reader_->epoch_.store (domain.epoch_.load (boost::memory_order_seq_cst), boost::memory_order_seq_cst);
+}
+
+chainy::epoch_t::guard_t::~guard_t()
+{
+	reader_->epoch_.store (kOffline, boost::memory_order_release);
+}
+
+chainy::epoch_t::epoch_t()
+	: epoch_ (1)
+	, reclaimed_ (0)
+{
+}
+
+/* All reader threads are expected to have terminated. */
+chainy::epoch_t::~epoch_t()
+{
+	tls_reader_.reset();
+	LOG_IF(WARNING, !readers_.empty()) << readers_.size() << " epoch readers remain registered.";
+	for (auto& retired : limbo_)
+		retired.second();
+	limbo_.clear();
+}
+
+chainy::epoch_t::reader_t*
+chainy::epoch_t::GetReader()
+{
+	reader_t* reader = tls_reader_.get();
+	if (nullptr == reader) {
+		reader = new reader_t (this);
+		tls_reader_.reset (reader);
+	}
+	return reader;
+}
+
+void
+chainy::epoch_t::Retire (
+	const std::function<void()>& deleter
+	)
+{
+	limbo_.push_back (std::make_pair (epoch_.fetch_add (1, boost::memory_order_seq_cst), deleter));
+	Reclaim();
+}
+
+void
+chainy::epoch_t::Reclaim()
+{
+	if (limbo_.empty())
+		return;
+/* Oldest epoch any reader may still be within. */
+	uint64_t horizon = epoch_.load (boost::memory_order_seq_cst);
+	{
+		boost::lock_guard<boost::mutex> lock (readers_lock_);
+		for (auto reader : readers_)
+			horizon = std::min (horizon, reader->epoch_.load (boost::memory_order_seq_cst));
+	}
+	while (!limbo_.empty() && limbo_.front().first < horizon) {
+		limbo_.front().second();
+		limbo_.pop_front();
+		++reclaimed_;
+	}
+}
+
+/* eof */
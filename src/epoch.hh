@@ -0,0 +1,100 @@
+/* Epoch based reclamation of objects published between threads.
+ *
+ * A writer publishes a replacement through an atomic pointer and retires the
+ * previous object tagged with the current epoch, then advances the epoch.
+ * Readers enter a critical section by announcing the epoch observed before
+ * loading any published pointer and leave it by going offline.  A retired
+ * object is destroyed once every reader is offline or has announced a later
+ * epoch, readers never block or contend on a lock.
+ */
+
+#ifndef EPOCH_HH_
+#define EPOCH_HH_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/* Boost Atomics */
+#include <boost/atomic.hpp>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+namespace chainy
+{
+
+	class epoch_t :
+		boost::noncopyable
+	{
+	public:
+/* Per thread reader state, registered on first use by a thread. */
+		class reader_t :
+			boost::noncopyable
+		{
+		public:
+			explicit reader_t (epoch_t* domain);
+			~reader_t();
+
+		private:
+			epoch_t* domain_;
+/* Epoch observed on entry, kOffline outside of a critical section. */
+			boost::atomic<uint64_t> epoch_;
+
+			friend epoch_t;
+		};
+
+/* Scoped reader critical section, published pointers must only be loaded and
+ * dereferenced whilst a guard is held.
+ */
+		class guard_t :
+			boost::noncopyable
+		{
+		public:
+			explicit guard_t (epoch_t& domain);
+			~guard_t();
+
+		private:
+			reader_t* reader_;
+		};
+
+		epoch_t();
+		~epoch_t();
+
+/* Writer thread: defer deleter until no reader can hold the retired object. */
+		void Retire (const std::function<void()>& deleter);
+/* Writer thread: run deleters of objects no longer reachable by readers. */
+		void Reclaim();
+
+		size_t pending() const {
+			return limbo_.size();
+		}
+		uint64_t reclaimed() const {
+			return reclaimed_;
+		}
+
+	private:
+		static const uint64_t kOffline = UINT64_MAX;
+
+		reader_t* GetReader();
+
+		boost::atomic<uint64_t> epoch_;
+/* Registration only, never taken on the read path. */
+		boost::mutex readers_lock_;
+		std::vector<reader_t*> readers_;
+		boost::thread_specific_ptr<reader_t> tls_reader_;
+/* Retired deleters in epoch order. */
+		std::deque<std::pair<uint64_t, std::function<void()>>> limbo_;
+		uint64_t reclaimed_;
+	};
+
+} /* namespace chainy */
+
+#endif /* EPOCH_HH_ */
+
+/* eof */
@@ -0,0 +1,135 @@
+/* Single pass scanner of RWF encoded field lists.
+ */
+
+#include "field_scanner.hh"
+
+#include "chromium/logging.hh"
+
+namespace {
+
+/* Bounds checked reader of RWF primitives, big-endian as per the wire. */
+class reader_t
+{
+public:
+	reader_t (const char* data, size_t length)
+		: position_ (reinterpret_cast<const uint8_t*> (data))
+		, end_ (position_ + length)
+	{
+	}
+
+	size_t remaining() const {
+		return end_ - position_;
+	}
+	const char* position() const {
+		return reinterpret_cast<const char*> (position_);
+	}
+
+	bool GetU8 (uint8_t* value) {
+		if (remaining() < 1)
+			return false;
+		*value = *position_++;
+		return true;
+	}
+	bool GetU16 (uint16_t* value) {
+		if (remaining() < 2)
+			return false;
+		*value = static_cast<uint16_t> ((position_[0] << 8) | position_[1]);
+		position_ += 2;
+		return true;
+	}
+/* u15rb: one byte below 0x80, otherwise two bytes with the high bit masked. */
+	bool GetResBitU15 (uint16_t* value) {
+		uint8_t first;
+		if (!GetU8 (&first))
+			return false;
+		if (0 == (first & 0x80)) {
+			*value = first;
+			return true;
+		}
+		uint8_t second;
+		if (!GetU8 (&second))
+			return false;
+		*value = static_cast<uint16_t> (((first & 0x7f) << 8) | second);
+		return true;
+	}
+/* u16ob: one byte below 0xfe, otherwise 0xfe followed by two bytes. */
+	bool GetLength (uint16_t* length) {
+		uint8_t first;
+		if (!GetU8 (&first))
+			return false;
+		if (first < 0xfe) {
+			*length = first;
+			return true;
+		}
+		return GetU16 (length);
+	}
+	bool Skip (size_t length) {
+		if (remaining() < length)
+			return false;
+		position_ += length;
+		return true;
+	}
+
+private:
+	const uint8_t* position_;
+	const uint8_t* end_;
+};
+
+}  // namespace anon
+
+RsslRet
+chainy::ScanFieldList (
+	const RsslBuffer& encoded,
+	const field_bitmap_t& interest,
+	std::vector<scanned_field_t>* fields
+	)
+{
+	DCHECK(nullptr != fields);
+	reader_t reader (encoded.data, encoded.length);
+	uint8_t flags;
+	uint16_t value;
+
+/* empty body: no fields */
+	if (0 == encoded.length)
+		return RSSL_RET_SUCCESS;
+	if (!reader.GetU8 (&flags))
+		return RSSL_RET_INCOMPLETE_DATA;
+/* dictionary id and field list number are not used */
+	if (flags & RSSL_FLF_HAS_FIELD_LIST_INFO) {
+		uint8_t info_length;
+		if (!reader.GetU8 (&info_length) || !reader.Skip (info_length))
+			return RSSL_RET_INCOMPLETE_DATA;
+	}
+	if (flags & RSSL_FLF_HAS_SET_DATA) {
+		if ((flags & RSSL_FLF_HAS_SET_ID) && !reader.GetResBitU15 (&value))
+			return RSSL_RET_INCOMPLETE_DATA;
+/* set data without standard data runs to the end of the buffer */
+		if (0 == (flags & RSSL_FLF_HAS_STANDARD_DATA))
+			return RSSL_RET_SUCCESS;
+		if (!reader.GetLength (&value) || !reader.Skip (value))
+			return RSSL_RET_INCOMPLETE_DATA;
+	}
+	if (0 == (flags & RSSL_FLF_HAS_STANDARD_DATA))
+		return RSSL_RET_SUCCESS;
+	uint16_t count;
+	if (!reader.GetU16 (&count))
+		return RSSL_RET_INCOMPLETE_DATA;
+	while (count-- > 0) {
+		uint16_t fid, length;
+		if (!reader.GetU16 (&fid) || !reader.GetLength (&length))
+			return RSSL_RET_INCOMPLETE_DATA;
+		const char* data = reader.position();
+		if (!reader.Skip (length))
+			return RSSL_RET_INCOMPLETE_DATA;
+		if (!interest.test (static_cast<RsslFieldId> (fid)))
+			continue;
+		scanned_field_t field;
+		field.fid = static_cast<RsslFieldId> (fid);
+		field.data.data = const_cast<char*> (data);
+		field.data.length = length;
+		fields->push_back (field);
+	}
+	return RSSL_RET_SUCCESS;
+}
+
+/* eof */
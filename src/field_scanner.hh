@@ -0,0 +1,61 @@
+/* Single pass scanner of RWF encoded field lists.
+ *
+ * Walks the raw wire encoding of a field list and returns only the entries
+ * whose FID is set in a bitmap, every other entry is skipped by its length
+ * prefix without decoding.  Field data is returned as a view into the message
+ * buffer and is only valid for the lifetime of the message.
+ */
+
+#ifndef FIELD_SCANNER_HH_
+#define FIELD_SCANNER_HH_
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+/* UPA 8.0 */
+#include <upa/upa.h>
+
+namespace chainy
+{
+/* Set of FIDs, negative FIDs index above positive. */
+	class field_bitmap_t
+	{
+	public:
+		void set (RsslFieldId fid) {
+			bits_.set (static_cast<uint16_t> (fid));
+		}
+		bool test (RsslFieldId fid) const {
+			return bits_[static_cast<uint16_t> (fid)];
+		}
+		void reset() {
+			bits_.reset();
+		}
+		bool none() const {
+			return bits_.none();
+		}
+
+	private:
+		std::bitset<65536> bits_;
+	};
+
+	struct scanned_field_t
+	{
+		RsslFieldId fid;
+/* zero length for blank data */
+		RsslBuffer data;
+	};
+
+/* Append entries of interest in encoded order, set defined data is skipped as
+ * no set definitions are held.
+ *
+ * Returns RSSL_RET_SUCCESS, or RSSL_RET_INCOMPLETE_DATA on a truncated
+ * encoding.
+ */
+	RsslRet ScanFieldList (const RsslBuffer& encoded, const field_bitmap_t& interest, std::vector<scanned_field_t>* fields);
+
+} /* namespace chainy */
+
+#endif /* FIELD_SCANNER_HH_ */
+
+/* eof */
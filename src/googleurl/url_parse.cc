@@ -45,6 +45,8 @@
 
 namespace url {
 
+bool IsAuthorityTerminator(char ch);
+
 namespace {
 
 // Returns true if the given character is a valid digit to use in a port.
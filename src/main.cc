@@ -3,9 +3,13 @@
 
 #include "chainy.hh"
 
-#include <windows.h>
-#include <mmsystem.h>
-#pragma comment (lib, "winmm")
+#if defined(_WIN32)
+#	include <windows.h>
+#	include <mmsystem.h>
+#	pragma comment (lib, "winmm")
+#else
+#	include <signal.h>
+#endif
 
 #include "chromium/chromium_switches.hh"
 #include "chromium/command_line.hh"
@@ -65,6 +69,7 @@ protected:
 	}
 };
 
+#if defined(_WIN32)
 class timecaps_t
 {
 	UINT wTimerRes;
@@ -90,7 +95,8 @@ public:
 			timeEndPeriod (wTimerRes);
 	}
 };
-
+#endif
+
 } /* anonymous namespace */
 
 
@@ -106,7 +112,12 @@ main (
 #endif
 
 	env_t env (argc, argv);
+#if defined(_WIN32)
 	timecaps_t timecaps (1 /* ms */);
+#else
+/* Peer disconnects are reported through RSSL return codes. */
+	signal (SIGPIPE, SIG_IGN);
+#endif
 
 	auto app = std::make_shared<chainy::chainy_t>();
 	return app->Run();
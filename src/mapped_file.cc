@@ -0,0 +1,184 @@
+/* Read-only memory mapping of a whole file.
+ */
+
+#include "mapped_file.hh"
+
+#include <cstdio>
+#include <sstream>
+
+#if defined(_WIN32)
+#	include <io.h>
+#else
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+/* Boost Atomics */
+#include <boost/atomic.hpp>
+
+#include "chromium/files/file_util.hh"
+#include "chromium/logging.hh"
+
+namespace {
+
+/* Distinguishes concurrent writers of one process. */
+static boost::atomic<unsigned> g_commit_sequence (0);
+
+}  // namespace anon
+
+
+chainy::mapped_file_t::mapped_file_t()
+	: data_ (nullptr)
+	, size_ (0)
+#if defined(_WIN32)
+	, mapping_ (nullptr)
+#endif
+{
+}
+
+chainy::mapped_file_t::~mapped_file_t()
+{
+	Close();
+}
+
+/* The descriptor is not required once mapped.
+ */
+bool
+chainy::mapped_file_t::Open (
+	const std::string& path
+	)
+{
+	Close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA (path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx (file, &file_size) || 0 == file_size.QuadPart) {
+		CloseHandle (file);
+		return false;
+	}
+	mapping_ = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle (file);
+	if (nullptr == mapping_) {
+		LOG(WARNING) << "CreateFileMapping for \"" << path << "\" failed, error: " << GetLastError();
+		return false;
+	}
+	data_ = static_cast<const uint8_t*> (MapViewOfFile (mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (nullptr == data_) {
+		LOG(WARNING) << "MapViewOfFile for \"" << path << "\" failed, error: " << GetLastError();
+		CloseHandle (mapping_);
+		mapping_ = nullptr;
+		return false;
+	}
+	size_ = static_cast<size_t> (file_size.QuadPart);
+#else
+	const int fd = open (path.c_str(), O_RDONLY);
+	if (-1 == fd)
+		return false;
+	struct stat st;
+	if (-1 == fstat (fd, &st) || 0 == st.st_size) {
+		close (fd);
+		return false;
+	}
+	void* p = mmap (nullptr, static_cast<size_t> (st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (MAP_FAILED == p) {
+		LOG(WARNING) << "mmap for \"" << path << "\" failed, errno: " << errno;
+		return false;
+	}
+	data_ = static_cast<const uint8_t*> (p);
+	size_ = static_cast<size_t> (st.st_size);
+#endif
+	return true;
+}
+
+void
+chainy::mapped_file_t::Close()
+{
+	if (nullptr == data_)
+		return;
+#if defined(_WIN32)
+	UnmapViewOfFile (data_);
+	CloseHandle (mapping_);
+	mapping_ = nullptr;
+#else
+	munmap (const_cast<uint8_t*> (data_), size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+bool
+chainy::mapped_file_t::ReadHeader (
+	const file_prefix_t& prefix,
+	void* header,
+	size_t header_size
+	) const
+{
+	file_prefix_t file_prefix;
+
+	DCHECK_GE (header_size, sizeof (file_prefix));
+	if (size_ < header_size)
+		return false;
+	memcpy (&file_prefix, data_, sizeof (file_prefix));
+	if (0 != memcmp (file_prefix.magic, prefix.magic, sizeof (prefix.magic))
+		|| prefix.format != file_prefix.format)
+	{
+		return false;
+	}
+	memcpy (header, data_, header_size);
+	return true;
+}
+
+bool
+chainy::CommitFile (
+	const std::string& path,
+	const std::vector<chromium::StringPiece>& pieces
+	)
+{
+	std::ostringstream ss;
+	bool is_written = true;
+
+#if defined(_WIN32)
+	ss << path << '.' << GetCurrentProcessId() << '.' << g_commit_sequence.fetch_add (1) << ".tmp";
+#else
+	ss << path << '.' << getpid() << '.' << g_commit_sequence.fetch_add (1) << ".tmp";
+#endif
+	const std::string temp_path (ss.str());
+	FILE* fp = file_util::OpenFile (temp_path, "wb");
+	if (nullptr == fp) {
+		LOG(WARNING) << "Cannot create \"" << temp_path << "\".";
+		return false;
+	}
+	for (const auto& piece : pieces) {
+		if (!piece.empty())
+			is_written &= 1 == fwrite (piece.data(), piece.size(), 1, fp);
+	}
+/* the rename must not be ordered before the data reaches storage */
+	is_written &= 0 == fflush (fp);
+#if defined(_WIN32)
+	is_written &= 0 == _commit (_fileno (fp));
+#else
+	is_written &= 0 == fsync (fileno (fp));
+#endif
+	is_written &= file_util::CloseFile (fp);
+	if (is_written) {
+#if defined(_WIN32)
+		is_written = 0 != MoveFileExA (temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+		is_written = 0 == rename (temp_path.c_str(), path.c_str());
+#endif
+	}
+	if (!is_written) {
+		LOG(WARNING) << "Cannot write \"" << path << "\".";
+		remove (temp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+/* eof */
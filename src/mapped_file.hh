@@ -0,0 +1,112 @@
+/* Read-only memory mapping of a whole file.
+ *
+ * The mapping remains valid after the file is replaced by rename, a writer
+ * never modifies a file in place.
+ */
+
+#ifndef MAPPED_FILE_HH_
+#define MAPPED_FILE_HH_
+
+#if defined(_WIN32)
+#	include <windows.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+#include "chromium/strings/string_piece.hh"
+
+namespace chainy
+{
+
+/* Leading fields of every file header, the magic names the content and the
+ * format its layout.
+ */
+	struct file_prefix_t {
+		char magic[8];
+		uint32_t format;
+	};
+
+	class mapped_file_t :
+		boost::noncopyable
+	{
+	public:
+		explicit mapped_file_t();
+		~mapped_file_t();
+
+/* Returns false if the file is absent, empty, or cannot be mapped. */
+		bool Open (const std::string& path);
+		void Close();
+/* Copy out a header starting with the prefix, returns false if the file is
+ * shorter than the header or of another content or format.
+ */
+		bool ReadHeader (const file_prefix_t& prefix, void* header, size_t header_size) const;
+
+		bool is_open() const {
+			return nullptr != data_;
+		}
+		const uint8_t* data() const {
+			return data_;
+		}
+		size_t size() const {
+			return size_;
+		}
+
+	private:
+		const uint8_t* data_;
+		size_t size_;
+#if defined(_WIN32)
+		HANDLE mapping_;
+#endif
+	};
+
+/* Cursor over a mapped file, every read is bounds checked. */
+	class file_reader_t
+	{
+	public:
+		file_reader_t (const uint8_t* p, size_t remaining)
+			: p_ (p)
+			, remaining_ (remaining)
+		{
+		}
+
+		template <typename T>
+		bool ReadValue (T* value) {
+			if (remaining_ < sizeof (*value))
+				return false;
+			memcpy (value, p_, sizeof (*value));
+			p_ += sizeof (*value); remaining_ -= sizeof (*value);
+			return true;
+		}
+/* Returns the bytes in place within the mapping. */
+		bool ReadBytes (size_t length, const uint8_t** bytes) {
+			if (remaining_ < length)
+				return false;
+			*bytes = p_;
+			p_ += length; remaining_ -= length;
+			return true;
+		}
+		size_t remaining() const {
+			return remaining_;
+		}
+
+	private:
+		const uint8_t* p_;
+		size_t remaining_;
+	};
+
+/* Replace a file with the concatenated pieces, written beside it under a name
+ * unique to the call, flushed to storage, then renamed over it.
+ */
+	bool CommitFile (const std::string& path, const std::vector<chromium::StringPiece>& pieces);
+
+} /* namespace chainy */
+
+#endif /* MAPPED_FILE_HH_ */
+
+/* eof */
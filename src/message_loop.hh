@@ -126,7 +126,11 @@ namespace chromium
 			virtual ~Watcher() {}
 		};
 
-		enum Mode;
+		enum Mode {
+			WATCH_READ = 1 << 0,
+			WATCH_WRITE = 1 << 1,
+			WATCH_READ_WRITE = WATCH_READ | WATCH_WRITE
+		};
 
 // Object returned by WatchFileDescriptor to manage further watching.
 		class FileDescriptorWatcher {
@@ -165,12 +169,6 @@ namespace chromium
 			std::shared_ptr<FileDescriptorWatcher> weak_factory_;
 		};
 
-		enum Mode {
-			WATCH_READ = 1 << 0,
-			WATCH_WRITE = 1 << 1,
-			WATCH_READ_WRITE = WATCH_READ | WATCH_WRITE
-		};
-
 		virtual bool WatchFileDescriptor (net::SocketDescriptor fd, bool persistent, Mode mode, FileDescriptorWatcher* controller, Watcher* delegate) = 0;
 	};
 
@@ -0,0 +1,63 @@
+/* Monotonic clock for the message pumps.
+ *
+ * Each loop reads the clock once per iteration and stamps keepalives, activity
+ * and counters from the cached value.  Linux uses CLOCK_MONOTONIC_COARSE which
+ * the vDSO serves without a system call at scheduler tick resolution, Windows
+ * uses GetTickCount64 of similar resolution.  Neither steps with wall clock
+ * adjustments.
+ */
+
+#ifndef MONOTONIC_CLOCK_HH_
+#define MONOTONIC_CLOCK_HH_
+
+#if defined(_WIN32)
+#	include <winsock2.h>
+#else
+#	include <time.h>
+#endif
+
+#include <cstdint>
+
+namespace chainy
+{
+/* Milliseconds from an arbitrary origin before process start. */
+	typedef int64_t ticks_t;
+
+	static const ticks_t kTicksPerSecond = 1000;
+
+	static inline
+	ticks_t
+	SecondsToTicks (
+		unsigned seconds
+		)
+	{
+		return static_cast<ticks_t> (seconds) * kTicksPerSecond;
+	}
+
+	static inline
+	uint32_t
+	TicksToSeconds (
+		ticks_t ticks
+		)
+	{
+		return static_cast<uint32_t> (ticks / kTicksPerSecond);
+	}
+
+	static inline
+	ticks_t
+	MonotonicTicks()
+	{
+#if defined(_WIN32)
+		return static_cast<ticks_t> (GetTickCount64());
+#else
+		struct timespec ts;
+		clock_gettime (CLOCK_MONOTONIC_COARSE, &ts);
+		return static_cast<ticks_t> (ts.tv_sec) * kTicksPerSecond + ts.tv_nsec / 1000000;
+#endif
+	}
+
+} /* namespace chainy */
+
+#endif /* MONOTONIC_CLOCK_HH_ */
+
+/* eof */
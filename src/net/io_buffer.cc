@@ -4,6 +4,8 @@
 
 #include "net/io_buffer.hh"
 
+#include <climits>
+
 #include "chromium/logging.hh"
 
 namespace net {
@@ -6,6 +6,10 @@
 
 #include <limits>
 
+#if defined(OS_POSIX)
+#include <arpa/inet.h>
+#endif
+
 #include "chromium/base64.hh"
 #include "chromium/logging.hh"
 #include "chromium/md5.hh"
@@ -14,7 +14,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
-#include "net/base/net_errors.h"
+#include "net/base/net_errors.hh"
 #endif
 
 #include "chromium/logging.hh"
@@ -72,6 +72,8 @@
 #include <windows.h>
 #endif
 #include <errno.h>  /* for EINVAL */
+#include <limits.h>
+#include <string.h>
 #include <time.h>
 
 /* Implements the Unix localtime_r() function for windows */
@@ -1,11 +1,14 @@
 /* UPA interactive provider.
  *
- * One single provider, and hence wraps a UPA session for simplicity.
+ * Each instance is one worker loop over a shard of client sessions.  Shard
+ * zero binds the server socket, hosts the HTTP server, and distributes
+ * accepted channels such that a slow encode only stalls clients of its shard.
  */
 
 #include "provider.hh"
 
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
 #ifdef _WIN32
@@ -16,6 +19,10 @@
 #else
 #	include <sys/types.h>
 #	include <sys/socket.h>
+#	include <limits.h>
+#	include <netdb.h>
+#	include <pwd.h>
+#	include <unistd.h>
 #endif
 
 #include "chromium/logging.hh"
@@ -31,14 +38,43 @@
 static const std::string kRdmFieldDictionaryName ("RWFFld");
 static const std::string kEnumTypeDictionaryName ("RWFEnum");
 
+/* Client reads per check of the read budget deadline, sampling the clock
+ * after every small request would cost more than the read itself.
+ */
+static const unsigned kReadsPerClockSample = 8;
+
+/* Timing wheel ticks are whole seconds of the monotonic clock, deadlines round
+ * up such that a timer never fires before its deadline.
+ */
+static inline
+uint64_t
+ToTick (
+	chainy::ticks_t t
+	)
+{
+	return chainy::TicksToSeconds (t);
+}
+
+static inline
+uint64_t
+ToDeadlineTick (
+	chainy::ticks_t t
+	)
+{
+	return chainy::TicksToSeconds (t + chainy::kTicksPerSecond - 1);
+}
+
 chainy::provider_t::provider_t (
 	const chainy::config_t& config,
 	std::shared_ptr<chainy::upa_t> upa,
-	chainy::client_t::Delegate* request_delegate 
+	chainy::client_t::Delegate* request_delegate,
+	unsigned shard
 	) :
-	creation_time_ (boost::posix_time::second_clock::universal_time()),
+	creation_time_ (MonotonicTicks()),
 	last_activity_ (creation_time_),
 	config_ (config),
+	shard_ (shard),
+	connection_count_ (0),
 	upa_ (upa),
 	request_delegate_ (request_delegate),
 	rssl_sock_ (nullptr),
@@ -49,10 +85,12 @@ chainy::provider_t::provider_t (
 	is_accepting_requests_ (false),
 	is_pending_directory_update_ (false),
 	wakeup_pipe_in_ (net::kInvalidSocket),
-	wakeup_pipe_out_ (net::kInvalidSocket)
+	wakeup_pipe_out_ (net::kInvalidSocket),
+	keepalives_ (ToTick (MonotonicTicks())),
+	pending_aborts_ (0)
 {
-	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
-	ZeroMemory (snap_stats_, sizeof (snap_stats_));
+	memset (cumulative_stats_, 0, sizeof (cumulative_stats_));
+	memset (snap_stats_, 0, sizeof (snap_stats_));
 }
 
 chainy::provider_t::~provider_t()
@@ -63,90 +101,62 @@ chainy::provider_t::~provider_t()
 	upa_.reset();
 // MessagePump
 	if (net::kInvalidSocket != wakeup_pipe_in_) {
+#if defined(_WIN32)
 		closesocket (wakeup_pipe_in_);
+#else
+		close (wakeup_pipe_in_);
+#endif
 	}
 	if (net::kInvalidSocket != wakeup_pipe_out_) {
+#if defined(_WIN32)
 		closesocket (wakeup_pipe_out_);
+#else
+		close (wakeup_pipe_out_);
+#endif
 	}
 /* Summary output */
 	using namespace boost::posix_time;
-	auto uptime = second_clock::universal_time() - creation_time_;
+	auto uptime = milliseconds (MonotonicTicks() - creation_time_);
 	VLOG(3) << "Provider summary: {"
-		 " \"Uptime\": \"" << to_simple_string (uptime) << "\""
+		 " \"Shard\": " << shard_ <<
+		", \"Uptime\": \"" << to_simple_string (uptime) << "\""
 		", \"ConnectionsReceived\": " << cumulative_stats_[PROVIDER_PC_CONNECTION_RECEIVED] <<
 		", \"ClientSessions\": " << cumulative_stats_[PROVIDER_PC_CLIENT_SESSION_ACCEPTED] <<
 		", \"MsgsReceived\": " << cumulative_stats_[PROVIDER_PC_RSSL_MSGS_RECEIVED] <<
 		", \"MsgsMalformed\": " << cumulative_stats_[PROVIDER_PC_RSSL_MSGS_MALFORMED] <<
+		", \"ReadBatches\": " << cumulative_stats_[PROVIDER_PC_RSSL_READ_BATCHES] <<
+		", \"ReadBudgetExhausted\": " << cumulative_stats_[PROVIDER_PC_RSSL_READ_BUDGET_EXHAUSTED] <<
 		", \"MsgsSent\": " << cumulative_stats_[PROVIDER_PC_RSSL_MSGS_SENT] <<
 		", \"MsgsEnqueued\": " << cumulative_stats_[PROVIDER_PC_RSSL_MSGS_ENQUEUED] <<
+		", \"BatchedFlushes\": " << cumulative_stats_[PROVIDER_PC_RSSL_BATCHED_FLUSH] <<
+		", \"QueueHighWater\": " << cumulative_stats_[PROVIDER_PC_CLIENT_QUEUE_HIGH_WATER] <<
+		", \"SlowConsumersEvicted\": " << cumulative_stats_[PROVIDER_PC_SLOW_CONSUMER_EVICTED] <<
 		" }";
 }
 
-/* 7.2. Establish Network Communication.
- * Open RSSL port and listen for incoming connection attempts.
- */
+/* Worker shards only receive channels accepted by shard zero. */
 bool
 chainy::provider_t::Initialize (
 	chromium::MessageLoop* consumer,
 	chainy::ChainyHttpServer::ConsumerDelegate* consumer_delegate
 	)
 {
-#ifndef NDEBUG
-	RsslBindOptions addr = RSSL_INIT_BIND_OPTS;
-#else
-	RsslBindOptions addr;
-	rsslClearBindOpts (&addr);
-#endif
-	RsslError rssl_err;
-
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = MonotonicTicks();
 
 /* RSSL Version Info. */
 	if (!upa_->VerifyVersion())
 		return false;
 
-/* 9.4.1. Bind server socket. */
-	VLOG(3) << "Binding RSSL server socket.";
-	addr.serviceName	     = const_cast<char*> (config_.downstream_rssl_port.c_str());	// port or service name
-	addr.protocolType	     = RSSL_RWF_PROTOCOL_TYPE;
-	addr.majorVersion	     = RSSL_RWF_MAJOR_VERSION;
-	addr.minorVersion	     = RSSL_RWF_MINOR_VERSION;
-
-	RsslServer* s = rsslBind (&addr, &rssl_err);
-/* Hard failure on bind as likely a configuration issue. */
-	if (nullptr == s) {
-		LOG(ERROR) << "rsslBind: { "
-			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
-			", \"sysError\": " << rssl_err.sysError << ""
-			", \"text\": \"" << rssl_err.text << "\""
-			", \"serviceName\": \"" << addr.serviceName << "\""
-			", \"protocolType\": \"" << internal::protocol_type_string (addr.protocolType) << "\""
-			", \"majorVersion\": " << static_cast<unsigned> (addr.majorVersion) << ""
-			", \"minorVersion\": " << static_cast<unsigned> (addr.minorVersion) << ""
-			" }";
+/* selector must exist before the HTTP server registers its listen socket */
+	if (!selector_.Open())
 		return false;
-	} else {
-		LOG(INFO) << "RSSL server socket created: { "
-			  "\"portNumber\": " << s->portNumber << ""
-			", \"protocolType\": \"" << internal::protocol_type_string (addr.protocolType) << "\""
-			", \"majorVersion\": " << static_cast<unsigned> (addr.majorVersion) << ""
-			", \"minorVersion\": " << static_cast<unsigned> (addr.minorVersion) << ""
-			", \"socketId\": " << s->socketId << ""
-			", \"state\": \"" << internal::channel_state_string (s->state) << "\""
-			" }";
-		rssl_sock_ = s;
-	}
-
-/* temporary race condition setting selector */
-	FD_ZERO (&in_rfds_);
-/* Built in HTTPD server. */
-	server_.reset (new ChainyHttpServer (this, consumer, consumer_delegate, this));
-	if (!(bool)server_ || !server_->Start (7580))
+	if (0 == shard_ && !Listen (consumer, consumer_delegate))
 		return false;
 
 // MessageLoop 
 	this->pump_ = shared_from_this();
 
+#if defined(_WIN32)
 	{
 	        struct sockaddr_in addr;
 	        SOCKET listener;
@@ -182,7 +192,74 @@ chainy::provider_t::Initialize (
 	        sockerr = closesocket (listener);
 	        DCHECK (sockerr != SOCKET_ERROR);	
 	}
+#else
+	{
+		int fds[2];
+		if (-1 == socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds)) {
+			DLOG(ERROR) << "socketpair failed, errno: " << errno;
+			return false;
+		}
+		wakeup_pipe_in_ = fds[0];
+		wakeup_pipe_out_ = fds[1];
+	}
+#endif
+
+	return true;
+}
+
+/* 7.2. Establish Network Communication.
+ * Open RSSL port and listen for incoming connection attempts.
+ */
+bool
+chainy::provider_t::Listen (
+	chromium::MessageLoop* consumer,
+	chainy::ChainyHttpServer::ConsumerDelegate* consumer_delegate
+	)
+{
+#ifndef NDEBUG
+	RsslBindOptions addr = RSSL_INIT_BIND_OPTS;
+#else
+	RsslBindOptions addr;
+	rsslClearBindOpts (&addr);
+#endif
+	RsslError rssl_err;
+
+/* 9.4.1. Bind server socket. */
+	VLOG(3) << "Binding RSSL server socket.";
+	addr.serviceName	     = const_cast<char*> (config_.downstream_rssl_port.c_str());	// port or service name
+	addr.protocolType	     = RSSL_RWF_PROTOCOL_TYPE;
+	addr.majorVersion	     = RSSL_RWF_MAJOR_VERSION;
+	addr.minorVersion	     = RSSL_RWF_MINOR_VERSION;
+
+	RsslServer* s = rsslBind (&addr, &rssl_err);
+/* Hard failure on bind as likely a configuration issue. */
+	if (nullptr == s) {
+		LOG(ERROR) << "rsslBind: { "
+			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
+			", \"sysError\": " << rssl_err.sysError << ""
+			", \"text\": \"" << rssl_err.text << "\""
+			", \"serviceName\": \"" << addr.serviceName << "\""
+			", \"protocolType\": \"" << internal::protocol_type_string (addr.protocolType) << "\""
+			", \"majorVersion\": " << static_cast<unsigned> (addr.majorVersion) << ""
+			", \"minorVersion\": " << static_cast<unsigned> (addr.minorVersion) << ""
+			" }";
+		return false;
+	} else {
+		LOG(INFO) << "RSSL server socket created: { "
+			  "\"portNumber\": " << s->portNumber << ""
+			", \"protocolType\": \"" << internal::protocol_type_string (addr.protocolType) << "\""
+			", \"majorVersion\": " << static_cast<unsigned> (addr.majorVersion) << ""
+			", \"minorVersion\": " << static_cast<unsigned> (addr.minorVersion) << ""
+			", \"socketId\": " << s->socketId << ""
+			", \"state\": \"" << internal::channel_state_string (s->state) << "\""
+			" }";
+		rssl_sock_ = s;
+	}
 
+/* Built in HTTPD server. */
+	server_.reset (new ChainyHttpServer (this, consumer, consumer_delegate, this));
+	if (!(bool)server_ || !server_->Start (7580))
+		return false;
 	return true;
 }
 
@@ -205,12 +282,12 @@ chainy::provider_t::Close()
 	}
 
 /* 2) IFF tokens, pump messages until empty. */
-	if (nullptr != rssl_sock_ && !clients_.empty())
+	if (!clients_.empty())
 	{
-		FD_ZERO (&in_rfds_); FD_SET (rssl_sock_->socketId, &in_rfds_);
-		FD_ZERO (&in_wfds_);
-		FD_ZERO (&in_efds_);
-		in_nfds_ = out_nfds_ = 0;
+		selector_.Clear();
+		if (nullptr != rssl_sock_)
+			selector_.Set (rssl_sock_->socketId, selector_t::kReadable);
+		out_nfds_ = 0;
 		in_tv_.tv_sec = 0;
 		in_tv_.tv_usec = 1000 * 100;
 
@@ -228,16 +305,11 @@ chainy::provider_t::Close()
 				VLOG(3) << "Waiting on " << active_tokens << " active tokens in " << clients_.size() << " active clients.";
 			}
 
+			FlushPendingWrites();
 			if (did_work)
 				continue;
 
-			out_rfds_ = in_rfds_;
-			out_wfds_ = in_wfds_;
-			out_efds_ = in_efds_;
-			out_tv_.tv_sec = in_tv_.tv_sec;
-			out_tv_.tv_usec = in_tv_.tv_usec;
-
-			out_nfds_ = select (in_nfds_ + 1, &out_rfds_, &out_wfds_, &out_efds_, &out_tv_);
+			out_nfds_ = selector_.Wait (in_tv_);
 		}
 	}
 
@@ -246,12 +318,13 @@ chainy::provider_t::Close()
 	for (auto it = clients_.begin(); it != clients_.end(); ++it) {
 		auto client = it->second;
 		client->Close();
+		client->WritePack();
 /* 4) Flush message stream */
 		RsslChannel* c = client->handle();
 /* channel still open */
 		if ((RSSL_CH_STATE_ACTIVE == c->state) &&
 /* data pending */
-			FD_ISSET (c->socketId, &in_wfds_))
+			selector_.IsSet (c->socketId, selector_t::kWritable))
 		{
 			do {
 				DVLOG(1) << "rsslFlush";
@@ -261,7 +334,7 @@ chainy::provider_t::Close()
 					cumulative_stats_[PROVIDER_PC_RSSL_MSGS_SENT] += client->GetPendingCount();
 					client->ClearPendingCount();
 					cumulative_stats_[PROVIDER_PC_RSSL_FLUSH]++;
-					FD_CLR (c->socketId, &in_wfds_);
+					selector_.Unset (c->socketId, selector_t::kWritable);
 					break;
 				}
 			} while (rc > 0);
@@ -306,6 +379,7 @@ chainy::provider_t::Close()
 	for (auto it = connections_.begin(); it != connections_.end(); ++it) {
 		Close (*it);
 	}
+	connection_count_.fetch_sub (connections_.size());
 	connections_.clear();
 
 /* Drop self reference for MessagePump */
@@ -424,23 +498,18 @@ chainy::provider_t::WriteRawClose (
 	return true;
 }
 
-bool
-chainy::provider_t::SendReply (
-	RsslChannel*const handle,
-	int32_t token,
-	const void* data,
-	size_t length,
-	bool and_close
+/* Returns empty if the client has disconnected before the reply is available. */
+std::shared_ptr<chainy::client_t>
+chainy::provider_t::GetClient (
+	RsslChannel*const handle
 	)
 {
 	boost::shared_lock<boost::shared_mutex> lock (clients_lock_);
 	auto client = clients_.find (handle);
-	lock.unlock();
-/* client may have disconnected before reply is available. */
 	if (clients_.end() != client)
-		return client->second->SendReply (token, data, length, and_close);
+		return client->second;
 	else
-		return false;
+		return std::shared_ptr<client_t>();
 }
 
 void
@@ -455,6 +524,7 @@ chainy::provider_t::CreateInfo (
 /* hostname */
 	rc = gethostname (http_hostname, sizeof (http_hostname));
 	if (0 != rc) {
+#if defined(_WIN32)
 		const int save_errno = WSAGetLastError();
 		char errbuf[1024];
 		FormatMessage (FORMAT_MESSAGE_FROM_SYSTEM,
@@ -464,6 +534,10 @@ chainy::provider_t::CreateInfo (
                        		(LPTSTR)errbuf,
                        		sizeof (errbuf),
                        		NULL);           /* arguments */
+#else
+		const int save_errno = errno;
+		const char* errbuf = strerror (save_errno);
+#endif
 		LOG(ERROR) << "gethostname: { "
 			  "\"errno\": " << save_errno << ""
 			", \"text\": \"" << errbuf << "\""
@@ -476,6 +550,7 @@ chainy::provider_t::CreateInfo (
 	}
 
 /* username */
+#if defined(_WIN32)
 	wchar_t wusername[UNLEN + 1];
 	DWORD nSize = arraysize( wusername );
 	if (!GetUserNameW (wusername, &nSize)) {
@@ -498,15 +573,51 @@ chainy::provider_t::CreateInfo (
 		WideCharToMultiByte (CP_UTF8, 0, wusername, nSize + 1, http_username, sizeof (http_username), NULL, NULL);
 		info->username.assign (http_username);
 	}
+#else
+/* effective user, a login name is absent for daemons */
+	struct passwd pwd, *result = nullptr;
+	char pwbuf[1024];
+	rc = getpwuid_r (geteuid(), &pwd, pwbuf, sizeof (pwbuf), &result);
+	if (0 != rc || nullptr == result) {
+		LOG(ERROR) << "getpwuid_r: { "
+			  "\"errno\": " << rc << ""
+			", \"text\": \"" << strerror (rc) << "\""
+			" }";
+// fallback value
+		info->username.clear();
+	} else {
+		strncpy (http_username, pwd.pw_name, sizeof (http_username));
+		http_username[LOGIN_NAME_MAX] = '\0';
+		info->username.assign (http_username);
+	}
+#endif
 
 /* pid */
 	info->pid = getpid();
 
 /* clients */
-	info->client_count = connections_.size();
+	info->client_count = GetConnectionCount();
 
 /* app level request count */
 	info->msgs_received = cumulative_stats_[PROVIDER_PC_RSSL_MSGS_RECEIVED];
+
+/* outbound queue of each client session across all worker loops */
+	std::vector<provider_t*> shards (shards_);
+	if (shards.empty())
+		shards.push_back (this);
+	for (auto shard : shards) {
+		boost::shared_lock<boost::shared_mutex> lock (shard->clients_lock_);
+		for (auto it = shard->clients_.begin(); it != shard->clients_.end(); ++it) {
+			const auto& client = it->second;
+			SessionInfo session;
+			session.address = client->address();
+			session.shard = shard->shard_;
+			session.queued_msgs = client->queued_msgs();
+			session.queued_bytes = client->queued_bytes();
+			session.lag = client->lag();
+			info->sessions.push_back (session);
+		}
+	}
 }
 
 void
@@ -514,10 +625,10 @@ chainy::provider_t::Run()
 {
 	DCHECK(keep_running_) << "Quit must have been called outside of Run!";
 
-	FD_ZERO (&in_rfds_); FD_SET (rssl_sock_->socketId, &in_rfds_); FD_ZERO (&out_rfds_);
-	FD_ZERO (&in_wfds_); FD_ZERO (&out_wfds_);
-	FD_ZERO (&in_efds_); FD_ZERO (&out_efds_);
-	in_nfds_ = out_nfds_ = 0;
+	selector_.Clear();
+	if (nullptr != rssl_sock_)
+		selector_.Set (rssl_sock_->socketId, selector_t::kReadable);
+	out_nfds_ = 0;
 	in_tv_.tv_sec = 0;
 	in_tv_.tv_usec = 1000 * 100;
 
@@ -528,12 +639,12 @@ chainy::provider_t::Run()
 	{
 		if (auto sp = it->lock()) {
 			net::SocketDescriptor fd = sp->event_->first;
-			FD_SET (fd, &in_rfds_);
+			selector_.Set (fd, selector_t::kReadable);
 		}
 	}
 
 // MessagePump wakeup events
-	FD_SET (wakeup_pipe_out_, &in_rfds_);
+	selector_.Set (wakeup_pipe_out_, selector_t::kReadable);
 
 	for (;;) {
 		bool did_work = DoInternalWork();
@@ -549,6 +660,8 @@ chainy::provider_t::Run()
 		if (!keep_running_)
 			break;
 
+		FlushPendingWrites();
+
 		if (did_work)
 			continue;
 
@@ -560,14 +673,7 @@ chainy::provider_t::Run()
 		if (did_work)
 			continue;
 
-/* Reset fd state */
-		out_rfds_ = in_rfds_;
-		out_wfds_ = in_wfds_;
-		out_efds_ = in_efds_;
-		out_tv_.tv_sec = in_tv_.tv_sec;
-		out_tv_.tv_usec = in_tv_.tv_usec;
-
-		out_nfds_ = select (in_nfds_ + 1, &out_rfds_, &out_wfds_, &out_efds_, &out_tv_);
+		out_nfds_ = selector_.Wait (in_tv_);
 	}
 
 	keep_running_ = true;
@@ -578,41 +684,34 @@ chainy::provider_t::DoInternalWork()
 {
 	bool did_work = false;
 
-	last_activity_ = boost::posix_time::second_clock::universal_time();
+	last_activity_ = MonotonicTicks();
+
+/* Keepalives due this second, sessions not due are not visited. */
+	OnKeepaliveTimers();
 
-/* Only check keepalives on timeout */
 	if (out_nfds_ <= 0)
 	{
-		for (auto it = connections_.begin(); it != connections_.end();) {
+/* Sweep channels aborted by keepalive timeout or otherwise since the last sweep. */
+		for (auto it = connections_.begin(); pending_aborts_ > 0 && it != connections_.end();) {
 			RsslChannel* c = *it;
-			if (nullptr != c->userSpecPtr && RSSL_CH_STATE_ACTIVE == c->state) {
-				auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-				if (last_activity_ >= client->NextPing()) {
-					Ping (c);
-				}
-				if (last_activity_ >= client->NextPong()) {
-					cumulative_stats_[PROVIDER_PC_RSSL_PONG_TIMEOUT]++;
-					LOG(ERROR) << "Pong timeout from peer, aborting connection.";
-					Abort (c);
-				}
-			}
-			if (FD_ISSET (c->socketId, &out_efds_)) {
+			if (selector_.IsReady (c->socketId, selector_t::kException)) {
 				cumulative_stats_[PROVIDER_PC_CONNECTION_EXCEPTION]++;
 				DVLOG(3) << "Socket exception.";
 /* Remove connection from list */
 				auto jt = it++;
 				connections_.erase (jt);
+				connection_count_--;
 /* Remove client from map */
 				{
 					boost::lock_guard<boost::shared_mutex> lock (clients_lock_);
 					auto kt = clients_.find (c);
-					if (clients_.end() != kt)
+					if (clients_.end() != kt) {
+						kt->second->keepalive_timer_.Cancel();
 						clients_.erase (kt);
+					}
 				}
 /* Remove RSSL socket from further event notification */
-				FD_CLR (c->socketId, &in_rfds_);
-				FD_CLR (c->socketId, &in_wfds_);
-				FD_CLR (c->socketId, &in_efds_);
+				selector_.Unset (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 /* Ensure RSSL has closed out */
 				if (RSSL_CH_STATE_CLOSED != c->state)
 					Close (c);
@@ -620,6 +719,7 @@ chainy::provider_t::DoInternalWork()
 				++it;
 			}
 		}
+		pending_aborts_ = 0;
 
 /* tbd: throttle directory updates to not overload infrastructure. */
 		if (is_pending_directory_update_.exchange (false)) {
@@ -636,8 +736,8 @@ chainy::provider_t::DoInternalWork()
 	}
 
 /* New client connection */
-	if (FD_ISSET (rssl_sock_->socketId, &out_rfds_)) {
-		FD_CLR (rssl_sock_->socketId, &out_rfds_);
+	if (nullptr != rssl_sock_ && selector_.IsReady (rssl_sock_->socketId, selector_t::kReadable)) {
+		selector_.ClearReady (rssl_sock_->socketId, selector_t::kReadable);
 		OnConnection (rssl_sock_);
 		did_work = true;
 	}
@@ -646,47 +746,36 @@ chainy::provider_t::DoInternalWork()
 	for (auto it = connections_.begin(); it != connections_.end();) {
 		RsslChannel* c = *it;
 /* incoming */
-		if (FD_ISSET (c->socketId, &out_rfds_)) {
-			FD_CLR (c->socketId, &out_rfds_);
+		if (selector_.IsReady (c->socketId, selector_t::kReadable)) {
+			selector_.ClearReady (c->socketId, selector_t::kReadable);
 			OnCanReadWithoutBlocking (c);
 			did_work = true;
 		}
 /* outgoing */
-		if (FD_ISSET (c->socketId, &out_wfds_)) {
-			FD_CLR (c->socketId, &out_wfds_);
+		if (selector_.IsReady (c->socketId, selector_t::kWritable)) {
+			selector_.ClearReady (c->socketId, selector_t::kWritable);
 			OnCanWriteWithoutBlocking (c);
 			did_work = true;
 		}
-/* Keepalive timeout on active session above connection */
-		if (nullptr != c->userSpecPtr && RSSL_CH_STATE_ACTIVE == c->state) {
-			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-			if (last_activity_ >= client->NextPing()) {
-				Ping (c);
-			}
-			if (last_activity_ >= client->NextPong()) {
-				cumulative_stats_[PROVIDER_PC_RSSL_PONG_TIMEOUT]++;
-				LOG(ERROR) << "Pong timeout from peer, aborting connection.";
-				Abort (c);
-			}
-		}
 /* disconnects */
-		if (FD_ISSET (c->socketId, &out_efds_)) {
+		if (selector_.IsReady (c->socketId, selector_t::kException)) {
 			cumulative_stats_[PROVIDER_PC_CONNECTION_EXCEPTION]++;
 			DVLOG(3) << "Socket exception.";
 /* Remove connection from list */
 			auto jt = it++;
 			connections_.erase (jt);
+			connection_count_--;
 /* Remove client from map */
 			{
 				boost::lock_guard<boost::shared_mutex> lock (clients_lock_);
 				auto kt = clients_.find (c);
-				if (clients_.end() != kt)
+				if (clients_.end() != kt) {
+					kt->second->keepalive_timer_.Cancel();
 					clients_.erase (kt);
+				}
 			}
 /* Remove RSSL socket from further event notification */
-			FD_CLR (c->socketId, &in_rfds_);
-			FD_CLR (c->socketId, &in_wfds_);
-			FD_CLR (c->socketId, &in_efds_);
+			selector_.Unset (c->socketId, selector_t::kReadable | selector_t::kWritable | selector_t::kException);
 /* Ensure RSSL has closed out */
 			if (RSSL_CH_STATE_CLOSED != c->state)
 				Close (c);
@@ -696,8 +785,8 @@ chainy::provider_t::DoInternalWork()
 	}
 
 // MessagePump wakeup event
-	if (FD_ISSET (wakeup_pipe_out_, &out_rfds_)) {
-		FD_CLR (wakeup_pipe_out_, &out_rfds_);
+	if (selector_.IsReady (wakeup_pipe_out_, selector_t::kReadable)) {
+		selector_.ClearReady (wakeup_pipe_out_, selector_t::kReadable);
 		OnWakeup();
 	}
 
@@ -708,13 +797,13 @@ chainy::provider_t::DoInternalWork()
 		if (auto sp = it->lock()) {
 			FileDescriptorWatcher* controller = sp.get();
 			net::SocketDescriptor fd = controller->event_->first;
-			if (FD_ISSET (fd, &out_rfds_)) {
-				FD_CLR (fd, &out_rfds_);
+			if (selector_.IsReady (fd, selector_t::kReadable)) {
+				selector_.ClearReady (fd, selector_t::kReadable);
 				controller->OnFileCanReadWithoutBlocking (fd, this);
 				did_work = true;
 			}
-			if (FD_ISSET (fd, &out_wfds_)) {
-				FD_CLR (fd, &out_wfds_);
+			if (selector_.IsReady (fd, selector_t::kWritable)) {
+				selector_.ClearReady (fd, selector_t::kWritable);
 				controller->OnFileCanWriteWithoutBlocking (fd, this);
 				did_work = true;
 			}
@@ -728,6 +817,29 @@ chainy::provider_t::DoInternalWork()
 	return did_work;
 }
 
+/* End of loop iteration: queue any open packed buffer and flush each channel
+ * written since, one flush per channel rather than per reply.  Output left
+ * pending remains on the writable interest set.
+ */
+void
+chainy::provider_t::FlushPendingWrites()
+{
+	for (auto it = connections_.begin(); it != connections_.end(); ++it) {
+		RsslChannel* c = *it;
+		if (nullptr == c->userSpecPtr || RSSL_CH_STATE_ACTIVE != c->state)
+			continue;
+		auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
+		if (!client->is_flush_pending_)
+			continue;
+		client->WritePack();
+		client->is_flush_pending_ = false;
+		if (selector_.IsSet (c->socketId, selector_t::kWritable)) {
+			cumulative_stats_[PROVIDER_PC_RSSL_BATCHED_FLUSH]++;
+			OnCanWriteWithoutBlocking (c);
+		}
+	}
+}
+
 /* Add a Chromium socket to the message loop monitoring pool */
 bool
 chainy::provider_t::WatchFileDescriptor (
@@ -744,10 +856,10 @@ chainy::provider_t::WatchFileDescriptor (
 	DCHECK(mode == WATCH_READ || mode == WATCH_WRITE || mode == WATCH_READ_WRITE);
 
 	if (mode & WATCH_READ) {
-		FD_SET (fd, &in_rfds_);
+		selector_.Set (fd, selector_t::kReadable);
 	}
 	if (mode & WATCH_WRITE) {
-		FD_SET (fd, &in_wfds_);
+		selector_.Set (fd, selector_t::kWritable);
 	}
 
 	std::unique_ptr<FileDescriptorWatcher::event> evt (controller->ReleaseEvent());
@@ -795,7 +907,7 @@ chainy::provider_t::FileDescriptorWatcher::StopWatchingFileDescriptor()
 		return true;
 	}
 
-	FD_CLR (e->first, &pump_->in_rfds_);
+	pump_->selector_.Unset (e->first, selector_t::kReadable | selector_t::kWritable);
 	delete e;
 	pump_ = nullptr;
 	watcher_ = nullptr;
@@ -887,7 +999,7 @@ chainy::provider_t::OnConnection (
 {
 	DCHECK (nullptr != rssl_sock);
 	cumulative_stats_[PROVIDER_PC_CONNECTION_RECEIVED]++;
-	if (!is_accepting_connections_ || connections_.size() == config_.session_capacity)
+	if (!is_accepting_connections_ || GetConnectionCount() >= config_.session_capacity)
 		RejectConnection (rssl_sock);
 	else
 		AcceptConnection (rssl_sock);
@@ -948,13 +1060,6 @@ chainy::provider_t::AcceptConnection (
 			", \"nakMount\": " << (addr.nakMount ? "true" : "false") << ""
 			" }";
 	} else {
-/* Add to directory of all client connections */
-		connections_.emplace_back (c);
-
-/* Wait for client session */
-		FD_SET (c->socketId, &in_rfds_);
-		FD_SET (c->socketId, &in_efds_);
-
 		cumulative_stats_[PROVIDER_PC_CONNECTION_ACCEPTED]++;
 
 		std::stringstream client_hostname, client_ip;
@@ -967,6 +1072,9 @@ chainy::provider_t::AcceptConnection (
 		else	
 			client_ip << '"' << c->clientIP << '"';
 
+		provider_t* shard = NextShard();
+		shard->connection_count_++;
+
 		LOG(INFO) << "RSSL client socket created: { "
 			  "\"clientHostname\": " << client_hostname.str() << ""
 			", \"clientIP\": " << client_ip.str() << ""
@@ -977,8 +1085,58 @@ chainy::provider_t::AcceptConnection (
 			", \"protocolType\": \"" << internal::protocol_type_string (c->protocolType) << "\""
 			", \"socketId\": " << c->socketId << ""
 			", \"state\": \"" << internal::channel_state_string (c->state) << "\""
+			", \"shard\": " << shard->shard_ << ""
 			" }";
+/* The channel is only touched by the owning shard from here on. */
+		if (this == shard) {
+			AddConnection (c);
+		} else {
+			shard->PostTask ([shard, c]() {
+				shard->AddConnection (c);
+			});
+		}
+	}
+}
+
+/* Least connections first, counting channels still in flight to a shard. */
+chainy::provider_t*
+chainy::provider_t::NextShard()
+{
+	provider_t* next = this;
+	size_t next_count = connection_count_.load();
+	for (auto shard : shards_) {
+		const size_t count = shard->connection_count_.load();
+		if (count < next_count) {
+			next = shard;
+			next_count = count;
+		}
 	}
+	return next;
+}
+
+size_t
+chainy::provider_t::GetConnectionCount() const
+{
+	if (shards_.empty())
+		return connection_count_.load();
+	size_t count = 0;
+	for (auto shard : shards_)
+		count += shard->connection_count_.load();
+	return count;
+}
+
+/* Owning shard: add an accepted channel to this loop. */
+void
+chainy::provider_t::AddConnection (
+	RsslChannel* c
+	)
+{
+	DCHECK (nullptr != c);
+/* Add to directory of all client connections */
+	connections_.emplace_back (c);
+
+/* Wait for client session */
+	selector_.Set (c->socketId, selector_t::kReadable | selector_t::kException);
 }
 
 void
@@ -1032,15 +1190,15 @@ chainy::provider_t::OnInitializingState (
 		if ((state.flags & RSSL_IP_FD_CHANGE) == RSSL_IP_FD_CHANGE) {
 			cumulative_stats_[PROVIDER_PC_RSSL_PROTOCOL_DOWNGRADE]++;
 			LOG(INFO) << "RSSL protocol downgrade, reconnected.";
-			FD_CLR (state.oldSocket, &in_rfds_); FD_CLR (state.oldSocket, &in_efds_);
-			FD_SET (c->socketId, &in_rfds_); FD_SET (c->socketId, &in_efds_);
+			selector_.Unset (state.oldSocket, selector_t::kReadable | selector_t::kException);
+			selector_.Set (c->socketId, selector_t::kReadable | selector_t::kException);
 		} else {
 			LOG(INFO) << "RSSL connection in progress.";
 		}
 		break;
 	case RSSL_RET_SUCCESS:
 		OnActiveClientSession (c);
-		FD_SET (c->socketId, &in_rfds_); FD_SET (c->socketId, &in_efds_);
+		selector_.Set (c->socketId, selector_t::kReadable | selector_t::kException);
 		break;
 	default:
 		LOG(ERROR) << "rsslInitChannel: { "
@@ -1071,16 +1229,23 @@ chainy::provider_t::OnCanWriteWithoutBlocking (
 	rc = rsslFlush (c, &rssl_err);
 	if (RSSL_RET_SUCCESS == rc) {
 		cumulative_stats_[PROVIDER_PC_RSSL_FLUSH]++;
-		FD_CLR (c->socketId, &in_wfds_);
+		selector_.Unset (c->socketId, selector_t::kWritable);
 /* Sent data equivalent to a ping. */
 		if (nullptr != c->userSpecPtr) {
 			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
 			cumulative_stats_[PROVIDER_PC_RSSL_MSGS_SENT] += client->GetPendingCount();
 			client->ClearPendingCount();
-			client->SetNextPing (last_activity_ + boost::posix_time::seconds (client->ping_interval_));
+			client->queued_bytes_ = 0;
+			UpdateBacklog (client);
+			client->SetNextPing (last_activity_ + SecondsToTicks (client->ping_interval_));
 		}
 	} else if (rc > 0) {
 		DVLOG(1) << static_cast<signed> (rc) << " bytes pending.";
+		if (nullptr != c->userSpecPtr) {
+			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
+			client->queued_bytes_ = static_cast<uint32_t> (rc);
+			UpdateBacklog (client);
+		}
 	} else {
 		LOG(ERROR) << "rsslFlush: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
@@ -1096,9 +1261,108 @@ chainy::provider_t::Abort (
 	)
 {
 	DCHECK (nullptr != c);
-	FD_CLR (c->socketId, &out_rfds_);
-	FD_CLR (c->socketId, &out_wfds_);
-	FD_SET (c->socketId, &out_efds_);
+	selector_.ClearReady (c->socketId, selector_t::kReadable | selector_t::kWritable);
+	selector_.SetReady (c->socketId, selector_t::kException);
+	pending_aborts_++;
+}
+
+/* Arm the session timer at the earliest of the next ping, the pong timeout,
+ * and the slow consumer lag timeout whilst backlogged.
+ */
+void
+chainy::provider_t::ScheduleKeepalive (
+	client_t* client
+	)
+{
+	DCHECK (nullptr != client);
+	ticks_t deadline = std::min (client->NextPing(), client->NextPong());
+	if (client->IsBacklogged() && config_.client_lag_timeout > 0)
+		deadline = std::min (deadline, client->backlog_start_ + SecondsToTicks (config_.client_lag_timeout));
+	keepalives_.Schedule (&client->keepalive_timer_, ToDeadlineTick (deadline));
+}
+
+/* Keepalive timeout on active session above connection, only sessions with a
+ * deadline due are visited.  Sending a ping re-arms through SetNextPing, any
+ * other session is re-armed for its next deadline.
+ */
+void
+chainy::provider_t::OnKeepaliveTimers()
+{
+	const uint64_t now = ToTick (last_activity_);
+	timing_wheel_t::timer_t* timer;
+	while (nullptr != (timer = keepalives_.Expire (now))) {
+		auto client = static_cast<client_t*> (timer->context());
+		RsslChannel* c = client->handle();
+		if (RSSL_CH_STATE_ACTIVE != c->state)
+			continue;
+		if (last_activity_ >= client->NextPing()) {
+			Ping (c);
+		}
+		if (last_activity_ >= client->NextPong()) {
+			cumulative_stats_[PROVIDER_PC_RSSL_PONG_TIMEOUT]++;
+			LOG(ERROR) << "Pong timeout from peer, aborting connection.";
+			Abort (c);
+			continue;
+		}
+		CheckBacklog (c, client);
+		ScheduleKeepalive (client);
+	}
+}
+
+/* Track the outbound queue of a client session against the high-water marks,
+ * the client sheds new requests whilst backlogged.
+ */
+void
+chainy::provider_t::UpdateBacklog (
+	client_t* client
+	)
+{
+	DCHECK (nullptr != client);
+	const uint32_t queued_bytes = client->queued_bytes_.load();
+	const unsigned queued_msgs = client->pending_count_.load();
+	client->max_queued_bytes_ = std::max (client->max_queued_bytes_, queued_bytes);
+	const bool is_above = (config_.client_queue_bytes > 0 && queued_bytes >= config_.client_queue_bytes)
+		|| (config_.client_queue_msgs > 0 && queued_msgs >= config_.client_queue_msgs);
+	if (is_above) {
+		if (!client->IsBacklogged()) {
+			client->backlog_start_ = last_activity_;
+			client->cumulative_stats_[CLIENT_PC_QUEUE_HIGH_WATER]++;
+			cumulative_stats_[PROVIDER_PC_CLIENT_QUEUE_HIGH_WATER]++;
+			LOG(WARNING) << client->prefix_ << "Outbound queue above high-water mark: { "
+				  "\"queuedBytes\": " << queued_bytes << ""
+				", \"queuedMsgs\": " << queued_msgs << ""
+				" }";
+/* arm the lag timeout */
+			ScheduleKeepalive (client);
+		}
+		client->lag_ = TicksToSeconds (last_activity_ - client->backlog_start_);
+	} else if (client->IsBacklogged()) {
+		LOG(INFO) << client->prefix_ << "Outbound queue below high-water mark after " << client->lag_.load() << " seconds.";
+		client->backlog_start_ = 0;
+		client->lag_ = 0;
+	}
+}
+
+/* Disconnect a slow consumer that remains backlogged beyond the lag timeout,
+ * RSSL output buffers are shared by every channel of the server.
+ */
+void
+chainy::provider_t::CheckBacklog (
+	RsslChannel* c,
+	client_t* client
+	)
+{
+	DCHECK (nullptr != c);
+	DCHECK (nullptr != client);
+	UpdateBacklog (client);
+	if (client->IsBacklogged()
+		&& config_.client_lag_timeout > 0
+		&& client->lag_.load() >= config_.client_lag_timeout)
+	{
+		cumulative_stats_[PROVIDER_PC_SLOW_CONSUMER_EVICTED]++;
+		LOG(ERROR) << client->prefix_ << "Slow consumer backlogged for " << client->lag_.load() << " seconds, aborting connection.";
+		Abort (c);
+	}
 }
 
 void
@@ -1151,10 +1415,42 @@ chainy::provider_t::OnActiveClientSession (
 	}
 }
 
+/* One client flooding requests must not stall the other sessions served by
+ * this worker, read until drained or the budget is spent.
+ */
 void
 chainy::provider_t::OnActiveState (
 	RsslChannel* c
 	)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds (config_.read_budget_time);
+	unsigned reads = 0;
+	RsslRet rc;
+
+	DCHECK (nullptr != c);
+
+	cumulative_stats_[PROVIDER_PC_RSSL_READ_BATCHES]++;
+	do {
+		rc = OnRead (c);
+		++reads;
+/* client session aborted within the read, pending removal */
+		if (selector_.IsReady (c->socketId, selector_t::kException))
+			return;
+	} while (rc > 0
+		&& reads < config_.read_budget
+		&& (0 != reads % kReadsPerClockSample || std::chrono::steady_clock::now() < deadline));
+	if (rc > 0) {
+		cumulative_stats_[PROVIDER_PC_RSSL_READ_BUDGET_EXHAUSTED]++;
+/* pending buffer needs flushing out before IO notification can resume */
+		selector_.SetReady (c->socketId, selector_t::kReadable);
+	}
+}
+
+/* Returns pending byte count from one rsslReadEx. */
+RsslRet
+chainy::provider_t::OnRead (
+	RsslChannel* c
+	)
 {
 	RsslBuffer* buf;
 	RsslReadInArgs in_args;
@@ -1218,14 +1514,14 @@ check_closed_state:
 	case RSSL_RET_READ_FD_CHANGE:
 		cumulative_stats_[PROVIDER_PC_RSSL_RECONNECT]++;
 		LOG(INFO) << "RSSL reconnected.";
-		FD_CLR (c->oldSocketId, &in_rfds_); FD_CLR (c->oldSocketId, &in_efds_);
-		FD_SET (c->socketId, &in_rfds_); FD_SET (c->socketId, &in_efds_);
+		selector_.Unset (c->oldSocketId, selector_t::kReadable | selector_t::kException);
+		selector_.Set (c->socketId, selector_t::kReadable | selector_t::kException);
 		break;
 	case RSSL_RET_READ_PING:
 		cumulative_stats_[PROVIDER_PC_RSSL_PONG_RECEIVED]++;
 		if (nullptr != c->userSpecPtr) {
 			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-			client->SetNextPong (last_activity_ + boost::posix_time::seconds (c->pingTimeout));
+			client->SetNextPong (last_activity_ + SecondsToTicks (c->pingTimeout));
 		}
 		DVLOG(1) << "RSSL pong.";
 		break;
@@ -1251,15 +1547,12 @@ check_closed_state:
 /* Received data equivalent to a heartbeat pong. */
 			if (nullptr != c->userSpecPtr) {
 				auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-				client->SetNextPong (last_activity_ + boost::posix_time::seconds (c->pingTimeout));
+				client->SetNextPong (last_activity_ + SecondsToTicks (c->pingTimeout));
 			}
 		}
-		if (rc > 0) {
-/* pending buffer needs flushing out before IO notification can resume */
-			FD_SET (c->socketId, &out_rfds_);
-		}
 		break;
 	}
+	return rc;
 }
 
 void
@@ -2255,9 +2548,8 @@ chainy::provider_t::Submit (
 
 	rsslClearWriteInArgs (&in_args);
 	in_args.rsslPriority = RSSL_LOW_PRIORITY;	/* flushing priority */
-/* direct write on clear socket, enqueue when writes are pending */
-	const bool should_write_direct = !FD_ISSET (c->socketId, &in_wfds_);
-	in_args.writeInFlags = should_write_direct ? RSSL_WRITE_DIRECT_SOCKET_WRITE : 0;
+/* always enqueue, FlushPendingWrites issues one flush per channel per loop iteration */
+	in_args.writeInFlags = 0;
 
 try_again:
 	if (logging::DEBUG_MODE) {
@@ -2289,6 +2581,8 @@ try_again:
 		if (nullptr != c->userSpecPtr) {
 			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
 			client->IncrementPendingCount();
+			client->queued_bytes_ = static_cast<uint32_t> (rc);
+			UpdateBacklog (client);
 		}
 		cumulative_stats_[PROVIDER_PC_RSSL_MSGS_ENQUEUED]++;
 		goto pending;
@@ -2302,14 +2596,14 @@ try_again:
 	case RSSL_RET_BUFFER_NO_BUFFERS:		/* empty buffer pool: spin wait until buffer is available. */
 		cumulative_stats_[PROVIDER_PC_RSSL_WRITE_NO_BUFFERS]++;
 pending:
-		FD_SET (c->socketId, &in_wfds_);	/* pending output */
+		selector_.Set (c->socketId, selector_t::kWritable);	/* pending output */
 		return -1;
 	case RSSL_RET_SUCCESS:				/* sent, no flush required. */
 		cumulative_stats_[PROVIDER_PC_RSSL_MSGS_SENT]++;
 /* Sent data equivalent to a ping. */
 		if (nullptr != c->userSpecPtr) {
 			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-			client->SetNextPing (last_activity_ + boost::posix_time::seconds (client->ping_interval_));
+			client->SetNextPing (last_activity_ + SecondsToTicks (client->ping_interval_));
 		}
 		return 1;
 	default:
@@ -2367,7 +2661,7 @@ pending:
  * automatically.  If this fails then either the client has stalled or the systems is out of 
  * resources.  Suitable consequence is to force a disconnect.
  */
-		FD_SET (c->socketId, &out_efds_);
+		selector_.SetReady (c->socketId, selector_t::kException);
 		LOG(INFO) << "rsslPing: { "
 			  "\"rsslErrorId\": " << rssl_err.rsslErrorId << ""
 			", \"sysError\": " << rssl_err.sysError << ""
@@ -2379,7 +2673,7 @@ pending:
 /* Advance ping expiration only on success. */
 		if (nullptr != c->userSpecPtr) {
 			auto client = reinterpret_cast<client_t*> (c->userSpecPtr);
-			client->SetNextPing (last_activity_ + boost::posix_time::seconds (client->ping_interval_));
+			client->SetNextPing (last_activity_ + SecondsToTicks (client->ping_interval_));
 		}
 		return 1;
 	default:
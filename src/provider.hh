@@ -4,14 +4,13 @@
 #ifndef PROVIDER_HH_
 #define PROVIDER_HH_
 
-#include <winsock2.h>
-
 #include <chrono>
 #include <cstdint>
 #include <memory>
 #include <boost/unordered_map.hpp>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 /* Boost Atomics */
 #include <boost/atomic.hpp>
@@ -35,6 +34,9 @@
 #include "deleter.hh"
 #include "chainy_http_server.hh"
 #include "message_loop.hh"
+#include "monotonic_clock.hh"
+#include "selector.hh"
+#include "timing_wheel.hh"
 
 namespace chainy
 {
@@ -59,6 +61,7 @@ namespace chainy
 		PROVIDER_PC_RSSL_PONG_TIMEOUT,
 		PROVIDER_PC_RSSL_PROTOCOL_DOWNGRADE,
 		PROVIDER_PC_RSSL_FLUSH,
+		PROVIDER_PC_RSSL_BATCHED_FLUSH,
 		PROVIDER_PC_OMM_ACTIVE_CLIENT_SESSION_RECEIVED,
 		PROVIDER_PC_OMM_ACTIVE_CLIENT_SESSION_EXCEPTION,
 		PROVIDER_PC_CLIENT_SESSION_REJECTED,
@@ -68,6 +71,8 @@ namespace chainy
 		PROVIDER_PC_RSSL_SLOW_READER,
 		PROVIDER_PC_RSSL_PACKET_GAP_DETECTED,
 		PROVIDER_PC_RSSL_READ_FAILURE,
+		PROVIDER_PC_RSSL_READ_BATCHES,
+		PROVIDER_PC_RSSL_READ_BUDGET_EXHAUSTED,
 		PROVIDER_PC_CLIENT_INIT_EXCEPTION,
 		PROVIDER_PC_DIRECTORY_MAP_EXCEPTION,
 		PROVIDER_PC_RSSL_PING_EXCEPTION,
@@ -76,6 +81,8 @@ namespace chainy
 		PROVIDER_PC_RSSL_WRITE_EXCEPTION,
 		PROVIDER_PC_RSSL_WRITE_FLUSH_FAILED,
 		PROVIDER_PC_RSSL_WRITE_NO_BUFFERS,
+		PROVIDER_PC_CLIENT_QUEUE_HIGH_WATER,
+		PROVIDER_PC_SLOW_CONSUMER_EVICTED,
 /* marker */
 		PROVIDER_PC_MAX
 	};
@@ -89,12 +96,22 @@ namespace chainy
 	public:
 		virtual bool WatchFileDescriptor (net::SocketDescriptor fd, bool persistent, Mode mode, FileDescriptorWatcher* controller, Watcher* delegate) override;
 
-		explicit provider_t (const config_t& config, std::shared_ptr<upa_t> upa, client_t::Delegate* request_delegate);
+		explicit provider_t (const config_t& config, std::shared_ptr<upa_t> upa, client_t::Delegate* request_delegate, unsigned shard);
 		~provider_t();
 
 		bool Initialize (chromium::MessageLoop* consumer, ChainyHttpServer::ConsumerDelegate* consumer_delegate);
 		void Close();
 
+/* Shard zero accepts every connection and hands each channel to a shard,
+ * including itself.  Set before Run, shards must outlive the acceptor loop.
+ */
+		void SetShards (const std::vector<provider_t*>& shards) {
+			shards_ = shards;
+		}
+		unsigned shard() const {
+			return shard_;
+		}
+
 // MessagePump methods:
 		virtual void Run() override;
 		virtual void Quit() override;
@@ -111,13 +128,8 @@ namespace chainy
 		}
 
 		static bool WriteRawClose (uint16_t rwf_version, int32_t token, uint16_t service_id, uint8_t model_type, const chromium::StringPiece& item_name, bool use_attribinfo_in_updates, uint8_t stream_state, uint8_t status_code, const chromium::StringPiece& status_text, void* data, size_t* length);
-		bool SendReply (RsslChannel*const handle, int32_t token, const void* buf, size_t length) {
-			return SendReply (handle, token, buf, length, false);
-		}
-		bool SendReplyAndClose (RsslChannel*const handle, int32_t token, const void* buf, size_t length) {
-			return SendReply (handle, token, buf, length, true);
-		}
-		bool SendReply (RsslChannel*const handle, int32_t token, const void* buf, size_t length, bool and_close);
+		std::shared_ptr<client_t> GetClient (RsslChannel*const handle);
+		void ScheduleKeepalive (client_t* client);
 
 // ProviderDelegate methods:
 		virtual void CreateInfo(ProviderInfo* info) override;
@@ -138,16 +150,24 @@ namespace chainy
 		}
 
 	private:
+		bool Listen (chromium::MessageLoop* consumer, ChainyHttpServer::ConsumerDelegate* consumer_delegate);
 		bool DoInternalWork();
+		void OnKeepaliveTimers();
+		void FlushPendingWrites();
 
 		void OnConnection (RsslServer* rssl_sock);
 		void RejectConnection (RsslServer* rssl_sock);
 		void AcceptConnection (RsslServer* rssl_sock);
+		provider_t* NextShard();
+		size_t GetConnectionCount() const;
+		void AddConnection (RsslChannel* handle);
 
 		void OnCanReadWithoutBlocking (RsslChannel* handle);
 		void OnCanWriteWithoutBlocking (RsslChannel* handle);
 		void Abort (RsslChannel* handle);
 		void Close (RsslChannel* handle);
+		void UpdateBacklog (client_t* client);
+		void CheckBacklog (RsslChannel* handle, client_t* client);
 
 		void OnInitializingState (RsslChannel* handle);
 		void OnActiveClientSession (RsslChannel* handle);
@@ -155,6 +175,7 @@ namespace chainy
 		bool AcceptClientSession (RsslChannel* handle, const char* address);
 
 		void OnActiveState (RsslChannel* handle);
+		RsslRet OnRead (RsslChannel* handle);
 		void OnMsg (RsslChannel* handle, RsslBuffer* buf);
 
 		bool GetDirectoryMap (RsslEncodeIterator*const it, const char* service_name, uint32_t filter_mask, unsigned map_action);
@@ -176,20 +197,31 @@ namespace chainy
 
 		const config_t& config_;
 
+/* Index of this worker loop, zero for the acceptor. */
+		const unsigned shard_;
+/* Acceptor only: every worker loop by index. */
+		std::vector<provider_t*> shards_;
+/* Connections owned or being handed to this loop, read by the acceptor. */
+		boost::atomic<size_t> connection_count_;
+
 /* UPA context. */
 		std::shared_ptr<upa_t> upa_;
-/* Server socket for new connections */
+/* Acceptor only: server socket for new connections */
 		RsslServer* rssl_sock_;
-/* Built in HTTP server. */
+/* Acceptor only: built in HTTP server. */
 		std::shared_ptr<ChainyHttpServer> server_;
 		std::list<std::weak_ptr<FileDescriptorWatcher>> watch_list_;
 /* This flag is set to false when Run should return. */
 		boost::atomic_bool keep_running_;
 
-		int in_nfds_, out_nfds_;
-		fd_set in_rfds_, in_wfds_, in_efds_;
-		fd_set out_rfds_, out_wfds_, out_efds_;
-		struct timeval in_tv_, out_tv_;
+		selector_t selector_;
+		int out_nfds_;
+		struct timeval in_tv_;
+
+/* Keepalive deadline of every client session of this loop. */
+		timing_wheel_t keepalives_;
+/* Channels aborted since the last exception sweep on timeout. */
+		unsigned pending_aborts_;
 
 // The time at which we should call DoDelayedWork.
 		std::chrono::steady_clock::time_point delayed_work_time_;
@@ -222,7 +254,7 @@ namespace chainy
 		boost::atomic_bool is_pending_directory_update_;
 
 /** Performance Counters **/
-		boost::posix_time::ptime creation_time_, last_activity_;
+		ticks_t creation_time_, last_activity_;
 		uint32_t cumulative_stats_[PROVIDER_PC_MAX];
 		uint32_t snap_stats_[PROVIDER_PC_MAX];
 
@@ -0,0 +1,339 @@
+/* Socket readiness selector for the message pumps.
+ */
+
+#include "selector.hh"
+
+#if !defined(_WIN32)
+#	include <errno.h>
+#	include <stdint.h>
+#	include <unistd.h>
+#endif
+
+#include "chromium/logging.hh"
+
+#if defined(_WIN32)
+
+chainy::selector_t::selector_t()
+{
+	Clear();
+}
+
+chainy::selector_t::~selector_t()
+{
+}
+
+bool
+chainy::selector_t::Open()
+{
+	Clear();
+	return true;
+}
+
+void
+chainy::selector_t::Close()
+{
+	Clear();
+}
+
+void
+chainy::selector_t::Set (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	if (events & kReadable)		FD_SET (fd, &in_rfds_);
+	if (events & kWritable)		FD_SET (fd, &in_wfds_);
+	if (events & kException)	FD_SET (fd, &in_efds_);
+}
+
+void
+chainy::selector_t::Unset (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	if (events & kReadable)		FD_CLR (fd, &in_rfds_);
+	if (events & kWritable)		FD_CLR (fd, &in_wfds_);
+	if (events & kException)	FD_CLR (fd, &in_efds_);
+}
+
+bool
+chainy::selector_t::IsSet (
+	net::SocketDescriptor fd,
+	int events
+	) const
+{
+	return ((events & kReadable) && FD_ISSET (fd, &in_rfds_))
+		|| ((events & kWritable) && FD_ISSET (fd, &in_wfds_))
+		|| ((events & kException) && FD_ISSET (fd, &in_efds_));
+}
+
+void
+chainy::selector_t::Clear()
+{
+	FD_ZERO (&in_rfds_); FD_ZERO (&out_rfds_);
+	FD_ZERO (&in_wfds_); FD_ZERO (&out_wfds_);
+	FD_ZERO (&in_efds_); FD_ZERO (&out_efds_);
+}
+
+/* nfds is ignored by Winsock. */
+int
+chainy::selector_t::Wait (
+	const struct timeval& timeout
+	)
+{
+	struct timeval tv = timeout;
+	out_rfds_ = in_rfds_;
+	out_wfds_ = in_wfds_;
+	out_efds_ = in_efds_;
+	return select (0, &out_rfds_, &out_wfds_, &out_efds_, &tv);
+}
+
+bool
+chainy::selector_t::IsReady (
+	net::SocketDescriptor fd,
+	int events
+	) const
+{
+	return ((events & kReadable) && FD_ISSET (fd, &out_rfds_))
+		|| ((events & kWritable) && FD_ISSET (fd, &out_wfds_))
+		|| ((events & kException) && FD_ISSET (fd, &out_efds_));
+}
+
+void
+chainy::selector_t::ClearReady (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	if (events & kReadable)		FD_CLR (fd, &out_rfds_);
+	if (events & kWritable)		FD_CLR (fd, &out_wfds_);
+	if (events & kException)	FD_CLR (fd, &out_efds_);
+}
+
+void
+chainy::selector_t::SetReady (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	if (events & kReadable)		FD_SET (fd, &out_rfds_);
+	if (events & kWritable)		FD_SET (fd, &out_wfds_);
+	if (events & kException)	FD_SET (fd, &out_efds_);
+}
+
+#else	/* _WIN32 */
+
+namespace {
+
+/* Sized for the provider listen socket, clients, HTTP server and wakeup. */
+static const size_t kMaxEvents = 256;
+
+static
+uint32_t
+ToEpoll (
+	int events
+	)
+{
+	uint32_t epoll_events = 0;
+	if (events & chainy::selector_t::kReadable)	epoll_events |= EPOLLIN;
+	if (events & chainy::selector_t::kWritable)	epoll_events |= EPOLLOUT;
+	if (events & chainy::selector_t::kException)	epoll_events |= EPOLLPRI;
+	return epoll_events;
+}
+
+}  // namespace anon
+
+chainy::selector_t::selector_t()
+	: epoll_fd_ (-1)
+	, events_ (kMaxEvents)
+{
+}
+
+chainy::selector_t::~selector_t()
+{
+	Close();
+}
+
+bool
+chainy::selector_t::Open()
+{
+	DCHECK_EQ(-1, epoll_fd_);
+	epoll_fd_ = epoll_create1 (EPOLL_CLOEXEC);
+	if (-1 == epoll_fd_) {
+		LOG(ERROR) << "epoll_create1 failed, errno: " << errno;
+		return false;
+	}
+	return true;
+}
+
+void
+chainy::selector_t::Close()
+{
+	if (-1 != epoll_fd_) {
+		close (epoll_fd_);
+		epoll_fd_ = -1;
+	}
+	interest_.clear();
+	ready_.clear();
+}
+
+/* Descriptors may be closed underneath the selector, which removes them from
+ * the epoll set, or replaced by RSSL with the same number.  Fall back between
+ * ADD and MOD accordingly and ignore DEL of a descriptor already gone.
+ */
+void
+chainy::selector_t::Update (
+	net::SocketDescriptor fd,
+	int old_events,
+	int new_events
+	)
+{
+	struct epoll_event event;
+	event.events = ToEpoll (new_events);
+	event.data.fd = fd;
+	if (0 == new_events) {
+		epoll_ctl (epoll_fd_, EPOLL_CTL_DEL, fd, &event);
+		return;
+	}
+	int op = (0 == old_events) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+	if (0 == epoll_ctl (epoll_fd_, op, fd, &event))
+		return;
+	if (EPOLL_CTL_MOD == op && ENOENT == errno)
+		op = EPOLL_CTL_ADD;
+	else if (EPOLL_CTL_ADD == op && EEXIST == errno)
+		op = EPOLL_CTL_MOD;
+	else {
+		LOG(ERROR) << "epoll_ctl for fd " << fd << " failed, errno: " << errno;
+		return;
+	}
+	if (-1 == epoll_ctl (epoll_fd_, op, fd, &event))
+		LOG(ERROR) << "epoll_ctl for fd " << fd << " failed, errno: " << errno;
+}
+
+void
+chainy::selector_t::Set (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	int& interest = interest_[fd];
+	const int old_events = interest;
+	interest |= events;
+	if (interest != old_events)
+		Update (fd, old_events, interest);
+}
+
+void
+chainy::selector_t::Unset (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	auto it = interest_.find (fd);
+	if (interest_.end() == it)
+		return;
+	const int old_events = it->second;
+	const int new_events = old_events & ~events;
+	if (0 == new_events)
+		interest_.erase (it);
+	else
+		it->second = new_events;
+	if (new_events != old_events)
+		Update (fd, old_events, new_events);
+}
+
+bool
+chainy::selector_t::IsSet (
+	net::SocketDescriptor fd,
+	int events
+	) const
+{
+	auto it = interest_.find (fd);
+	return interest_.end() != it && 0 != (it->second & events);
+}
+
+void
+chainy::selector_t::Clear()
+{
+	for (const auto& interest : interest_) {
+		struct epoll_event event = {};
+		epoll_ctl (epoll_fd_, EPOLL_CTL_DEL, interest.first, &event);
+	}
+	interest_.clear();
+	ready_.clear();
+}
+
+/* Errors and hang-ups are reported as readable and writable as with select()
+ * so the pending RSSL call surfaces the failure, and as an exception where
+ * requested to match Winsock failed connect semantics.
+ */
+int
+chainy::selector_t::Wait (
+	const struct timeval& timeout
+	)
+{
+	const int timeout_ms = static_cast<int> (timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000);
+	ready_.clear();
+	const int nfds = epoll_wait (epoll_fd_, events_.data(), static_cast<int> (events_.size()), timeout_ms);
+/* signal delivery is a timeout */
+	if (-1 == nfds && EINTR == errno)
+		return 0;
+	if (nfds <= 0) {
+		LOG_IF(ERROR, -1 == nfds) << "epoll_wait failed, errno: " << errno;
+		return nfds;
+	}
+	for (int i = 0; i < nfds; ++i) {
+		const struct epoll_event& event = events_[i];
+		int ready = 0;
+		if (event.events & EPOLLIN)	ready |= kReadable;
+		if (event.events & EPOLLOUT)	ready |= kWritable;
+		if (event.events & EPOLLPRI)	ready |= kException;
+		if (event.events & (EPOLLERR | EPOLLHUP))
+			ready |= kReadable | kWritable | kException;
+		auto it = interest_.find (event.data.fd);
+		if (interest_.end() == it)
+			continue;
+		ready &= it->second;
+		if (0 != ready)
+			ready_[event.data.fd] = ready;
+	}
+	return static_cast<int> (ready_.size());
+}
+
+bool
+chainy::selector_t::IsReady (
+	net::SocketDescriptor fd,
+	int events
+	) const
+{
+	auto it = ready_.find (fd);
+	return ready_.end() != it && 0 != (it->second & events);
+}
+
+void
+chainy::selector_t::ClearReady (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	auto it = ready_.find (fd);
+	if (ready_.end() == it)
+		return;
+	it->second &= ~events;
+	if (0 == it->second)
+		ready_.erase (it);
+}
+
+void
+chainy::selector_t::SetReady (
+	net::SocketDescriptor fd,
+	int events
+	)
+{
+	ready_[fd] |= events;
+}
+
+#endif	/* _WIN32 */
+
+/* eof */
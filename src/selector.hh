@@ -0,0 +1,80 @@
+/* Socket readiness selector for the message pumps.
+ *
+ * Replaces hand maintained fd_set triples with an interest set and a ready
+ * set.  Windows uses select(), Linux uses level-triggered epoll so the cost of
+ * a wait scales with active rather than registered descriptors.  Ready state
+ * may be cleared by a handler once consumed, or raised to force an exception
+ * path on the next pass as with FD_SET on the output sets.
+ */
+
+#ifndef SELECTOR_HH_
+#define SELECTOR_HH_
+
+#if defined(_WIN32)
+#	include <winsock2.h>
+#else
+#	include <sys/epoll.h>
+#	include <sys/time.h>
+#endif
+
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+#include "net/socket/socket_descriptor.hh"
+
+namespace chainy
+{
+
+	class selector_t :
+		boost::noncopyable
+	{
+	public:
+		enum {
+			kReadable	= 0x1,
+			kWritable	= 0x2,
+			kException	= 0x4
+		};
+
+		selector_t();
+		~selector_t();
+
+		bool Open();
+		void Close();
+
+/* Interest set, events are OR'd into and masked out of existing interest. */
+		void Set (net::SocketDescriptor fd, int events);
+		void Unset (net::SocketDescriptor fd, int events);
+		bool IsSet (net::SocketDescriptor fd, int events) const;
+/* Drop all interest and ready state. */
+		void Clear();
+
+/* Returns count of ready descriptors, zero on timeout, or -1 on error. */
+		int Wait (const struct timeval& timeout);
+
+/* Ready set from the last Wait. */
+		bool IsReady (net::SocketDescriptor fd, int events) const;
+		void ClearReady (net::SocketDescriptor fd, int events);
+		void SetReady (net::SocketDescriptor fd, int events);
+
+	private:
+#if defined(_WIN32)
+		fd_set in_rfds_, in_wfds_, in_efds_;
+		fd_set out_rfds_, out_wfds_, out_efds_;
+#else
+		void Update (net::SocketDescriptor fd, int old_events, int new_events);
+
+		int epoll_fd_;
+		std::unordered_map<net::SocketDescriptor, int> interest_;
+		std::unordered_map<net::SocketDescriptor, int> ready_;
+		std::vector<struct epoll_event> events_;
+#endif
+	};
+
+} /* namespace chainy */
+
+#endif /* SELECTOR_HH_ */
+
+/* eof */
@@ -0,0 +1,166 @@
+/* Hierarchical timing wheel for session deadlines of one second resolution.
+ */
+
+#include "timing_wheel.hh"
+
+#include "chromium/logging.hh"
+
+chainy::timing_wheel_t::timer_t::timer_t (
+	void* context
+	)
+	: context_ (context)
+	, deadline_ (0)
+	, prev_ (nullptr)
+	, next_ (nullptr)
+{
+}
+
+chainy::timing_wheel_t::timer_t::~timer_t()
+{
+	Cancel();
+}
+
+void
+chainy::timing_wheel_t::timer_t::Cancel()
+{
+	if (nullptr == next_)
+		return;
+	prev_->next_ = next_;
+	next_->prev_ = prev_;
+	prev_ = next_ = nullptr;
+}
+
+/* Slot heads are sentinels of circular lists. */
+chainy::timing_wheel_t::timing_wheel_t (
+	uint64_t now
+	)
+	: current_ (now)
+{
+	for (size_t i = 0; i < kInnerSlots; ++i)
+		Init (&inner_[i]);
+	for (size_t i = 0; i < kOuterSlots; ++i)
+		Init (&outer_[i]);
+	Init (&due_);
+}
+
+/* Detach remaining timers such that their owners may outlive the wheel. */
+chainy::timing_wheel_t::~timing_wheel_t()
+{
+	auto detach = [](timer_t* head) {
+		while (!IsEmpty (head))
+			head->next_->Cancel();
+		head->prev_ = head->next_ = nullptr;
+	};
+	for (size_t i = 0; i < kInnerSlots; ++i)
+		detach (&inner_[i]);
+	for (size_t i = 0; i < kOuterSlots; ++i)
+		detach (&outer_[i]);
+	detach (&due_);
+}
+
+void
+chainy::timing_wheel_t::Schedule (
+	timer_t* timer,
+	uint64_t deadline
+	)
+{
+	DCHECK (nullptr != timer);
+	if (deadline < current_)
+		deadline = current_;
+	if (timer->is_scheduled()) {
+		if (deadline == timer->deadline_)
+			return;
+		timer->Cancel();
+	}
+	timer->deadline_ = deadline;
+	if (deadline - current_ < kInnerSlots)
+		Link (&inner_[deadline & (kInnerSlots - 1)], timer);
+	else
+		Link (&outer_[(deadline >> kInnerBits) & (kOuterSlots - 1)], timer);
+}
+
+chainy::timing_wheel_t::timer_t*
+chainy::timing_wheel_t::Expire (
+	uint64_t now
+	)
+{
+	while (IsEmpty (&due_)) {
+		if (current_ > now)
+			return nullptr;
+/* Entering a new inner revolution, bring forward the matching outer slot. */
+		if (0 == (current_ & (kInnerSlots - 1)))
+			Cascade (&outer_[(current_ >> kInnerBits) & (kOuterSlots - 1)]);
+		Splice (&inner_[current_ & (kInnerSlots - 1)], &due_);
+		++current_;
+	}
+	timer_t* timer = due_.next_;
+	timer->Cancel();
+	return timer;
+}
+
+void
+chainy::timing_wheel_t::Init (
+	timer_t* head
+	)
+{
+	head->prev_ = head->next_ = head;
+}
+
+bool
+chainy::timing_wheel_t::IsEmpty (
+	const timer_t* head
+	)
+{
+	return head->next_ == head;
+}
+
+void
+chainy::timing_wheel_t::Link (
+	timer_t* head,
+	timer_t* timer
+	)
+{
+	timer->prev_ = head->prev_;
+	timer->next_ = head;
+	head->prev_->next_ = timer;
+	head->prev_ = timer;
+}
+
+/* Move every timer of one list to the tail of another. */
+void
+chainy::timing_wheel_t::Splice (
+	timer_t* from,
+	timer_t* to
+	)
+{
+	if (IsEmpty (from))
+		return;
+	timer_t* first = from->next_;
+	timer_t* last = from->prev_;
+	first->prev_ = to->prev_;
+	to->prev_->next_ = first;
+	last->next_ = to;
+	to->prev_ = last;
+	Init (from);
+}
+
+/* Re-place each timer of an outer slot relative to the current tick, timers
+ * beyond the outer span return to the same slot.
+ */
+void
+chainy::timing_wheel_t::Cascade (
+	timer_t* head
+	)
+{
+	timer_t pending;
+	Init (&pending);
+	Splice (head, &pending);
+	while (!IsEmpty (&pending)) {
+		timer_t* timer = pending.next_;
+		timer->Cancel();
+		Schedule (timer, timer->deadline_);
+	}
+	pending.prev_ = pending.next_ = nullptr;
+}
+
+/* eof */
@@ -0,0 +1,90 @@
+/* Hierarchical timing wheel for session deadlines of one second resolution.
+ *
+ * The inner wheel holds timers due within 256 ticks, one slot per tick, the
+ * outer wheel 64 slots of 256 ticks each.  Timers further out than the outer
+ * wheel rest in the slot of their deadline modulo the span and are placed
+ * again each time the slot is cascaded.  Schedule and cancel are constant
+ * time, expiry visits each elapsed tick once plus the timers actually due.
+ */
+
+#ifndef TIMING_WHEEL_HH_
+#define TIMING_WHEEL_HH_
+
+#include <cstdint>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+namespace chainy
+{
+
+	class timing_wheel_t :
+		boost::noncopyable
+	{
+	public:
+/* Intrusive timer, unlinked from any wheel when destroyed. */
+		class timer_t :
+			boost::noncopyable
+		{
+		public:
+			explicit timer_t (void* context = nullptr);
+			~timer_t();
+
+			void Cancel();
+			bool is_scheduled() const {
+				return nullptr != next_;
+			}
+			uint64_t deadline() const {
+				return deadline_;
+			}
+			void* context() const {
+				return context_;
+			}
+
+		private:
+			void* context_;
+			uint64_t deadline_;
+			timer_t* prev_;
+			timer_t* next_;
+
+			friend timing_wheel_t;
+		};
+
+		explicit timing_wheel_t (uint64_t now);
+		~timing_wheel_t();
+
+/* (Re-)arm a timer, deadlines already passed are due on the next tick. */
+		void Schedule (timer_t* timer, uint64_t deadline);
+/* Returns the next timer due at or before now, or nullptr once none remain.
+ * The returned timer is unlinked and may be scheduled again.
+ */
+		timer_t* Expire (uint64_t now);
+
+	private:
+		enum {
+			kInnerBits	= 8,
+			kInnerSlots	= 1 << kInnerBits,
+			kOuterBits	= 6,
+			kOuterSlots	= 1 << kOuterBits
+		};
+
+		static void Init (timer_t* head);
+		static bool IsEmpty (const timer_t* head);
+		static void Link (timer_t* head, timer_t* timer);
+		static void Splice (timer_t* from, timer_t* to);
+
+		void Cascade (timer_t* head);
+
+/* Next tick to process. */
+		uint64_t current_;
+		timer_t inner_[kInnerSlots];
+		timer_t outer_[kOuterSlots];
+/* Timers of processed ticks not yet returned by Expire. */
+		timer_t due_;
+	};
+
+} /* namespace chainy */
+
+#endif /* TIMING_WHEEL_HH_ */
+
+/* eof */